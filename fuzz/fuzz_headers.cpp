@@ -0,0 +1,552 @@
+/* fuzz_headers.cpp
+ *
+ * Fuzzing and throughput harness for the code that decodes ABF headers:
+ * the read_* functions of deserialize.c, the ABF2 record tables, the
+ * catalog inspector and, when built with ABF_FUZZ_AXON, ABFH_ParamReader
+ * and CABF2ProtocolReader.
+ *
+ * Every input is given to every target. Besides crashes and sanitizer
+ * reports, the targets check properties that must hold for any input:
+ * read_uint32(buf, off) equals the bytes at buf + off, abf2_encode()
+ * inverts abf2_decode(), and a lazily loaded ABF2 header ends up equal
+ * to an eagerly loaded one.
+ *
+ * Built with libFuzzer (clang, -DABF_FUZZ_LIBFUZZER):
+ *
+ *   cc -c -g -O1 -fsanitize=fuzzer-no-link,address -Isrc -Isrc/stream -Isrc/platforms/gcc \
+ *       src/deserialize.c src/swap.c src/abf2_records.c src/abf_catalog.c \
+ *       src/stream/stream.c src/stream/memstream.c src/stream/fdstream.c
+ *   c++ -g -O1 -fsanitize=fuzzer,address -DABF_FUZZ_LIBFUZZER -Isrc -Isrc/stream \
+ *       -Isrc/platforms/gcc fuzz/fuzz_headers.cpp *.o -lpthread -o fuzz_headers
+ *   ./fuzz_headers corpus/
+ *
+ * Built without -DABF_FUZZ_LIBFUZZER, a simple mutator seeded with
+ * generated ABF 1 and ABF 2 headers is used instead:
+ *
+ *   ./fuzz_headers [-n iterations] [-s seed]    fuzz
+ *   ./fuzz_headers -t [-n iterations]           headers per second of each target
+ *   ./fuzz_headers file...                      run saved inputs
+ *
+ * While fuzzing, the current input is kept in fuzz_headers.cur so that
+ * it survives a crash and can be passed back in. Throughput is measured
+ * on unmutated seeds, so results are comparable between builds.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+extern "C" {
+#include "stream.h"
+#include "memstream.h"
+}
+
+#include "deserialize.h"
+#include "swap.h"
+#include "abf2_records.h"
+#include "abf_catalog.h"
+
+#ifdef ABF_FUZZ_AXON
+#include "wincpp.hpp"
+#include "AxAbfFio32/abffiles.h"
+#include "AxAbfFio32/filedesc.hpp"
+#include "ABFFIO/ProtocolReaderABF2.hpp"
+#endif
+
+#define SCRATCH_FILE "fuzz_headers.cur"
+
+/* Largest input the mutator grows to */
+#define MAX_INPUT_SIZE (64 * 1024)
+
+#define FUZZ_CHECK(cond)                                                    \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            abort();                                                        \
+        }                                                                   \
+    } while (0)
+
+/* A target returns true if it accepted the input as a header */
+struct target
+{
+    const char *name;
+    bool (*run)(const uint8_t *data, size_t size);
+};
+
+/* Set once the current input is in the scratch file */
+static bool scratch_current = false;
+
+#ifdef ABF_FUZZ_AXON
+/* For the readers that only take files */
+static bool write_scratch(const uint8_t *data, size_t size)
+{
+    FILE *fp;
+    bool ok;
+
+    if (scratch_current)
+        return true;
+    fp = fopen(SCRATCH_FILE, "wb");
+    if (!fp)
+        return false;
+    ok = fwrite(data, 1, size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    scratch_current = ok;
+    return ok;
+}
+#endif
+
+static bool fuzz_deserialize(const uint8_t *data, size_t size)
+{
+    char *buf = (char *)data;
+    size_t offset;
+
+    for (offset = 0; offset + sizeof(uint64_t) <= size; offset++) {
+        uint16_t u16, v16;
+        uint32_t u32, v32;
+        uint64_t u64, v64;
+
+        memcpy(&u16, data + offset, sizeof(u16));
+        memcpy(&u32, data + offset, sizeof(u32));
+        memcpy(&u64, data + offset, sizeof(u64));
+
+        FUZZ_CHECK(read_uint8(buf, offset) == data[offset]);
+        FUZZ_CHECK(read_uint16(buf, offset, false) == u16);
+        FUZZ_CHECK(read_uint16(buf, offset, true) == _swap16(u16));
+        FUZZ_CHECK(read_uint32(buf, offset, false) == u32);
+        FUZZ_CHECK(read_uint32(buf, offset, true) == _swap32(u32));
+        FUZZ_CHECK(read_uint64(buf, offset, false) == u64);
+        FUZZ_CHECK(read_uint64(buf, offset, true) == _swap64(u64));
+
+        FUZZ_CHECK(read_uint16p(buf + offset, &v16, true) == buf + offset + sizeof(v16));
+        FUZZ_CHECK(v16 == _swap16(u16));
+        FUZZ_CHECK(read_uint32p(buf + offset, &v32, true) == buf + offset + sizeof(v32));
+        FUZZ_CHECK(v32 == _swap32(u32));
+        FUZZ_CHECK(read_uint64p(buf + offset, &v64, true) == buf + offset + sizeof(v64));
+        FUZZ_CHECK(v64 == _swap64(u64));
+    }
+    return size >= sizeof(uint64_t);
+}
+
+static bool fuzz_records(const uint8_t *data, size_t size)
+{
+    static uint64_t decoded[512];
+    static char encoded[4096];
+    const struct abf2_record *const *record;
+    bool accepted = false;
+    int swap;
+
+    for (record = abf2_records; *record; record++) {
+        if ((*record)->file_size > size)
+            continue;
+        FUZZ_CHECK((*record)->struct_size <= sizeof(decoded));
+        FUZZ_CHECK((*record)->file_size <= sizeof(encoded));
+
+        for (swap = 0; swap < 2; swap++) {
+            abf2_decode(*record, (const char *)data, decoded, swap != 0);
+            abf2_encode(*record, decoded, encoded, swap != 0);
+            FUZZ_CHECK(memcmp(encoded, data, (*record)->file_size) == 0);
+        }
+        accepted = true;
+    }
+    return accepted;
+}
+
+static bool fuzz_catalog(const uint8_t *data, size_t size)
+{
+    struct abf_catalog_entry entry;
+    stream_dt *mem;
+    bool accepted;
+
+    if (memstream_createGrowable(size ? size : 1, &mem) != StreamError_Success)
+        return false;
+    stream_write(mem, data, size);
+    stream_seekToStart(mem);
+    accepted = abf_catalog_inspectStream(mem, &entry) == StreamError_Success;
+    if (accepted) {
+        FUZZ_CHECK(entry.protocol_path != NULL);
+        FUZZ_CHECK(entry.format == 1 || entry.format == 2);
+        abf_catalog_entry_free(&entry);
+    }
+    memstream_destroy(mem);
+    return accepted;
+}
+
+#ifdef ABF_FUZZ_AXON
+static bool fuzz_param_reader(const uint8_t *data, size_t size)
+{
+    CFileDescriptor FI;
+    ABFFileHeader FH;
+    int nError = 0;
+
+    if (!write_scratch(data, size) || !FI.Open(SCRATCH_FILE, TRUE))
+        return false;
+    return ABFH_ParamReader(FI.GetFileHandle(), &FH, &nError) != FALSE;
+}
+
+static bool fuzz_abf2_reader(const uint8_t *data, size_t size)
+{
+    ABF_FileInfo Info;
+    if (size < sizeof(Info))
+        return false;
+    memcpy(&Info, data, sizeof(Info));
+    if (!CABF2ProtocolReader::CanOpen(&Info, sizeof(Info)) || !write_scratch(data, size))
+        return false;
+
+    CFileDescriptor FI;
+    if (!FI.Open(SCRATCH_FILE, TRUE))
+        return false;
+
+    ABFFileHeader FH;
+    CABF2ProtocolReader Reader(&FI, &FH);
+    if (!Reader.Read(0))
+        return false;
+
+    /* A lazily loaded header must end up the same once all of it is loaded */
+    ABFFileHeader LazyFH;
+    CABF2ProtocolReader LazyReader(&FI, &LazyFH);
+    if (LazyReader.Read(ABF_LAZYHEADER) &&
+        LazyReader.EnsureLoaded(CABF2ProtocolReader::SECTIONS_ALL))
+        FUZZ_CHECK(memcmp(&FH, &LazyFH, sizeof(FH)) == 0);
+    return true;
+}
+#endif
+
+static const struct target targets[] = {
+    { "deserialize", fuzz_deserialize },
+    { "abf2_records", fuzz_records },
+    { "abf_catalog", fuzz_catalog },
+#ifdef ABF_FUZZ_AXON
+    { "ABFH_ParamReader", fuzz_param_reader },
+    { "CABF2ProtocolReader", fuzz_abf2_reader },
+#endif
+};
+
+#define NUM_TARGETS (sizeof(targets) / sizeof(targets[0]))
+
+/* Gives one input to every target; returns how many accepted it */
+static unsigned run_input(const uint8_t *data, size_t size)
+{
+    unsigned accepted = 0;
+    size_t i;
+
+    scratch_current = false;
+    for (i = 0; i < NUM_TARGETS; i++)
+        accepted += targets[i].run(data, size) ? 1 : 0;
+    return accepted;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    run_input(data, size);
+    return 0;
+}
+
+#ifndef ABF_FUZZ_LIBFUZZER
+
+/* xorshift64* */
+struct rng
+{
+    uint64_t state;
+
+    uint32_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (uint32_t)((state * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+
+    uint32_t below(uint32_t n)
+    {
+        return n ? next() % n : 0;
+    }
+};
+
+/* ABF 2 file: FileInfo, protocol, two ADCs, one DAC and the strings,
+ * one block each */
+static std::vector<uint8_t> make_abf2_seed(bool swap)
+{
+    std::vector<uint8_t> file(6 * ABF2_BLOCKSIZE, 0);
+    struct abf2_fileinfo info;
+    struct abf2_protocolinfo proto;
+    struct abf2_adcinfo adc;
+    struct abf2_dacinfo dac;
+    const char *texts[4] = { "Clampex", "IN 0", "IN 1", "C:\\protocols\\iv.pro" };
+    uint8_t *strings = &file[5 * ABF2_BLOCKSIZE];
+    uint32_t v, total = 0;
+    size_t i, len;
+
+    memset(&info, 0, sizeof(info));
+    memset(&proto, 0, sizeof(proto));
+    memcpy(&info.uFileSignature, "ABF2", 4);
+    if (swap)
+        info.uFileSignature = _swap32(info.uFileSignature);
+    info.uFileVersionNumber = 0x02080000;
+    info.uFileInfoSize = ABF2_BLOCKSIZE;
+    info.uActualEpisodes = 10;
+    info.uFileStartDate = 20240131;
+    info.uFileStartTimeMS = 3723004;
+    info.nDataFormat = 0;
+    info.uCreatorNameIndex = 1;
+    info.uProtocolPathIndex = 4;
+    info.ProtocolSection.uBlockIndex = 1;
+    info.ProtocolSection.uBytes = abf2_protocolinfo_record.file_size;
+    info.ProtocolSection.llNumEntries = 1;
+    info.ADCSection.uBlockIndex = 2;
+    info.ADCSection.uBytes = abf2_adcinfo_record.file_size;
+    info.ADCSection.llNumEntries = 2;
+    info.DACSection.uBlockIndex = 3;
+    info.DACSection.uBytes = abf2_dacinfo_record.file_size;
+    info.DACSection.llNumEntries = 1;
+    info.StringsSection.uBlockIndex = 5;
+    info.StringsSection.uBytes = ABF2_BLOCKSIZE;
+    info.StringsSection.llNumEntries = 4;
+    info.DataSection.uBlockIndex = 6;
+    info.DataSection.uBytes = 2;
+    abf2_encode(&abf2_fileinfo_record, &info, (char *)&file[0], swap);
+
+    proto.nOperationMode = 5;
+    proto.fADCSequenceInterval = 50.0f;
+    proto.lNumSamplesPerEpisode = 2048;
+    proto.lNumberOfTrials = 1;
+    proto.fADCRange = 10.0f;
+    proto.fDACRange = 10.0f;
+    proto.lADCResolution = 32768;
+    proto.lDACResolution = 32768;
+    abf2_encode(&abf2_protocolinfo_record, &proto, (char *)&file[ABF2_BLOCKSIZE], swap);
+
+    for (i = 0; i < 2; i++) {
+        memset(&adc, 0, sizeof(adc));
+        adc.nADCNum = (int16_t)i;
+        adc.nADCPtoLChannelMap = (int16_t)i;
+        adc.nADCSamplingSeq = (int16_t)i;
+        adc.fADCProgrammableGain = 1.0f;
+        adc.fInstrumentScaleFactor = 1.0f;
+        adc.fSignalGain = 1.0f;
+        adc.lADCChannelNameIndex = (int32_t)(i + 2);
+        abf2_encode(&abf2_adcinfo_record, &adc,
+                    (char *)&file[2 * ABF2_BLOCKSIZE + i * abf2_adcinfo_record.file_size], swap);
+    }
+
+    memset(&dac, 0, sizeof(dac));
+    dac.fDACScaleFactor = 1.0f;
+    abf2_encode(&abf2_dacinfo_record, &dac, (char *)&file[3 * ABF2_BLOCKSIZE], swap);
+
+    memcpy(strings, "SSCH", 4);
+    v = 4;
+    memcpy(strings + 8, &v, 4);
+    for (i = 0; i < 4; i++) {
+        len = strlen(texts[i]) + 1;
+        memcpy(strings + 44 + total, texts[i], len);
+        total += (uint32_t)len;
+    }
+    memcpy(strings + 16, &total, 4);
+    return file;
+}
+
+/* ABF 1.83 file with a full 6k header and no data */
+static std::vector<uint8_t> make_abf1_seed(void)
+{
+    std::vector<uint8_t> file(6144, 0);
+    float f;
+    int32_t l;
+    int16_t n;
+
+    memcpy(&file[0], "ABF ", 4);
+    f = 1.83f;      memcpy(&file[4], &f, 4);
+    n = 5;          memcpy(&file[8], &n, 2);        /* nOperationMode */
+    l = 7;          memcpy(&file[16], &l, 4);       /* lActualEpisodes */
+    l = 19990102;   memcpy(&file[20], &l, 4);
+    l = 60;         memcpy(&file[24], &l, 4);
+    n = 4;          memcpy(&file[120], &n, 2);      /* nADCNumChannels */
+    f = 25.0f;      memcpy(&file[122], &f, 4);
+    l = 1024;       memcpy(&file[138], &l, 4);      /* lNumSamplesPerEpisode */
+    f = 10.0f;      memcpy(&file[244], &f, 4);      /* fADCRange */
+    f = 10.0f;      memcpy(&file[248], &f, 4);      /* fDACRange */
+    l = 32768;      memcpy(&file[252], &l, 4);      /* lADCResolution */
+    l = 32768;      memcpy(&file[256], &l, 4);      /* lDACResolution */
+    n = 5;          memcpy(&file[366], &n, 2);
+    memcpy(&file[4898], "C:\\old.pro", 10);
+    return file;
+}
+
+static void mutate(std::vector<uint8_t> &input, struct rng &rng)
+{
+    static const uint32_t interesting[] = {
+        0, 1, 2, 0x7F, 0x80, 0xFF, 0x7FFF, 0x8000, 0xFFFF, 512, 6144,
+        0x7FFFFFFF, 0x80000000, 0xFFFFFFFF
+    };
+    unsigned count = 1 + rng.below(8);
+
+    while (count--) {
+        size_t size = input.size();
+        size_t at = rng.below((uint32_t)(size ? size : 1));
+        uint32_t value;
+
+        switch (rng.below(6)) {
+        case 0:
+            if (size)
+                input[at] ^= (uint8_t)(1u << rng.below(8));
+            break;
+        case 1:
+            if (size)
+                input[at] = (uint8_t)interesting[rng.below(6)];
+            break;
+        case 2:
+            /* Fields are aligned in the packed layouts too, so this hits
+             * counts, offsets and block indices */
+            at &= ~(size_t)3;
+            value = interesting[rng.below(sizeof(interesting) / sizeof(interesting[0]))];
+            if (at + 4 <= size)
+                memcpy(&input[at], &value, 4);
+            break;
+        case 3:
+            if (size > 1) {
+                size_t from = rng.below((uint32_t)size);
+                size_t len = 1 + rng.below(64);
+                if (from + len > size)
+                    len = size - from;
+                if (at + len > size)
+                    len = size - at;
+                memmove(&input[at], &input[from], len);
+            }
+            break;
+        case 4:
+            input.resize(rng.below((uint32_t)size + 1));
+            break;
+        default:
+            if (size < MAX_INPUT_SIZE) {
+                size_t len = 1 + rng.below(1024);
+                while (len--)
+                    input.push_back((uint8_t)rng.next());
+            }
+            break;
+        }
+    }
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t buf[4096];
+    size_t n;
+
+    if (!fp)
+        return false;
+    data.clear();
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data.insert(data.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+static int replay(int argc, char **argv)
+{
+    std::vector<uint8_t> input;
+    int i;
+
+    for (i = 0; i < argc; i++) {
+        if (!read_file(argv[i], input)) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        printf("%s: accepted by %u of %u targets\n", argv[i],
+               run_input(input.data(), input.size()), (unsigned)NUM_TARGETS);
+    }
+    return 0;
+}
+
+static int fuzz(const std::vector<std::vector<uint8_t> > &seeds, unsigned long iterations,
+                uint64_t seed)
+{
+    std::vector<std::vector<uint8_t> > corpus(seeds);
+    struct rng rng = { seed ? seed : 1 };
+    unsigned long i, accepted = 0;
+    FILE *fp;
+
+    for (i = 0; i < iterations; i++) {
+        std::vector<uint8_t> input(corpus[rng.below((uint32_t)corpus.size())]);
+        mutate(input, rng);
+
+        /* Keep the input where a crash leaves it */
+        fp = fopen(SCRATCH_FILE, "wb");
+        if (fp) {
+            fwrite(input.data(), 1, input.size(), fp);
+            fclose(fp);
+        }
+
+        if (run_input(input.data(), input.size()) == NUM_TARGETS) {
+            accepted++;
+            if (corpus.size() < 256)
+                corpus.push_back(input);
+            else
+                corpus[seeds.size() + rng.below(256 - (uint32_t)seeds.size())] = input;
+        }
+        if ((i + 1) % 10000 == 0)
+            printf("%lu inputs, %lu accepted by all targets\n", i + 1, accepted);
+    }
+    printf("done: %lu inputs, %lu accepted by all targets, seed %llu\n",
+           iterations, accepted, (unsigned long long)seed);
+    remove(SCRATCH_FILE);
+    return 0;
+}
+
+static int throughput(const std::vector<std::vector<uint8_t> > &seeds, unsigned long iterations)
+{
+    size_t t, s;
+    unsigned long i;
+
+    for (t = 0; t < NUM_TARGETS; t++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double seconds;
+
+        for (s = 0; s < seeds.size(); s++) {
+            scratch_current = false;
+            for (i = 0; i < iterations; i++)
+                targets[t].run(seeds[s].data(), seeds[s].size());
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-20s %12.0f headers/s\n", targets[t].name,
+               seconds > 0 ? (double)(iterations * seeds.size()) / seconds : 0.0);
+    }
+    remove(SCRATCH_FILE);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::vector<uint8_t> > seeds;
+    unsigned long iterations = 0;
+    uint64_t seed = 1;
+    bool timing = false;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-t"))
+            timing = true;
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            iterations = strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 0);
+        else {
+            fprintf(stderr, "usage: %s [-t] [-n iterations] [-s seed] [file...]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (i < argc)
+        return replay(argc - i, argv + i);
+
+    seeds.push_back(make_abf2_seed(false));
+    seeds.push_back(make_abf2_seed(true));
+    seeds.push_back(make_abf1_seed());
+
+    if (timing)
+        return throughput(seeds, iterations ? iterations : 10000);
+    return fuzz(seeds, iterations ? iterations : 100000, seed);
+}
+
+#endif
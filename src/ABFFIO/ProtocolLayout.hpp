@@ -0,0 +1,57 @@
+//***********************************************************************************************
+//
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+//
+// MODULE:     ProtocolLayout.hpp
+// PURPOSE:    Compile-time layouts for the packed structs in ProtocolStructs.h.
+//
+// These structs are declared with 1-byte packing, so their in-memory layout must be the file
+// layout; that is checked here member by member, which replaces the size checks that the
+// STATIC_ASSERTs in ProtocolStructs.h only perform on some platforms.
+//
+
+#ifndef INC_PROTOCOLLAYOUT_HPP
+#define INC_PROTOCOLLAYOUT_HPP
+
+#pragma once
+
+#include "ProtocolStructs.h"
+#include "StructLayout.hpp"
+
+ABF_DEFINE_LAYOUT(GUID,                 16, ABF2_GUID_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_Section,          16, ABF2_SECTION_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_FileInfo,        512, ABF2_FILEINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_ProtocolInfo,    512, ABF2_PROTOCOLINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_MathInfo,        128, ABF2_MATHINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_ADCInfo,         128, ABF2_ADCINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_DACInfo,         256, ABF2_DACINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_EpochInfoPerDAC,  48, ABF2_EPOCHINFOPERDAC_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_EpochInfo,        32, ABF2_EPOCHINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_StatsRegionInfo, 128, ABF2_STATSREGIONINFO_FIELDS);
+ABF_DEFINE_LAYOUT(ABF_UserListInfo,     64, ABF2_USERLISTINFO_FIELDS);
+
+// Packed structs: every member must sit at its file offset, and the struct be exactly the
+// record size.
+#define ABF_CHECK_PACKED_FIELD(S, member, offset) \
+   static_assert(offsetof(S, member) == offset, #S "::" #member " is not at its file offset");
+#define ABF_CHECK_PACKED(S, FIELDS) \
+   FIELDS(ABF_CHECK_PACKED_FIELD, S) \
+   static_assert(sizeof(S) == ABFLayoutOf<S>::packed_size, "sizeof(" #S ") is not its record size")
+
+ABF_CHECK_PACKED(ABF_Section,         ABF2_SECTION_FIELDS);
+ABF_CHECK_PACKED(ABF_FileInfo,        ABF2_FILEINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_ProtocolInfo,    ABF2_PROTOCOLINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_MathInfo,        ABF2_MATHINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_ADCInfo,         ABF2_ADCINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_DACInfo,         ABF2_DACINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_EpochInfoPerDAC, ABF2_EPOCHINFOPERDAC_FIELDS);
+ABF_CHECK_PACKED(ABF_EpochInfo,       ABF2_EPOCHINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_StatsRegionInfo, ABF2_STATSREGIONINFO_FIELDS);
+ABF_CHECK_PACKED(ABF_UserListInfo,    ABF2_USERLISTINFO_FIELDS);
+
+#undef ABF_CHECK_PACKED
+#undef ABF_CHECK_PACKED_FIELD
+
+#endif   // INC_PROTOCOLLAYOUT_HPP
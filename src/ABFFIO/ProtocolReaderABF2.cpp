@@ -35,6 +35,25 @@ static BOOL FlattenGearShift(ABFFileHeader *pFH)
 }
 
 
+//===============================================================================================
+// FUNCTION: ScaleStatsRegions
+// PURPOSE:  Rescales the statistics search regions to a new number of interleaved channels.
+//
+static void ScaleStatsRegions( ABFFileHeader *pFH, short nNewChans, short nOldChans )
+{
+   WPTRASSERT( pFH );
+
+   pFH->lStatsBaselineStart = MulDiv( pFH->lStatsBaselineStart, nNewChans, nOldChans );
+   pFH->lStatsBaselineEnd   = MulDiv( pFH->lStatsBaselineEnd, nNewChans, nOldChans );
+   
+   for( UINT i=0; i<ABF_STATS_REGIONS; i++ )
+   {
+      pFH->lStatsStart[i] = MulDiv( pFH->lStatsStart[i], nNewChans, nOldChans );
+      pFH->lStatsEnd[i]   = MulDiv( pFH->lStatsEnd[i], nNewChans, nOldChans );
+   }
+}
+
+
 //===============================================================================================
 // FUNCTION: RemoveExtraChannels
 // PURPOSE:  Removes "extra" channels when P/N is enabled and files are opened as protocols.
@@ -94,14 +113,7 @@ static BOOL RemoveExtraChannels( ABFFileHeader *pFH, UINT uFlags )
    pFH->lNumSamplesPerEpisode = MulDiv( pFH->lNumSamplesPerEpisode, nNewChans, nOldChans );
 
    // Adjust the statistics search regions.
-   pFH->lStatsBaselineStart = MulDiv( pFH->lStatsBaselineStart, nNewChans, nOldChans );
-   pFH->lStatsBaselineEnd   = MulDiv( pFH->lStatsBaselineEnd, nNewChans, nOldChans );
-   
-   for( UINT i=0; i<ABF_STATS_REGIONS; i++ )
-   {
-      pFH->lStatsStart[i] = MulDiv( pFH->lStatsStart[i], nNewChans, nOldChans );
-      pFH->lStatsEnd[i]   = MulDiv( pFH->lStatsEnd[i], nNewChans, nOldChans );
-   }
+   ScaleStatsRegions( pFH, nNewChans, nOldChans );
 
    return TRUE;
 }
@@ -119,6 +131,8 @@ CABF2ProtocolReader::CABF2ProtocolReader( CFileDescriptor *pFI, ABFFileHeader *p
 : CProtocolReader( pFI, pFH )
 {
    MEMBERASSERT();
+   m_uLoaded   = 0;
+   m_nOldChans = 0;
 
 }
 
@@ -136,12 +150,17 @@ CABF2ProtocolReader::~CABF2ProtocolReader()
 //===============================================================================================
 // FUNCTION: Read
 // PURPOSE:  Reads the complete protocol from the data file.
+// NOTES:    With ABF_LAZYHEADER only the sections needed to read samples are decoded. The
+//           header fields of the other sections keep their defaults until EnsureLoaded()
+//           is called for them; nothing else loads them.
 //
 BOOL CABF2ProtocolReader::Read( UINT fFlags )
 {
    MEMBERASSERT();
 
    BOOL bOK = TRUE;
+   m_uLoaded   = 0;
+   m_nOldChans = 0;
    bOK &= m_pFI->Seek( 0L, FILE_BEGIN);
    if( !bOK )
       return FALSE;
@@ -157,20 +176,67 @@ BOOL CABF2ProtocolReader::Read( UINT fFlags )
    }
 
    bOK &= ReadFileInfo();
-   bOK &= ReadProtocolInfo();
-   bOK &= ReadADCInfo();
-   bOK &= ReadDACInfo();
-   bOK &= ReadEpochs();
-   bOK &= ReadStats();
-   bOK &= ReadUserList();
-   bOK &= ReadMathInfo();
-
-   RemoveExtraChannels( m_pFH, fFlags );
+   bOK &= ReadSections( (fFlags & ABF_LAZYHEADER) ? SECTIONS_SAMPLING : SECTIONS_ALL );
+
+   // Whether a P/N channel is stripped depends on the DAC settings, so
+   // these are needed up front for the only layout where it can happen.
+   if( (m_pFH->nOperationMode == ABF_WAVEFORMFILE) && (m_pFH->nADCNumChannels == 2) )
+      bOK &= ReadSections( SECTION_DAC );
+
+   short nOldChans = m_pFH->nADCNumChannels;
+   if( RemoveExtraChannels( m_pFH, fFlags ) )
+      m_nOldChans = nOldChans;
    FlattenGearShift( m_pFH );
 
    return bOK;
 }
 
+//===============================================================================================
+// FUNCTION: ReadSections
+// PURPOSE:  Decodes the requested sections that have not been decoded yet.
+//
+BOOL CABF2ProtocolReader::ReadSections( UINT uSections )
+{
+   MEMBERASSERT();
+
+   BOOL bOK = TRUE;
+   uSections &= ~m_uLoaded;
+
+   if( uSections & SECTION_PROTOCOL )
+      bOK &= ReadProtocolInfo();
+   if( uSections & SECTION_ADC )
+      bOK &= ReadADCInfo();
+   if( uSections & SECTION_DAC )
+      bOK &= ReadDACInfo();
+   if( uSections & SECTION_EPOCHS )
+      bOK &= ReadEpochs();
+   if( uSections & SECTION_STATS )
+   {
+      bOK &= ReadStats();
+
+      // Regions decoded after a channel was stripped still count the old channels.
+      if( m_nOldChans )
+         ScaleStatsRegions( m_pFH, m_pFH->nADCNumChannels, m_nOldChans );
+   }
+   if( uSections & SECTION_USERLIST )
+      bOK &= ReadUserList();
+   if( uSections & SECTION_MATH )
+      bOK &= ReadMathInfo();
+
+   m_uLoaded |= uSections;
+   return bOK;
+}
+
+//===============================================================================================
+// FUNCTION: EnsureLoaded
+// PURPOSE:  Makes sure the given sections (eSection bits) have been decoded into the header.
+//
+BOOL CABF2ProtocolReader::EnsureLoaded( UINT uSections )
+{
+   MEMBERASSERT();
+   return ReadSections( uSections );
+}
+
 //===============================================================================================
 // FUNCTION: GetString
 // PURPOSE:  Read a single ProtocolString into the buffer.
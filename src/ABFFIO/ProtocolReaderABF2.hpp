@@ -15,12 +15,39 @@
 #include "ProtocolStructs.h"            // Struct definitions for actual file contents
 #include "AxAbfFio32/filedesc.hpp"
 
+// Flag for CABF2ProtocolReader::Read only; ABF_ReadOpen does not accept it. It is kept clear
+// of the ABF_ReadOpen flags, which Read() is also passed.
+#define ABF_LAZYHEADER        0x8000   // Decode only the sections needed to read samples;
+                                       // the rest are left at their defaults in the header
+                                       // until EnsureLoaded() is called for them.
+
 //===============================================================================================
 class CABF2ProtocolReader
 {
+public:
+   // Sections of the protocol that EnsureLoaded() decodes into the header after an
+   // ABF_LAZYHEADER read.
+   enum eSection
+   {
+      SECTION_PROTOCOL = 0x0001,
+      SECTION_ADC      = 0x0002,
+      SECTION_DAC      = 0x0004,
+      SECTION_EPOCHS   = 0x0008,
+      SECTION_STATS    = 0x0010,
+      SECTION_USERLIST = 0x0020,
+      SECTION_MATH     = 0x0040,
+
+      // What is needed to read and scale samples: channel count and
+      // sequence, sampling interval, episode layout and ADC scaling.
+      SECTIONS_SAMPLING = SECTION_PROTOCOL | SECTION_ADC,
+      SECTIONS_ALL      = 0x007F
+   };
+
 private:
    ABF_FileInfo         m_FileInfo;
    CSimpleStringCache   m_Strings;  // The string writing object.
+   UINT                 m_uLoaded;  // eSection bits already decoded into m_pFH.
+   short                m_nOldChans;   // Channel count before RemoveExtraChannels, 0 if none removed.
 
 
 private:
@@ -32,6 +59,7 @@ private:
    BOOL ReadStats();
    BOOL ReadUserList();
    BOOL ReadMathInfo();
+   BOOL ReadSections( UINT uSections );
 
    BOOL GetString( UINT uIndex, LPSTR pszText, UINT uBufSize );
 
@@ -42,6 +70,8 @@ public:
    static BOOL CanOpen( const void *pFirstBlock, UINT uBytes );
    
    virtual BOOL Read( UINT fFlags );
+   virtual BOOL EnsureLoaded( UINT uSections );
+   virtual BOOL IsLoaded( UINT uSections ) const       { return (m_uLoaded & uSections) == uSections; }
    virtual const ABF_FileInfo *GetFileInfo() const      { return &m_FileInfo; }
    virtual BOOL ValidateCRC();
 };
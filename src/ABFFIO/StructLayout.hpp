@@ -0,0 +1,494 @@
+//***********************************************************************************************
+//
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+//
+// MODULE:     StructLayout.hpp
+// PURPOSE:    Compile-time descriptions of the packed ABF2 records, and decode/encode functions
+//             generated from them.
+//
+// Each record is described once, below, as a list of (member, packed offset) pairs. The lists
+// are instantiated for a concrete struct type with ABF_DEFINE_LAYOUT, which checks at compile
+// time that the fields tile the packed record exactly. ABFLayoutOf<S>::Decode and ::Encode then
+// convert a whole record between the file bytes and S as a sequence of inline memcpys, with the
+// byte-swapping for each field chosen from its type at compile time; nothing is dispatched at
+// run time except the choice between the swapping and non-swapping instantiation.
+//
+// Members whose type has a layout of its own (GUIDs and sections) are decoded recursively.
+// This header only needs the record structs to be complete at the point of ABF_DEFINE_LAYOUT;
+// ProtocolLayout.hpp and abf2_layout.hpp instantiate it for ProtocolStructs.h and
+// abf2_struct.h respectively.
+//
+
+#ifndef INC_STRUCTLAYOUT_HPP
+#define INC_STRUCTLAYOUT_HPP
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+
+//===============================================================================================
+// Byte-swapping of a single scalar, selected by size.
+//
+template <size_t N> struct ABFSwapper;
+
+template <> struct ABFSwapper<1>
+{
+   template <typename T> static void Swap(T &) {}
+};
+
+template <> struct ABFSwapper<2>
+{
+   template <typename T> static void Swap(T &v)
+   {
+      uint16_t u;
+      memcpy(&u, &v, 2);
+      u = uint16_t((u << 8) | (u >> 8));
+      memcpy(&v, &u, 2);
+   }
+};
+
+template <> struct ABFSwapper<4>
+{
+   template <typename T> static void Swap(T &v)
+   {
+      uint32_t u;
+      memcpy(&u, &v, 4);
+      u = (u << 24) | ((u << 8) & 0x00FF0000UL) | ((u >> 8) & 0x0000FF00UL) | (u >> 24);
+      memcpy(&v, &u, 4);
+   }
+};
+
+template <> struct ABFSwapper<8>
+{
+   template <typename T> static void Swap(T &v)
+   {
+      uint32_t u[2], w[2];
+      memcpy(u, &v, 8);
+      w[0] = u[1];
+      w[1] = u[0];
+      ABFSwapper<4>::Swap(w[0]);
+      ABFSwapper<4>::Swap(w[1]);
+      memcpy(&v, w, 8);
+   }
+};
+
+//===============================================================================================
+// ABFLayoutOf<S> is specialized by ABF_DEFINE_LAYOUT for every described struct. The primary
+// template marks everything else as a plain value.
+//
+template <class S> struct ABFLayoutOf
+{
+   static constexpr bool defined = false;
+};
+
+// Packed size of a member: its record size if it has a layout, else its object size.
+template <typename T, bool = ABFLayoutOf<T>::defined> struct ABFPackedSize
+{
+   static constexpr size_t value = sizeof(T);
+};
+
+template <typename T> struct ABFPackedSize<T, true>
+{
+   static constexpr size_t value = ABFLayoutOf<T>::packed_size;
+};
+
+template <typename T, size_t N> struct ABFPackedSize<T[N], false>
+{
+   static constexpr size_t value = N * ABFPackedSize<T>::value;
+};
+
+//===============================================================================================
+// Conversion of one member between its packed bytes and its in-memory value.
+//
+template <typename T, bool = ABFLayoutOf<T>::defined> struct ABFValue
+{
+   template <bool Swap> static void Decode(const char *pBuf, T &v)
+   {
+      memcpy(&v, pBuf, sizeof(T));
+      if (Swap)
+         ABFSwapper<sizeof(T)>::Swap(v);
+   }
+   template <bool Swap> static void Encode(const T &v, char *pBuf)
+   {
+      T u = v;
+      if (Swap)
+         ABFSwapper<sizeof(T)>::Swap(u);
+      memcpy(pBuf, &u, sizeof(T));
+   }
+};
+
+template <typename T> struct ABFValue<T, true>
+{
+   template <bool Swap> static void Decode(const char *pBuf, T &v)
+   {
+      ABFLayoutOf<T>::template DecodeT<Swap>(pBuf, v);
+   }
+   template <bool Swap> static void Encode(const T &v, char *pBuf)
+   {
+      ABFLayoutOf<T>::template EncodeT<Swap>(v, pBuf);
+   }
+};
+
+template <typename T, size_t N> struct ABFValue<T[N], false>
+{
+   template <bool Swap> static void Decode(const char *pBuf, T (&a)[N])
+   {
+      for (size_t i = 0; i < N; i++)
+         ABFValue<T>::template Decode<Swap>(pBuf + i * ABFPackedSize<T>::value, a[i]);
+   }
+   template <bool Swap> static void Encode(const T (&a)[N], char *pBuf)
+   {
+      for (size_t i = 0; i < N; i++)
+         ABFValue<T>::template Encode<Swap>(a[i], pBuf + i * ABFPackedSize<T>::value);
+   }
+};
+
+//===============================================================================================
+// One member of S, stored at a fixed offset in the packed record.
+//
+template <class S, typename T, T S::*Member, size_t Offset> struct ABFField
+{
+   static constexpr size_t offset = Offset;
+   static constexpr size_t size   = ABFPackedSize<T>::value;
+
+   template <bool Swap> static void Decode(const char *pBuf, S &s)
+   {
+      ABFValue<T>::template Decode<Swap>(pBuf + Offset, s.*Member);
+   }
+   template <bool Swap> static void Encode(const S &s, char *pBuf)
+   {
+      ABFValue<T>::template Encode<Swap>(s.*Member, pBuf + Offset);
+   }
+};
+
+// True if Fields start at Offset, follow each other without gaps, and end at End.
+template <size_t Offset, size_t End, class... Fields> struct ABFFieldsTile
+{
+   static constexpr bool value = (Offset == End);
+};
+
+template <size_t Offset, size_t End, class F, class... Rest> struct ABFFieldsTile<Offset, End, F, Rest...>
+{
+   static constexpr bool value = F::offset == Offset
+                                 && ABFFieldsTile<Offset + F::size, End, Rest...>::value;
+};
+
+//===============================================================================================
+// A whole record: the fields of S, packed into Size bytes.
+//
+template <class S, size_t Size, class... Fields> struct ABFRecordLayout
+{
+   static constexpr bool   defined     = true;
+   static constexpr size_t packed_size = Size;
+   static constexpr size_t field_count = sizeof...(Fields);
+   static constexpr bool   tiles       = ABFFieldsTile<0, Size, Fields...>::value;
+
+   template <bool Swap> static void DecodeT(const char *pBuf, S &s)
+   {
+      int expand[] = { 0, (Fields::template Decode<Swap>(pBuf, s), 0)... };
+      (void)expand;
+   }
+   template <bool Swap> static void EncodeT(const S &s, char *pBuf)
+   {
+      int expand[] = { 0, (Fields::template Encode<Swap>(s, pBuf), 0)... };
+      (void)expand;
+   }
+
+   // Fill s from the packed_size bytes at pBuf, byte-swapping if bSwap.
+   static void Decode(const void *pBuf, S &s, bool bSwap)
+   {
+      if (bSwap)
+         DecodeT<true>(static_cast<const char *>(pBuf), s);
+      else
+         DecodeT<false>(static_cast<const char *>(pBuf), s);
+   }
+   // Write s to the packed_size bytes at pBuf, byte-swapping if bSwap.
+   static void Encode(const S &s, void *pBuf, bool bSwap)
+   {
+      if (bSwap)
+         EncodeT<true>(s, static_cast<char *>(pBuf));
+      else
+         EncodeT<false>(s, static_cast<char *>(pBuf));
+   }
+};
+
+#define ABF_LAYOUT_FIELD(S, member, offset) \
+   , ABFField<S, decltype(S::member), &S::member, offset>
+
+// Describe struct S with the field list FIELDS (one of the ABF2_*_FIELDS below).
+#define ABF_DEFINE_LAYOUT(S, SIZE, FIELDS)                                             \
+   template <> struct ABFLayoutOf<S>                                                 \
+      : ABFRecordLayout<S, SIZE FIELDS(ABF_LAYOUT_FIELD, S)> {};                     \
+   static_assert(ABFLayoutOf<S>::tiles, #S ": fields do not tile the packed record")
+
+//===============================================================================================
+// Field lists: member name and packed offset, as in abf2struct_packedsizes.txt.
+//
+
+#define ABF2_GUID_FIELDS(F, S) \
+   F(S, Data1,   0) \
+   F(S, Data2,   4) \
+   F(S, Data3,   6) \
+   F(S, Data4,   8)
+
+#define ABF2_SECTION_FIELDS(F, S) \
+   F(S, uBlockIndex,    0) \
+   F(S, uBytes,         4) \
+   F(S, llNumEntries,   8)
+
+#define ABF2_FILEINFO_FIELDS(F, S) \
+   F(S, uFileSignature,       0) \
+   F(S, uFileVersionNumber,   4) \
+   F(S, uFileInfoSize,        8) \
+   F(S, uActualEpisodes,     12) \
+   F(S, uFileStartDate,      16) \
+   F(S, uFileStartTimeMS,    20) \
+   F(S, uStopwatchTime,      24) \
+   F(S, nFileType,           28) \
+   F(S, nDataFormat,         30) \
+   F(S, nSimultaneousScan,   32) \
+   F(S, nCRCEnable,          34) \
+   F(S, uFileCRC,            36) \
+   F(S, FileGUID,            40) \
+   F(S, uCreatorVersion,     56) \
+   F(S, uCreatorNameIndex,   60) \
+   F(S, uModifierVersion,    64) \
+   F(S, uModifierNameIndex,  68) \
+   F(S, uProtocolPathIndex,  72) \
+   F(S, ProtocolSection,     76) \
+   F(S, ADCSection,          92) \
+   F(S, DACSection,         108) \
+   F(S, EpochSection,       124) \
+   F(S, ADCPerDACSection,   140) \
+   F(S, EpochPerDACSection, 156) \
+   F(S, UserListSection,    172) \
+   F(S, StatsRegionSection, 188) \
+   F(S, MathSection,        204) \
+   F(S, StringsSection,     220) \
+   F(S, DataSection,        236) \
+   F(S, TagSection,         252) \
+   F(S, ScopeSection,       268) \
+   F(S, DeltaSection,       284) \
+   F(S, VoiceTagSection,    300) \
+   F(S, SynchArraySection,  316) \
+   F(S, AnnotationSection,  332) \
+   F(S, StatsSection,       348) \
+   F(S, sUnused,            364)
+
+#define ABF2_PROTOCOLINFO_FIELDS(F, S) \
+   F(S, nOperationMode,                 0) \
+   F(S, fADCSequenceInterval,           2) \
+   F(S, bEnableFileCompression,         6) \
+   F(S, sUnused1,                       7) \
+   F(S, uFileCompressionRatio,         10) \
+   F(S, fSynchTimeUnit,                14) \
+   F(S, fSecondsPerRun,                18) \
+   F(S, lNumSamplesPerEpisode,         22) \
+   F(S, lPreTriggerSamples,            26) \
+   F(S, lEpisodesPerRun,               30) \
+   F(S, lRunsPerTrial,                 34) \
+   F(S, lNumberOfTrials,               38) \
+   F(S, nAveragingMode,                42) \
+   F(S, nUndoRunCount,                 44) \
+   F(S, nFirstEpisodeInRun,            46) \
+   F(S, fTriggerThreshold,             48) \
+   F(S, nTriggerSource,                52) \
+   F(S, nTriggerAction,                54) \
+   F(S, nTriggerPolarity,              56) \
+   F(S, fScopeOutputInterval,          58) \
+   F(S, fEpisodeStartToStart,          62) \
+   F(S, fRunStartToStart,              66) \
+   F(S, lAverageCount,                 70) \
+   F(S, fTrialStartToStart,            74) \
+   F(S, nAutoTriggerStrategy,          78) \
+   F(S, fFirstRunDelayS,               80) \
+   F(S, nChannelStatsStrategy,         84) \
+   F(S, lSamplesPerTrace,              86) \
+   F(S, lStartDisplayNum,              90) \
+   F(S, lFinishDisplayNum,             94) \
+   F(S, nShowPNRawData,                98) \
+   F(S, fStatisticsPeriod,            100) \
+   F(S, lStatisticsMeasurements,      104) \
+   F(S, nStatisticsSaveStrategy,      108) \
+   F(S, fADCRange,                    110) \
+   F(S, fDACRange,                    114) \
+   F(S, lADCResolution,               118) \
+   F(S, lDACResolution,               122) \
+   F(S, nExperimentType,              126) \
+   F(S, nManualInfoStrategy,          128) \
+   F(S, nCommentsEnable,              130) \
+   F(S, lFileCommentIndex,            132) \
+   F(S, nAutoAnalyseEnable,           136) \
+   F(S, nSignalType,                  138) \
+   F(S, nDigitalEnable,               140) \
+   F(S, nActiveDACChannel,            142) \
+   F(S, nDigitalHolding,              144) \
+   F(S, nDigitalInterEpisode,         146) \
+   F(S, nDigitalDACChannel,           148) \
+   F(S, nDigitalTrainActiveLogic,     150) \
+   F(S, nStatsEnable,                 152) \
+   F(S, nStatisticsClearStrategy,     154) \
+   F(S, nLevelHysteresis,             156) \
+   F(S, lTimeHysteresis,              158) \
+   F(S, nAllowExternalTags,           162) \
+   F(S, nAverageAlgorithm,            164) \
+   F(S, fAverageWeighting,            166) \
+   F(S, nUndoPromptStrategy,          170) \
+   F(S, nTrialTriggerSource,          172) \
+   F(S, nStatisticsDisplayStrategy,   174) \
+   F(S, nExternalTagType,             176) \
+   F(S, nScopeTriggerOut,             178) \
+   F(S, nLTPType,                     180) \
+   F(S, nAlternateDACOutputState,     182) \
+   F(S, nAlternateDigitalOutputState, 184) \
+   F(S, fCellID,                      186) \
+   F(S, nDigitizerADCs,               198) \
+   F(S, nDigitizerDACs,               200) \
+   F(S, nDigitizerTotalDigitalOuts,   202) \
+   F(S, nDigitizerSynchDigitalOuts,   204) \
+   F(S, nDigitizerType,               206) \
+   F(S, sUnused,                      208)
+
+#define ABF2_MATHINFO_FIELDS(F, S) \
+   F(S, nMathEnable,          0) \
+   F(S, nMathExpression,      2) \
+   F(S, uMathOperatorIndex,   4) \
+   F(S, uMathUnitsIndex,      8) \
+   F(S, fMathUpperLimit,     12) \
+   F(S, fMathLowerLimit,     16) \
+   F(S, nMathADCNum,         20) \
+   F(S, sUnused,             24) \
+   F(S, fMathK,              40) \
+   F(S, sUnused2,            64)
+
+#define ABF2_ADCINFO_FIELDS(F, S) \
+   F(S, nADCNum,                         0) \
+   F(S, nTelegraphEnable,                2) \
+   F(S, nTelegraphInstrument,            4) \
+   F(S, fTelegraphAdditGain,             6) \
+   F(S, fTelegraphFilter,               10) \
+   F(S, fTelegraphMembraneCap,          14) \
+   F(S, nTelegraphMode,                 18) \
+   F(S, fTelegraphAccessResistance,     20) \
+   F(S, nADCPtoLChannelMap,             24) \
+   F(S, nADCSamplingSeq,                26) \
+   F(S, fADCProgrammableGain,           28) \
+   F(S, fADCDisplayAmplification,       32) \
+   F(S, fADCDisplayOffset,              36) \
+   F(S, fInstrumentScaleFactor,         40) \
+   F(S, fInstrumentOffset,              44) \
+   F(S, fSignalGain,                    48) \
+   F(S, fSignalOffset,                  52) \
+   F(S, fSignalLowpassFilter,           56) \
+   F(S, fSignalHighpassFilter,          60) \
+   F(S, nLowpassFilterType,             64) \
+   F(S, nHighpassFilterType,            65) \
+   F(S, fPostProcessLowpassFilter,      66) \
+   F(S, nPostProcessLowpassFilterType,  70) \
+   F(S, bEnabledDuringPN,               71) \
+   F(S, nStatsChannelPolarity,          72) \
+   F(S, lADCChannelNameIndex,           74) \
+   F(S, lADCUnitsIndex,                 78) \
+   F(S, sUnused,                        82)
+
+#define ABF2_DACINFO_FIELDS(F, S) \
+   F(S, nDACNum,                          0) \
+   F(S, nTelegraphDACScaleFactorEnable,   2) \
+   F(S, fInstrumentHoldingLevel,          4) \
+   F(S, fDACScaleFactor,                  8) \
+   F(S, fDACHoldingLevel,                12) \
+   F(S, fDACCalibrationFactor,           16) \
+   F(S, fDACCalibrationOffset,           20) \
+   F(S, lDACChannelNameIndex,            24) \
+   F(S, lDACChannelUnitsIndex,           28) \
+   F(S, lDACFilePtr,                     32) \
+   F(S, lDACFileNumEpisodes,             36) \
+   F(S, nWaveformEnable,                 40) \
+   F(S, nWaveformSource,                 42) \
+   F(S, nInterEpisodeLevel,              44) \
+   F(S, fDACFileScale,                   46) \
+   F(S, fDACFileOffset,                  50) \
+   F(S, lDACFileEpisodeNum,              54) \
+   F(S, nDACFileADCNum,                  58) \
+   F(S, nConditEnable,                   60) \
+   F(S, lConditNumPulses,                62) \
+   F(S, fBaselineDuration,               66) \
+   F(S, fBaselineLevel,                  70) \
+   F(S, fStepDuration,                   74) \
+   F(S, fStepLevel,                      78) \
+   F(S, fPostTrainPeriod,                82) \
+   F(S, fPostTrainLevel,                 86) \
+   F(S, nMembTestEnable,                 90) \
+   F(S, nLeakSubtractType,               92) \
+   F(S, nPNPolarity,                     94) \
+   F(S, fPNHoldingLevel,                 96) \
+   F(S, nPNNumADCChannels,              100) \
+   F(S, nPNPosition,                    102) \
+   F(S, nPNNumPulses,                   104) \
+   F(S, fPNSettlingTime,                106) \
+   F(S, fPNInterpulse,                  110) \
+   F(S, nLTPUsageOfDAC,                 114) \
+   F(S, nLTPPresynapticPulses,          116) \
+   F(S, lDACFilePathIndex,              118) \
+   F(S, fMembTestPreSettlingTimeMS,     122) \
+   F(S, fMembTestPostSettlingTimeMS,    126) \
+   F(S, nLeakSubtractADCIndex,          130) \
+   F(S, sUnused,                        132)
+
+#define ABF2_EPOCHINFOPERDAC_FIELDS(F, S) \
+   F(S, nEpochNum,            0) \
+   F(S, nDACNum,              2) \
+   F(S, nEpochType,           4) \
+   F(S, fEpochInitLevel,      6) \
+   F(S, fEpochLevelInc,      10) \
+   F(S, lEpochInitDuration,  14) \
+   F(S, lEpochDurationInc,   18) \
+   F(S, lEpochPulsePeriod,   22) \
+   F(S, lEpochPulseWidth,    26) \
+   F(S, sUnused,             30)
+
+#define ABF2_EPOCHINFO_FIELDS(F, S) \
+   F(S, nEpochNum,                     0) \
+   F(S, nDigitalValue,                 2) \
+   F(S, nDigitalTrainValue,            4) \
+   F(S, nAlternateDigitalValue,        6) \
+   F(S, nAlternateDigitalTrainValue,   8) \
+   F(S, bEpochCompression,            10) \
+   F(S, sUnused,                      11)
+
+#define ABF2_STATSREGIONINFO_FIELDS(F, S) \
+   F(S, nRegionNum,                0) \
+   F(S, nADCNum,                   2) \
+   F(S, nStatsActiveChannels,      4) \
+   F(S, nStatsSearchRegionFlags,   6) \
+   F(S, nStatsSelectedRegion,      8) \
+   F(S, nStatsSmoothing,          10) \
+   F(S, nStatsSmoothingEnable,    12) \
+   F(S, nStatsBaseline,           14) \
+   F(S, lStatsBaselineStart,      16) \
+   F(S, lStatsBaselineEnd,        20) \
+   F(S, lStatsMeasurements,       24) \
+   F(S, lStatsStart,              28) \
+   F(S, lStatsEnd,                32) \
+   F(S, nRiseBottomPercentile,    36) \
+   F(S, nRiseTopPercentile,       38) \
+   F(S, nDecayBottomPercentile,   40) \
+   F(S, nDecayTopPercentile,      42) \
+   F(S, nStatsSearchMode,         44) \
+   F(S, nStatsSearchDAC,          46) \
+   F(S, nStatsBaselineDAC,        48) \
+   F(S, sUnused,                  50)
+
+#define ABF2_USERLISTINFO_FIELDS(F, S) \
+   F(S, nListNum,                 0) \
+   F(S, nULEnable,                2) \
+   F(S, nULParamToVary,           4) \
+   F(S, nULRepeat,                6) \
+   F(S, lULParamValueListIndex,   8) \
+   F(S, sUnused,                 12)
+
+#endif   // INC_STRUCTLAYOUT_HPP
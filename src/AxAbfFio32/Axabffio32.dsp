@@ -106,6 +106,11 @@ PostBuild_Cmds=\AxonDev\Tools\Update $(OutDir)\$(TargetName) dll
 # PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;hpj;bat;for;f90"
 # Begin Source File
 
+SOURCE=..\adc_convert.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=.\Abffiles.cpp
 # End Source File
 # Begin Source File
@@ -168,10 +173,26 @@ SOURCE=.\DACFile.CPP
 # End Source File
 # Begin Source File
 
+SOURCE=.\DemuxKernels.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\EpisodeCache.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\Filedesc.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\HeaderCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\MathKernel.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\Common\FileIO.CPP
 # End Source File
 # Begin Source File
@@ -208,6 +229,11 @@ SOURCE=.\StringResource.CPP
 # End Source File
 # Begin Source File
 
+SOURCE=..\swap.c
+# SUBTRACT CPP /YX /Yc /Yu
+# End Source File
+# Begin Source File
+
 SOURCE=.\TextBuffer.cpp
 # End Source File
 # Begin Source File
@@ -285,10 +311,26 @@ SOURCE=.\DACFile.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\DemuxKernels.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\EpisodeCache.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\FILEDESC.HPP
 # End Source File
 # Begin Source File
 
+SOURCE=.\HeaderCache.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\MathKernel.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\common\FileIO.hpp
 # End Source File
 # Begin Source File
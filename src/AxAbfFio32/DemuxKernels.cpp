@@ -0,0 +1,120 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// MODULE:  DemuxKernels.cpp
+// PURPOSE: Run time dispatch to the de-multiplexing kernels specialized for each channel count.
+//
+
+#include "wincpp.hpp"
+#include "DemuxKernels.hpp"
+
+typedef void (*PFNPACK2)(const short *, short *, UINT, UINT);
+typedef void (*PFNPACK4)(const UINT *, UINT *, UINT, UINT);
+typedef void (*PFNPACKALL2)(const short *, short * const *, UINT);
+typedef void (*PFNPACKALL4)(const UINT *, UINT * const *, UINT);
+typedef void (*PFNSCALEALL)(const short *, float * const *, UINT, const float *, const float *);
+
+// Table of the kernels for 1 to DEMUX_MAXCHANNELS channels, indexed by channel count - 1.
+#define DEMUX_TABLE(Kernel) \
+   { Kernel(1),  Kernel(2),  Kernel(3),  Kernel(4),  Kernel(5),  Kernel(6),  Kernel(7),  Kernel(8), \
+     Kernel(9),  Kernel(10), Kernel(11), Kernel(12), Kernel(13), Kernel(14), Kernel(15), Kernel(16) }
+
+#define PACK2(N)     &CDemuxPack<short, N>::Pack
+#define PACK4(N)     &CDemuxPack<UINT, N>::Pack
+#define PACKALL2(N)  &CDemuxPack<short, N>::PackAll
+#define PACKALL4(N)  &CDemuxPack<UINT, N>::PackAll
+#define SCALEALL(N)  &CDemuxADC<N>::ScaleAll
+
+static const PFNPACK2    s_apfnPack2[DEMUX_MAXCHANNELS]    = DEMUX_TABLE(PACK2);
+static const PFNPACK4    s_apfnPack4[DEMUX_MAXCHANNELS]    = DEMUX_TABLE(PACK4);
+static const PFNPACKALL2 s_apfnPackAll2[DEMUX_MAXCHANNELS] = DEMUX_TABLE(PACKALL2);
+static const PFNPACKALL4 s_apfnPackAll4[DEMUX_MAXCHANNELS] = DEMUX_TABLE(PACKALL4);
+static const PFNSCALEALL s_apfnScaleAll[DEMUX_MAXCHANNELS] = DEMUX_TABLE(SCALEALL);
+
+//===============================================================================================
+// FUNCTION: PackStrided
+// PURPOSE:  Generic strided copy for channel counts without a specialized kernel.
+//
+template <class T>
+static void PackStrided(const T *pSource, T *pDest, UINT uChannels, UINT uOffset, UINT uFrames)
+{
+   pSource += uOffset;
+   for (UINT i=0; i<uFrames; i++, pSource+=uChannels)
+      pDest[i] = *pSource;
+}
+
+//===============================================================================================
+// FUNCTION: DEMUX_Pack
+// PURPOSE:  Copies the channel at multiplex offset uOffset out of uFrames frames of
+//           uChannels samples of uSampleSize (2 or 4) bytes each.
+//
+void DEMUX_Pack(const void *pvSource, void *pvDest, UINT uSampleSize, UINT uChannels, UINT uOffset,
+                UINT uFrames)
+{
+   ASSERT(uChannels > 0);
+   ASSERT(uOffset < uChannels);
+   ASSERT((uSampleSize == sizeof(short)) || (uSampleSize == sizeof(UINT)));
+
+   if (uSampleSize == sizeof(short))
+   {
+      if (uChannels <= DEMUX_MAXCHANNELS)
+         s_apfnPack2[uChannels-1]((const short *)pvSource, (short *)pvDest, uFrames, uOffset);
+      else
+         PackStrided((const short *)pvSource, (short *)pvDest, uChannels, uOffset, uFrames);
+   }
+   else
+   {
+      if (uChannels <= DEMUX_MAXCHANNELS)
+         s_apfnPack4[uChannels-1]((const UINT *)pvSource, (UINT *)pvDest, uFrames, uOffset);
+      else
+         PackStrided((const UINT *)pvSource, (UINT *)pvDest, uChannels, uOffset, uFrames);
+   }
+}
+
+//===============================================================================================
+// FUNCTION: DEMUX_PackAll
+// PURPOSE:  Copies every channel out of uFrames complete frames in one pass.
+//           ppvDest holds uChannels buffers, NULL to skip a channel.
+//
+void DEMUX_PackAll(const void *pvSource, void * const *ppvDest, UINT uSampleSize, UINT uChannels,
+                   UINT uFrames)
+{
+   ASSERT(uChannels > 0);
+   ASSERT((uSampleSize == sizeof(short)) || (uSampleSize == sizeof(UINT)));
+
+   if (uChannels > DEMUX_MAXCHANNELS)
+   {
+      for (UINT c=0; c<uChannels; c++)
+         if (ppvDest[c])
+            DEMUX_Pack(pvSource, ppvDest[c], uSampleSize, uChannels, c, uFrames);
+   }
+   else if (uSampleSize == sizeof(short))
+      s_apfnPackAll2[uChannels-1]((const short *)pvSource, (short * const *)ppvDest, uFrames);
+   else
+      s_apfnPackAll4[uChannels-1]((const UINT *)pvSource, (UINT * const *)ppvDest, uFrames);
+}
+
+//===============================================================================================
+// FUNCTION: DEMUX_ScaleAllADC
+// PURPOSE:  Scales every channel out of uFrames complete frames of ADC values in one pass.
+//           ppfDest, pfFactor and pfShift hold one entry per channel; NULL buffers are skipped.
+//
+void DEMUX_ScaleAllADC(const short *pnSource, float * const *ppfDest, UINT uChannels, UINT uFrames,
+                       const float *pfFactor, const float *pfShift)
+{
+   ASSERT(uChannels > 0);
+
+   if (uChannels <= DEMUX_MAXCHANNELS)
+   {
+      s_apfnScaleAll[uChannels-1](pnSource, ppfDest, uFrames, pfFactor, pfShift);
+      return;
+   }
+   for (UINT i=0; i<uFrames; i++, pnSource+=uChannels)
+      for (UINT c=0; c<uChannels; c++)
+         if (ppfDest[c])
+            ppfDest[c][i] = pnSource[c] * pfFactor[c] + pfShift[c];
+}
@@ -0,0 +1,282 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// HEADER:  DemuxKernels.hpp
+// PURPOSE: De-multiplexing kernels specialized at compile time for each channel count.
+// NOTES:   Multiplexed data holds one frame of N samples, one per channel, for each sample
+//          time. With N a template parameter the strides are constants, so the loops below
+//          are unrolled and vectorized by the compiler; the commonest layouts (two channels of
+//          2 byte samples, two and four channels of 4 byte samples) also have SSE2 versions
+//          that de-interleave whole vectors with shuffles.
+//
+//          The DEMUX_ functions pick the kernel for a channel count at run time and fall
+//          back to a plain strided loop above DEMUX_MAXCHANNELS channels. Single channels of
+//          ADC values are scaled by adc_to_float_strided(), which has its own vector kernels.
+//
+
+#ifndef INC_DEMUXKERNELS_HPP
+#define INC_DEMUXKERNELS_HPP
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DEMUX_SSE2
+#include <emmintrin.h>
+#endif
+
+#define DEMUX_MAXCHANNELS  16
+
+//===============================================================================================
+// CLASS:   CDemuxPack
+// PURPOSE: Copies channels out of N channel frames of samples of type T.
+//          4 byte samples are moved as UINTs so that float bit patterns are kept exactly.
+//
+template <class T, UINT N>
+class CDemuxPack
+{
+public:
+   // Copies the channel at multiplex offset uOffset.
+   static void Pack(const T *pSource, T *pDest, UINT uFrames, UINT uOffset)
+   {
+      pSource += uOffset;
+      for (UINT i=0; i<uFrames; i++)
+         pDest[i] = pSource[i*N];
+   }
+
+   // Copies every channel; a NULL destination skips that channel.
+   static void PackAll(const T *pSource, T * const *ppDest, UINT uFrames)
+   {
+      if (!AllPresent(ppDest))
+      {
+         for (UINT c=0; c<N; c++)
+            if (ppDest[c])
+               Pack(pSource, ppDest[c], uFrames, c);
+         return;
+      }
+      for (UINT i=0; i<uFrames; i++, pSource+=N)
+         for (UINT c=0; c<N; c++)
+            ppDest[c][i] = pSource[c];
+   }
+
+   static BOOL AllPresent(void * const *ppDest)
+   {
+      for (UINT c=0; c<N; c++)
+         if (!ppDest[c])
+            return FALSE;
+      return TRUE;
+   }
+
+   static BOOL AllPresent(T * const *ppDest)
+   {
+      return AllPresent((void * const *)ppDest);
+   }
+};
+
+//===============================================================================================
+// CLASS:   CDemuxADC
+// PURPOSE: Scales channels of N channel frames of ADC values to UserUnits.
+//
+template <UINT N>
+class CDemuxADC
+{
+public:
+   // Scales the channel at multiplex offset uOffset.
+   static void Scale(const short *pnSource, float *pfDest, UINT uFrames, UINT uOffset,
+                     float fFactor, float fShift)
+   {
+      pnSource += uOffset;
+      for (UINT i=0; i<uFrames; i++)
+         pfDest[i] = pnSource[i*N] * fFactor + fShift;
+   }
+
+   // Scales every channel with its own factors; a NULL destination skips that channel.
+   static void ScaleAll(const short *pnSource, float * const *ppfDest, UINT uFrames,
+                        const float *pfFactor, const float *pfShift)
+   {
+      if (!CDemuxPack<float, N>::AllPresent(ppfDest))
+      {
+         for (UINT c=0; c<N; c++)
+            if (ppfDest[c])
+               Scale(pnSource, ppfDest[c], uFrames, c, pfFactor[c], pfShift[c]);
+         return;
+      }
+      for (UINT i=0; i<uFrames; i++, pnSource+=N)
+         for (UINT c=0; c<N; c++)
+            ppfDest[c][i] = pnSource[c] * pfFactor[c] + pfShift[c];
+   }
+};
+
+#ifdef DEMUX_SSE2
+//-----------------------------------------------------------------------------------------------
+// SSE2 specializations.
+// Single channel kernels read each frame whole, so they stop one frame short of the end in
+// case the last frame is incomplete, and leave it to the scalar loop.
+
+// Two channels of 2 byte samples: each frame is one 32 bit lane, the channel is one half of it.
+template <>
+inline void CDemuxPack<short, 2>::Pack(const short *pSource, short *pDest, UINT uFrames, UINT uOffset)
+{
+   UINT i = 0;
+   for (; i+8 < uFrames; i+=8)
+   {
+      __m128i v0 = _mm_loadu_si128((const __m128i *)(pSource + i*2));
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(pSource + i*2 + 8));
+      if (uOffset == 0)
+      {
+         v0 = _mm_slli_epi32(v0, 16);
+         v1 = _mm_slli_epi32(v1, 16);
+      }
+      v0 = _mm_srai_epi32(v0, 16);
+      v1 = _mm_srai_epi32(v1, 16);
+      _mm_storeu_si128((__m128i *)(pDest + i), _mm_packs_epi32(v0, v1));
+   }
+   for (; i<uFrames; i++)
+      pDest[i] = pSource[i*2 + uOffset];
+}
+
+template <>
+inline void CDemuxPack<short, 2>::PackAll(const short *pSource, short * const *ppDest, UINT uFrames)
+{
+   if (!AllPresent(ppDest))
+   {
+      for (UINT c=0; c<2; c++)
+         if (ppDest[c])
+            Pack(pSource, ppDest[c], uFrames, c);
+      return;
+   }
+   UINT i = 0;
+   for (; i+8 < uFrames; i+=8)
+   {
+      __m128i v0 = _mm_loadu_si128((const __m128i *)(pSource + i*2));
+      __m128i v1 = _mm_loadu_si128((const __m128i *)(pSource + i*2 + 8));
+      __m128i l  = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(v0, 16), 16),
+                                   _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16));
+      __m128i h  = _mm_packs_epi32(_mm_srai_epi32(v0, 16), _mm_srai_epi32(v1, 16));
+      _mm_storeu_si128((__m128i *)(ppDest[0] + i), l);
+      _mm_storeu_si128((__m128i *)(ppDest[1] + i), h);
+   }
+   for (; i<uFrames; i++)
+   {
+      ppDest[0][i] = pSource[i*2];
+      ppDest[1][i] = pSource[i*2 + 1];
+   }
+}
+
+template <>
+inline void CDemuxADC<2>::ScaleAll(const short *pnSource, float * const *ppfDest, UINT uFrames,
+                                   const float *pfFactor, const float *pfShift)
+{
+   if (!CDemuxPack<float, 2>::AllPresent(ppfDest))
+   {
+      for (UINT c=0; c<2; c++)
+         if (ppfDest[c])
+            Scale(pnSource, ppfDest[c], uFrames, c, pfFactor[c], pfShift[c]);
+      return;
+   }
+   const __m128 f0 = _mm_set1_ps(pfFactor[0]), s0 = _mm_set1_ps(pfShift[0]);
+   const __m128 f1 = _mm_set1_ps(pfFactor[1]), s1 = _mm_set1_ps(pfShift[1]);
+   UINT i = 0;
+   for (; i+4 < uFrames; i+=4)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i *)(pnSource + i*2));
+      __m128  l = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+      __m128  h = _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+      _mm_storeu_ps(ppfDest[0] + i, _mm_add_ps(_mm_mul_ps(l, f0), s0));
+      _mm_storeu_ps(ppfDest[1] + i, _mm_add_ps(_mm_mul_ps(h, f1), s1));
+   }
+   for (; i<uFrames; i++)
+   {
+      ppfDest[0][i] = pnSource[i*2]     * pfFactor[0] + pfShift[0];
+      ppfDest[1][i] = pnSource[i*2 + 1] * pfFactor[1] + pfShift[1];
+   }
+}
+
+// Two and four channels of 4 byte samples: the channels are gathered with shufps.
+template <>
+inline void CDemuxPack<UINT, 2>::Pack(const UINT *pSource, UINT *pDest, UINT uFrames, UINT uOffset)
+{
+   UINT i = 0;
+   for (; i+4 < uFrames; i+=4)
+   {
+      __m128 v0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*2)));
+      __m128 v1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*2 + 4)));
+      __m128 r  = uOffset ? _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3,1,3,1))
+                          : _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2,0,2,0));
+      _mm_storeu_si128((__m128i *)(pDest + i), _mm_castps_si128(r));
+   }
+   for (; i<uFrames; i++)
+      pDest[i] = pSource[i*2 + uOffset];
+}
+
+template <>
+inline void CDemuxPack<UINT, 2>::PackAll(const UINT *pSource, UINT * const *ppDest, UINT uFrames)
+{
+   if (!AllPresent(ppDest))
+   {
+      for (UINT c=0; c<2; c++)
+         if (ppDest[c])
+            Pack(pSource, ppDest[c], uFrames, c);
+      return;
+   }
+   UINT i = 0;
+   for (; i+4 <= uFrames; i+=4)
+   {
+      __m128 v0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*2)));
+      __m128 v1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*2 + 4)));
+      _mm_storeu_si128((__m128i *)(ppDest[0] + i), _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2,0,2,0))));
+      _mm_storeu_si128((__m128i *)(ppDest[1] + i), _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3,1,3,1))));
+   }
+   for (; i<uFrames; i++)
+   {
+      ppDest[0][i] = pSource[i*2];
+      ppDest[1][i] = pSource[i*2 + 1];
+   }
+}
+
+template <>
+inline void CDemuxPack<UINT, 4>::PackAll(const UINT *pSource, UINT * const *ppDest, UINT uFrames)
+{
+   if (!AllPresent(ppDest))
+   {
+      for (UINT c=0; c<4; c++)
+         if (ppDest[c])
+            Pack(pSource, ppDest[c], uFrames, c);
+      return;
+   }
+   UINT i = 0;
+   for (; i+4 <= uFrames; i+=4)
+   {
+      __m128 r0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*4)));
+      __m128 r1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*4 + 4)));
+      __m128 r2 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*4 + 8)));
+      __m128 r3 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(pSource + i*4 + 12)));
+      _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+      _mm_storeu_si128((__m128i *)(ppDest[0] + i), _mm_castps_si128(r0));
+      _mm_storeu_si128((__m128i *)(ppDest[1] + i), _mm_castps_si128(r1));
+      _mm_storeu_si128((__m128i *)(ppDest[2] + i), _mm_castps_si128(r2));
+      _mm_storeu_si128((__m128i *)(ppDest[3] + i), _mm_castps_si128(r3));
+   }
+   for (; i<uFrames; i++)
+      for (UINT c=0; c<4; c++)
+         ppDest[c][i] = pSource[i*4 + c];
+}
+#endif   // DEMUX_SSE2
+
+//-----------------------------------------------------------------------------------------------
+// Run time dispatch.
+
+// Copies the channel at multiplex offset uOffset of uFrames frames of uSampleSize (2 or 4) byte samples.
+void DEMUX_Pack(const void *pvSource, void *pvDest, UINT uSampleSize, UINT uChannels, UINT uOffset,
+                UINT uFrames);
+
+// Copies every channel; ppvDest holds uChannels buffers, NULL to skip a channel.
+void DEMUX_PackAll(const void *pvSource, void * const *ppvDest, UINT uSampleSize, UINT uChannels,
+                   UINT uFrames);
+
+// Scales every channel with its own factors; ppfDest holds uChannels buffers, NULL to skip a channel.
+void DEMUX_ScaleAllADC(const short *pnSource, float * const *ppfDest, UINT uChannels, UINT uFrames,
+                       const float *pfFactor, const float *pfShift);
+
+#endif   // INC_DEMUXKERNELS_HPP
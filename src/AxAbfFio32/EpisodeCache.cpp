@@ -0,0 +1,236 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// MODULE:  EpisodeCache.cpp
+// PURPOSE: Least recently used cache of multiplexed episodes read from a data file.
+//
+
+#include "wincpp.hpp"
+#include "EpisodeCache.hpp"
+
+//===============================================================================================
+// FUNCTION: Constructor
+// PURPOSE:  Initialize the object
+//
+CEpisodeCache::CEpisodeCache()
+{
+   MEMBERASSERT();
+   m_pHead   = NULL;
+   m_pTail   = NULL;
+   m_uBytes  = 0;
+   m_uBudget = EPISODECACHE_DEFAULTBYTES;
+   m_uHits   = 0;
+   m_uMisses = 0;
+}
+
+//===============================================================================================
+// FUNCTION: Destructor
+// PURPOSE:  Cleanup the object when it is deleted.
+//
+CEpisodeCache::~CEpisodeCache()
+{
+   MEMBERASSERT();
+   Flush();
+}
+
+//===============================================================================================
+// FUNCTION: Unlink
+// PURPOSE:  Removes an entry from the list.
+//
+void CEpisodeCache::Unlink(Entry *pEntry)
+{
+   MEMBERASSERT();
+   if (pEntry->pPrev)
+      pEntry->pPrev->pNext = pEntry->pNext;
+   else
+      m_pHead = pEntry->pNext;
+
+   if (pEntry->pNext)
+      pEntry->pNext->pPrev = pEntry->pPrev;
+   else
+      m_pTail = pEntry->pPrev;
+
+   m_uBytes -= pEntry->uBytes;
+}
+
+//===============================================================================================
+// FUNCTION: LinkHead
+// PURPOSE:  Adds an entry to the list as the most recently used.
+//
+void CEpisodeCache::LinkHead(Entry *pEntry)
+{
+   MEMBERASSERT();
+   pEntry->pPrev = NULL;
+   pEntry->pNext = m_pHead;
+   if (m_pHead)
+      m_pHead->pPrev = pEntry;
+   else
+      m_pTail = pEntry;
+   m_pHead = pEntry;
+
+   m_uBytes += pEntry->uBytes;
+}
+
+//===============================================================================================
+// FUNCTION: Evict
+// PURPOSE:  Frees the least recently used entries until uBytes more fit in the budget.
+// RETURNS:  An evicted entry of uBytes, kept for reuse, or NULL.
+//
+CEpisodeCache::Entry *CEpisodeCache::Evict(UINT uBytes)
+{
+   MEMBERASSERT();
+   Entry *pReuse = NULL;
+   while (m_pTail && (m_uBytes + uBytes > m_uBudget))
+   {
+      Entry *pEntry = m_pTail;
+      Unlink(pEntry);
+      if (!pReuse && (pEntry->uBytes == uBytes))
+         pReuse = pEntry;
+      else
+         free(pEntry);
+   }
+   return pReuse;
+}
+
+//===============================================================================================
+// FUNCTION: SetBudget
+// PURPOSE:  Sets the limit on the size of the cached data, freeing entries to fit.
+//
+void CEpisodeCache::SetBudget(UINT uBytes)
+{
+   MEMBERASSERT();
+   m_uBudget = uBytes;
+
+   // Keep the most recently used entry.
+   Entry *pHead = m_pHead;
+   if (!pHead)
+      return;
+   Unlink(pHead);
+   free(Evict(pHead->uBytes));
+   LinkHead(pHead);
+}
+
+//===============================================================================================
+// FUNCTION: GetBudget
+// PURPOSE:  Gets the limit on the size of the cached data.
+//
+UINT CEpisodeCache::GetBudget() const
+{
+   MEMBERASSERT();
+   return m_uBudget;
+}
+
+//===============================================================================================
+// FUNCTION: Find
+// PURPOSE:  Returns the data of an episode and makes it the most recently used.
+//           Entries of another size, cached for a different header, are not matched.
+// RETURNS:  NULL if the episode is not cached.
+//
+void *CEpisodeCache::Find(UINT uEpisode, UINT uBytes, UINT *puSamples)
+{
+   MEMBERASSERT();
+   WPTRASSERT(puSamples);
+   for (Entry *pEntry = m_pHead; pEntry; pEntry = pEntry->pNext)
+   {
+      if ((pEntry->uEpisode != uEpisode) || (pEntry->uBytes != uBytes) || !pEntry->bValid)
+         continue;
+
+      if (pEntry != m_pHead)
+      {
+         Unlink(pEntry);
+         LinkHead(pEntry);
+      }
+      m_uHits++;
+      *puSamples = pEntry->uSamples;
+      return GetData(pEntry);
+   }
+   m_uMisses++;
+   return NULL;
+}
+
+//===============================================================================================
+// FUNCTION: Insert
+// PURPOSE:  Adds an episode as the most recently used, evicting others to fit the budget.
+// RETURNS:  The buffer for uBytes of data, or NULL if it could not be allocated.
+//
+void *CEpisodeCache::Insert(UINT uEpisode, UINT uBytes)
+{
+   MEMBERASSERT();
+   Entry *pEntry = Evict(uBytes);
+   if (!pEntry)
+   {
+      pEntry = (Entry *)malloc(sizeof(Entry) + uBytes);
+      if (!pEntry)
+         return NULL;
+   }
+   pEntry->uEpisode = uEpisode;
+   pEntry->uSamples = 0;
+   pEntry->uBytes   = uBytes;
+   pEntry->bValid   = FALSE;
+   LinkHead(pEntry);
+   return GetData(pEntry);
+}
+
+//===============================================================================================
+// FUNCTION: Commit
+// PURPOSE:  Marks the data of the last inserted episode as read.
+//
+void CEpisodeCache::Commit(UINT uSamples)
+{
+   MEMBERASSERT();
+   ASSERT(m_pHead && !m_pHead->bValid);
+   m_pHead->uSamples = uSamples;
+   m_pHead->bValid   = TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: Discard
+// PURPOSE:  Removes the last inserted episode, if its data could not be read.
+//
+void CEpisodeCache::Discard()
+{
+   MEMBERASSERT();
+   ASSERT(m_pHead && !m_pHead->bValid);
+   Entry *pEntry = m_pHead;
+   Unlink(pEntry);
+   free(pEntry);
+}
+
+//===============================================================================================
+// FUNCTION: Flush
+// PURPOSE:  Frees every cached episode.
+//
+void CEpisodeCache::Flush()
+{
+   MEMBERASSERT();
+   while (m_pHead)
+   {
+      Entry *pEntry = m_pHead;
+      Unlink(pEntry);
+      free(pEntry);
+   }
+}
+
+//===============================================================================================
+// FUNCTION: GetHits
+// PURPOSE:  Gets the count of episodes found in the cache.
+//
+UINT CEpisodeCache::GetHits() const
+{
+   MEMBERASSERT();
+   return m_uHits;
+}
+
+//===============================================================================================
+// FUNCTION: GetMisses
+// PURPOSE:  Gets the count of episodes that had to be read from the file.
+//
+UINT CEpisodeCache::GetMisses() const
+{
+   MEMBERASSERT();
+   return m_uMisses;
+}
@@ -0,0 +1,73 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// HEADER:  EpisodeCache.hpp
+// PURPOSE: Least recently used cache of multiplexed episodes read from a data file.
+// NOTES:   Entries are kept in a list in order of use, and the least recently used are freed
+//          when the total size would go over the byte budget. The most recently read episode
+//          is always kept, whatever the budget, as the de-multiplexing functions need it.
+//
+
+#ifndef INC_EPISODECACHE_HPP
+#define INC_EPISODECACHE_HPP
+
+#define EPISODECACHE_DEFAULTBYTES   (8 * 1024 * 1024)
+
+class CEpisodeCache
+{
+private:
+   // An episode; its data follows the structure.
+   struct Entry
+   {
+      Entry  *pPrev;          // More recently used.
+      Entry  *pNext;          // Less recently used.
+      UINT    uEpisode;
+      UINT    uSamples;       // Valid samples in the episode.
+      UINT    uBytes;         // Size of the data.
+      BOOL    bValid;         // FALSE until the data has been read.
+   };
+
+   Entry   *m_pHead;          // Most recently used.
+   Entry   *m_pTail;          // Least recently used.
+   UINT     m_uBytes;         // Total size of the cached data.
+   UINT     m_uBudget;        // Limit on m_uBytes.
+   UINT     m_uHits;
+   UINT     m_uMisses;
+
+private:    // Unimplemented copy functions.
+   CEpisodeCache(const CEpisodeCache &);
+   const CEpisodeCache &operator=(const CEpisodeCache &);
+
+private:
+   void   Unlink(Entry *pEntry);
+   void   LinkHead(Entry *pEntry);
+   Entry *Evict(UINT uBytes);
+   static void *GetData(Entry *pEntry) { return pEntry + 1; }
+
+public:
+   CEpisodeCache();
+   ~CEpisodeCache();
+
+   void  SetBudget(UINT uBytes);
+   UINT  GetBudget() const;
+
+   // Returns the cached data of an episode of uBytes, or NULL, and counts a hit or a miss.
+   void *Find(UINT uEpisode, UINT uBytes, UINT *puSamples);
+
+   // Adds an episode of uBytes as the most recently used, and returns the buffer for its data.
+   // The entry is not found until Commit() is called, or is removed by Discard().
+   void *Insert(UINT uEpisode, UINT uBytes);
+   void  Commit(UINT uSamples);
+   void  Discard();
+
+   void  Flush();
+
+   UINT  GetHits() const;
+   UINT  GetMisses() const;
+};
+
+#endif   // INC_EPISODECACHE_HPP
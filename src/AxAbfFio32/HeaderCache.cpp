@@ -0,0 +1,452 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// MODULE:  HeaderCache.cpp
+// PURPOSE: Persistent, memory mapped cache of parsed ABF file headers.
+//
+
+#include "wincpp.hpp"
+#include "HeaderCache.hpp"
+
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------------------------
+// Layout of the cache file: a CacheFileHeader followed by uEntries CacheSlots.
+
+const DWORD c_dwCACHESIGNATURE = MAKEFOURCC('A','B','H','C');   // ABF Header Cache
+const DWORD c_dwCACHEVERSION   = MAKEFOURCC(1,0,0,0);           // 1.0.0.0
+const UINT  c_uPROBES          = 8;                             // Slots tried per lookup.
+
+// Limit on the size of the mapping, so that it fits a DWORD, an off_t and the address space
+// of a 32 bit process.
+const LONGLONG c_llMAXMAPPEDBYTES = 0x7FFFFFFF;
+
+struct CacheFileHeader
+{
+   DWORD dwSignature;
+   DWORD dwVersion;
+   UINT  uEntries;
+   UINT  uSlotSize;
+   UINT  uHeaderSize;
+   BYTE  Unused[44];
+};
+
+struct CacheSlot
+{
+   volatile UINT      uSequence;       // Odd while the slot is being written, 0 if never used.
+   UINT               uUnused;
+   ABFHC_Key          Key;
+   ABFHC_SynchSummary Summary;
+   ABFFileHeader      FH;
+};
+
+STATIC_ASSERT( sizeof(CacheFileHeader) == 64 );
+
+//-----------------------------------------------------------------------------------------------
+// The process wide mapping of the cache file.
+
+static BYTE *s_pbyCache     = NULL;
+static UINT  s_uEntries     = 0;
+static size_t s_uMappedBytes = 0;
+#ifdef _WINDOWS
+static HANDLE s_hCacheFile  = INVALID_HANDLE_VALUE;
+static HANDLE s_hMapping    = NULL;
+#endif
+
+//===============================================================================================
+// FUNCTION: Atomic helpers
+// PURPOSE:  Sequence count updates with full barriers, shared with other processes.
+//
+inline void MemoryFence()
+{
+#ifdef _WINDOWS
+   MemoryBarrier();
+#else
+   __sync_synchronize();
+#endif
+}
+
+inline BOOL CompareAndSwap( volatile UINT *puValue, UINT uOld, UINT uNew )
+{
+#ifdef _WINDOWS
+   return UINT(InterlockedCompareExchange( (volatile LONG *)puValue, LONG(uNew), LONG(uOld) )) == uOld;
+#else
+   return __sync_bool_compare_and_swap( puValue, uOld, uNew );
+#endif
+}
+
+//===============================================================================================
+// FUNCTION: GetSlot
+// PURPOSE:  Returns the slot with the given index.
+//
+static CacheSlot *GetSlot( UINT uIndex )
+{
+   ASSERT( uIndex < s_uEntries );
+   return (CacheSlot *)(s_pbyCache + sizeof(CacheFileHeader)) + uIndex;
+}
+
+//===============================================================================================
+// FUNCTION: HashKey
+// PURPOSE:  Returns the first slot to probe for a key (FNV-1a over its bytes).
+//
+static UINT HashKey( const ABFHC_Key &Key )
+{
+   const BYTE *pby = (const BYTE *)&Key;
+   UINT uHash = 2166136261U;
+   for( UINT i=0; i<sizeof(Key); i++ )
+      uHash = (uHash ^ pby[i]) * 16777619U;
+   return uHash % s_uEntries;
+}
+
+//===============================================================================================
+// FUNCTION: SameKey
+// PURPOSE:  Compares two file identities.
+//
+inline BOOL SameKey( const ABFHC_Key &A, const ABFHC_Key &B )
+{
+   return (A.llDevice   == B.llDevice) &&
+          (A.llFileID   == B.llFileID) &&
+          (A.llSize     == B.llSize)   &&
+          (A.llModified == B.llModified);
+}
+
+//===============================================================================================
+// FUNCTION: GetMappedBytes
+// PURPOSE:  Gets the size of a cache file with uEntries slots.
+// RETURNS:  FALSE if there are no slots, or too many to map.
+//
+static BOOL GetMappedBytes( UINT uEntries, size_t *puBytes )
+{
+   WPTRASSERT( puBytes );
+   LONGLONG llBytes = LONGLONG(sizeof(CacheFileHeader)) + LONGLONG(uEntries) * LONGLONG(sizeof(CacheSlot));
+   if( (uEntries == 0) || (llBytes > c_llMAXMAPPEDBYTES) )
+      return FALSE;
+   *puBytes = size_t(llBytes);
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_Open
+// PURPOSE:  Maps the cache file, creating it with uMaxEntries slots if it does not exist.
+// NOTES:    An existing cache keeps its own size. A file that is not a cache of this version,
+//           or is shorter than its header says, is started afresh.
+//           Fails if uMaxEntries slots would be too large to map.
+//
+BOOL ABFHC_Open( LPCSTR szCacheFile, UINT uMaxEntries )
+{
+   LPSZASSERT( szCacheFile );
+   ABFHC_Close();
+
+   if( uMaxEntries == 0 )
+      uMaxEntries = ABFHC_DEFAULTENTRIES;
+
+   size_t uMappedBytes = 0;
+   if( !GetMappedBytes( uMaxEntries, &uMappedBytes ) )
+      return FALSE;
+
+   CacheFileHeader Header;
+   memset( &Header, 0, sizeof(Header) );
+   Header.dwSignature = c_dwCACHESIGNATURE;
+   Header.dwVersion   = c_dwCACHEVERSION;
+   Header.uEntries    = uMaxEntries;
+   Header.uSlotSize   = sizeof(CacheSlot);
+   Header.uHeaderSize = sizeof(ABFFileHeader);
+
+#ifdef _WINDOWS
+   s_hCacheFile = CreateFile( szCacheFile, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+   if( s_hCacheFile == INVALID_HANDLE_VALUE )
+      return FALSE;
+
+   CacheFileHeader Existing;
+   DWORD dwRead = 0;
+   size_t uExistingBytes = 0;
+   LARGE_INTEGER FileSize;
+   if( ReadFile( s_hCacheFile, &Existing, sizeof(Existing), &dwRead, NULL ) && (dwRead == sizeof(Existing)) &&
+       (Existing.dwSignature == Header.dwSignature) && (Existing.dwVersion == Header.dwVersion) &&
+       (Existing.uSlotSize == Header.uSlotSize) && (Existing.uHeaderSize == Header.uHeaderSize) &&
+       GetMappedBytes( Existing.uEntries, &uExistingBytes ) &&
+       GetFileSizeEx( s_hCacheFile, &FileSize ) && (FileSize.QuadPart >= LONGLONG(uExistingBytes)) )
+   {
+      Header.uEntries = Existing.uEntries;
+      uMappedBytes    = uExistingBytes;
+   }
+   else
+   {
+      // New or unusable: start an empty cache.
+      DWORD dwWritten = 0;
+      SetFilePointer( s_hCacheFile, 0, NULL, FILE_BEGIN );
+      SetEndOfFile( s_hCacheFile );
+      WriteFile( s_hCacheFile, &Header, sizeof(Header), &dwWritten, NULL );
+   }
+
+   s_uMappedBytes = uMappedBytes;
+   s_hMapping = CreateFileMapping( s_hCacheFile, NULL, PAGE_READWRITE, 0, DWORD(s_uMappedBytes), NULL );
+   if( s_hMapping )
+      s_pbyCache = (BYTE *)MapViewOfFile( s_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, s_uMappedBytes );
+#else
+   int fd = open( szCacheFile, O_RDWR | O_CREAT, 0666 );
+   if( fd < 0 )
+      return FALSE;
+
+   CacheFileHeader Existing;
+   size_t uExistingBytes = 0;
+   struct stat st;
+   if( (pread( fd, &Existing, sizeof(Existing), 0 ) == ssize_t(sizeof(Existing))) &&
+       (Existing.dwSignature == Header.dwSignature) && (Existing.dwVersion == Header.dwVersion) &&
+       (Existing.uSlotSize == Header.uSlotSize) && (Existing.uHeaderSize == Header.uHeaderSize) &&
+       GetMappedBytes( Existing.uEntries, &uExistingBytes ) &&
+       (fstat( fd, &st ) == 0) && (LONGLONG(st.st_size) >= LONGLONG(uExistingBytes)) )
+   {
+      Header.uEntries = Existing.uEntries;
+      uMappedBytes    = uExistingBytes;
+   }
+   else if( (ftruncate( fd, 0 ) != 0) ||
+            (pwrite( fd, &Header, sizeof(Header), 0 ) != ssize_t(sizeof(Header))) )
+   {
+      close( fd );
+      return FALSE;
+   }
+
+   // Unused slots stay sparse in the file until they are written.
+   s_uMappedBytes = uMappedBytes;
+   if( ftruncate( fd, off_t(s_uMappedBytes) ) == 0 )
+   {
+      void *pv = mmap( NULL, s_uMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      if( pv != MAP_FAILED )
+         s_pbyCache = (BYTE *)pv;
+   }
+   close( fd );
+#endif
+
+   if( !s_pbyCache )
+   {
+      ABFHC_Close();
+      return FALSE;
+   }
+   s_uEntries = Header.uEntries;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_Close
+// PURPOSE:  Unmaps the cache file.
+//
+void ABFHC_Close()
+{
+#ifdef _WINDOWS
+   if( s_pbyCache )
+      UnmapViewOfFile( s_pbyCache );
+   if( s_hMapping )
+      CloseHandle( s_hMapping );
+   if( s_hCacheFile != INVALID_HANDLE_VALUE )
+      CloseHandle( s_hCacheFile );
+   s_hMapping   = NULL;
+   s_hCacheFile = INVALID_HANDLE_VALUE;
+#else
+   if( s_pbyCache )
+      munmap( s_pbyCache, s_uMappedBytes );
+#endif
+   s_pbyCache     = NULL;
+   s_uEntries     = 0;
+   s_uMappedBytes = 0;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_IsOpen
+// PURPOSE:  Returns TRUE if a cache file is mapped.
+//
+BOOL ABFHC_IsOpen()
+{
+   return s_pbyCache != NULL;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_GetKey
+// PURPOSE:  Gets the identity of a file on disk.
+//
+BOOL ABFHC_GetKey( LPCSTR szFileName, ABFHC_Key *pKey )
+{
+   LPSZASSERT( szFileName );
+   WPTRASSERT( pKey );
+   memset( pKey, 0, sizeof(*pKey) );
+
+#ifdef _WINDOWS
+   HANDLE hFile = CreateFile( szFileName, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+   if( hFile == INVALID_HANDLE_VALUE )
+      return FALSE;
+
+   BY_HANDLE_FILE_INFORMATION Info;
+   BOOL bOK = GetFileInformationByHandle( hFile, &Info );
+   CloseHandle( hFile );
+   if( !bOK )
+      return FALSE;
+
+   pKey->llDevice   = Info.dwVolumeSerialNumber;
+   pKey->llFileID   = (LONGLONG(Info.nFileIndexHigh) << 32) | Info.nFileIndexLow;
+   pKey->llSize     = (LONGLONG(Info.nFileSizeHigh) << 32) | Info.nFileSizeLow;
+   pKey->llModified = (LONGLONG(Info.ftLastWriteTime.dwHighDateTime) << 32) | Info.ftLastWriteTime.dwLowDateTime;
+#else
+   struct stat st;
+   if( stat( szFileName, &st ) != 0 )
+      return FALSE;
+
+   pKey->llDevice   = LONGLONG(st.st_dev);
+   pKey->llFileID   = LONGLONG(st.st_ino);
+   pKey->llSize     = LONGLONG(st.st_size);
+#if defined(__APPLE__)
+   pKey->llModified = LONGLONG(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+   pKey->llModified = LONGLONG(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_Lookup
+// PURPOSE:  Copies the cached header and synch summary for a file, if there are any.
+// NOTES:    pSummary may be NULL. A summary that was never stored has uMaxSamples == 0.
+//
+BOOL ABFHC_Lookup( const ABFHC_Key &Key, ABFFileHeader *pFH, ABFHC_SynchSummary *pSummary )
+{
+   WPTRASSERT( pFH );
+   if( !s_pbyCache )
+      return FALSE;
+
+   UINT uIndex = HashKey( Key );
+   for( UINT i=0; i<c_uPROBES; i++, uIndex = (uIndex + 1) % s_uEntries )
+   {
+      CacheSlot *pSlot = GetSlot( uIndex );
+      UINT uSequence = pSlot->uSequence;
+      MemoryFence();
+
+      // Never used: the key was not stored further along either.
+      if( uSequence == 0 )
+         return FALSE;
+      if( (uSequence & 1) || !SameKey( pSlot->Key, Key ) )
+         continue;
+
+      ABFHC_SynchSummary Summary = pSlot->Summary;
+      ABFFileHeader FH;
+      memcpy( &FH, &pSlot->FH, sizeof(ABFFileHeader) );
+      MemoryFence();
+
+      // Torn by a concurrent writer: treat it as a miss.
+      if( pSlot->uSequence != uSequence )
+         return FALSE;
+
+      memcpy( pFH, &FH, sizeof(ABFFileHeader) );
+      if( pSummary )
+         *pSummary = Summary;
+      return TRUE;
+   }
+   return FALSE;
+}
+
+//===============================================================================================
+// FUNCTION: BeginWrite
+// PURPOSE:  Claims a slot for writing. Returns FALSE if another writer has it.
+//
+static BOOL BeginWrite( CacheSlot *pSlot, UINT *puSequence )
+{
+   UINT uSequence = pSlot->uSequence;
+   if( (uSequence & 1) || !CompareAndSwap( &pSlot->uSequence, uSequence, uSequence + 1 ) )
+      return FALSE;
+   *puSequence = uSequence;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: EndWrite
+// PURPOSE:  Publishes a slot claimed by BeginWrite.
+//
+static void EndWrite( CacheSlot *pSlot, UINT uSequence )
+{
+   // Zero marks a slot that was never used, so skip it when the count wraps.
+   UINT uNext = uSequence + 2;
+   if( uNext == 0 )
+      uNext = 2;
+   MemoryFence();
+   pSlot->uSequence = uNext;
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_Store
+// PURPOSE:  Stores the header and synch summary of a file, replacing any older entry for it.
+// NOTES:    pSummary may be NULL if the synch array has not been read.
+//
+void ABFHC_Store( const ABFHC_Key &Key, const ABFFileHeader *pFH, const ABFHC_SynchSummary *pSummary )
+{
+   RPTRASSERT( pFH );
+   if( !s_pbyCache )
+      return;
+
+   // Use the slot that has this key, else the first unused one, else evict the first probed.
+   UINT uHome   = HashKey( Key );
+   UINT uTarget = uHome;
+   UINT uIndex  = uHome;
+   for( UINT i=0; i<c_uPROBES; i++, uIndex = (uIndex + 1) % s_uEntries )
+   {
+      CacheSlot *pSlot = GetSlot( uIndex );
+      if( (pSlot->uSequence == 0) || SameKey( pSlot->Key, Key ) )
+      {
+         uTarget = uIndex;
+         break;
+      }
+   }
+
+   CacheSlot *pSlot = GetSlot( uTarget );
+   UINT uSequence = 0;
+   if( !BeginWrite( pSlot, &uSequence ) )
+      return;
+
+   pSlot->Key = Key;
+   if( pSummary )
+      pSlot->Summary = *pSummary;
+   else
+      memset( &pSlot->Summary, 0, sizeof(pSlot->Summary) );
+   memcpy( &pSlot->FH, pFH, sizeof(ABFFileHeader) );
+   EndWrite( pSlot, uSequence );
+}
+
+//===============================================================================================
+// FUNCTION: ABFHC_StoreSummary
+// PURPOSE:  Adds the synch summary to the entry stored for a file, if there is one.
+//
+void ABFHC_StoreSummary( const ABFHC_Key &Key, const ABFHC_SynchSummary *pSummary )
+{
+   RPTRASSERT( pSummary );
+   if( !s_pbyCache )
+      return;
+
+   UINT uIndex = HashKey( Key );
+   for( UINT i=0; i<c_uPROBES; i++, uIndex = (uIndex + 1) % s_uEntries )
+   {
+      CacheSlot *pSlot = GetSlot( uIndex );
+      if( pSlot->uSequence == 0 )
+         return;
+      if( !SameKey( pSlot->Key, Key ) )
+         continue;
+
+      UINT uSequence = 0;
+      if( !BeginWrite( pSlot, &uSequence ) )
+         return;
+
+      // The slot may have been reused for another file before it was claimed.
+      if( SameKey( pSlot->Key, Key ) )
+         pSlot->Summary = *pSummary;
+      EndWrite( pSlot, uSequence );
+      return;
+   }
+}
@@ -0,0 +1,53 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// HEADER:  HeaderCache.hpp
+// PURPOSE: Persistent, memory mapped cache of parsed ABF file headers.
+// NOTES:   The cache is a fixed size hash table in a sidecar file, shared between processes.
+//          Entries are keyed by file identity (device, inode, size and modification time), so
+//          a file that is changed, replaced or moved to another volume misses the cache.
+//
+//          Each slot is guarded by a sequence count that is odd while the slot is written.
+//          Readers copy a slot and accept it only if the count was even and unchanged across
+//          the copy, so lookups take no locks. A writer claims a slot with a compare-and-swap
+//          on the count and skips the store if another writer has it; the cache is a hint and
+//          every miss falls back to decoding the file.
+//
+
+#ifndef INC_HEADERCACHE_HPP
+#define INC_HEADERCACHE_HPP
+
+#include "abfheader.h"
+
+#define ABFHC_DEFAULTENTRIES  8192     // Slots in a newly created cache (about 50 MB).
+
+// Identity of a file on disk.
+struct ABFHC_Key
+{
+   LONGLONG  llDevice;
+   LONGLONG  llFileID;
+   LONGLONG  llSize;
+   LONGLONG  llModified;      // Modification time in 100 ns units or ns, as the platform has it.
+};
+
+// What ABF_ReadOpen derives from the synch array.
+struct ABFHC_SynchSummary
+{
+   UINT  uMaxSamples;         // Samples per channel that can be read contiguously.
+   DWORD dwMaxEpi;            // Number of chunks of uMaxSamples in the file.
+};
+
+BOOL ABFHC_Open( LPCSTR szCacheFile, UINT uMaxEntries );
+void ABFHC_Close();
+BOOL ABFHC_IsOpen();
+
+BOOL ABFHC_GetKey( LPCSTR szFileName, ABFHC_Key *pKey );
+BOOL ABFHC_Lookup( const ABFHC_Key &Key, ABFFileHeader *pFH, ABFHC_SynchSummary *pSummary );
+void ABFHC_Store( const ABFHC_Key &Key, const ABFFileHeader *pFH, const ABFHC_SynchSummary *pSummary );
+void ABFHC_StoreSummary( const ABFHC_Key &Key, const ABFHC_SynchSummary *pSummary );
+
+#endif   // INC_HEADERCACHE_HPP
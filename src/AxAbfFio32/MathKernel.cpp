@@ -0,0 +1,179 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// MODULE:  MathKernel.cpp
+// PURPOSE: Math channel expressions compiled for evaluation over whole buffers.
+//
+
+#include "wincpp.hpp"
+#include "MathKernel.hpp"
+
+// As in ABFH_GetMathValue().
+#define AVERYBIGNUMBER 3.402823466E+38
+
+// Operators, as indices into the kernel tables.
+enum { eADD, eSUBTRACT, eMULTIPLY, eDIVIDE, eNONE, eOPERATORS };
+
+//-----------------------------------------------------------------------------------------------
+// Operands in UserUnits.
+
+inline float ToUU(float fValue, float, float)
+{
+   return fValue;
+}
+
+inline float ToUU(short nValue, float fFactor, float fShift)
+{
+   return nValue * fFactor + fShift;
+}
+
+//-----------------------------------------------------------------------------------------------
+// Each step below follows ABFH_GetMathValue(), including its mix of float and double
+// arithmetic, so that the results are identical.
+
+template <BOOL bRatio>
+inline void GetOperands(const CABFMathKernel &K, float fA, float fB, double &dLeft, double &dRight);
+
+template <>
+inline void GetOperands<FALSE>(const CABFMathKernel &K, float fA, float fB, double &dLeft, double &dRight)
+{
+   dLeft  = K.m_fK1 * fA + K.m_fK2;
+   dRight = K.m_fK3 * fB + K.m_fK4;
+}
+
+template <>
+inline void GetOperands<TRUE>(const CABFMathKernel &K, float fA, float fB, double &dLeft, double &dRight)
+{
+   float  fNumerator   = fA + K.m_fK5;
+   float  fDenominator = fB + K.m_fK6;
+   double dRatio = (fDenominator != 0.0F) ? double(fNumerator / fDenominator)
+                 : (fNumerator > 0.0F)    ? AVERYBIGNUMBER : -AVERYBIGNUMBER;
+   dLeft  = K.m_fK1 * dRatio + K.m_fK2;
+   dRight = K.m_fK3 * dRatio + K.m_fK4;
+}
+
+template <int nOperator>
+inline double Apply(const CABFMathKernel &K, double dLeft, double dRight);
+
+template <> inline double Apply<eADD>(const CABFMathKernel &, double dLeft, double dRight)
+{
+   return dLeft + dRight;
+}
+
+template <> inline double Apply<eSUBTRACT>(const CABFMathKernel &, double dLeft, double dRight)
+{
+   return dLeft - dRight;
+}
+
+template <> inline double Apply<eMULTIPLY>(const CABFMathKernel &, double dLeft, double dRight)
+{
+   return dLeft * dRight;
+}
+
+template <> inline double Apply<eDIVIDE>(const CABFMathKernel &K, double dLeft, double dRight)
+{
+   return (dRight != 0.0) ? dLeft / dRight
+        : (dLeft > 0)     ? K.m_fUpperLimit : K.m_fLowerLimit;
+}
+
+template <> inline double Apply<eNONE>(const CABFMathKernel &, double, double)
+{
+   return 0.0;
+}
+
+//===============================================================================================
+// FUNCTION: MathKernel
+// PURPOSE:  Evaluates the expression over a buffer of operands of type T.
+//
+template <class T, BOOL bRatio, int nOperator>
+static void MathKernel(const CABFMathKernel &K, const void *pvA, const void *pvB, UINT uStride,
+                       float *pfDest, UINT uCount)
+{
+   const T *pA = (const T *)pvA;
+   const T *pB = (const T *)pvB;
+   if (nOperator == eNONE)
+      ERRORMSG1("Unexpected operator '%c'.", K.m_cOperator);
+   const double dLower = K.m_fLowerLimit;
+   const double dUpper = K.m_fUpperLimit;
+
+   for (UINT i=0; i<uCount; i++)
+   {
+      float fA = ToUU(pA[i*uStride], K.m_fFactorA, K.m_fShiftA);
+      float fB = ToUU(pB[i*uStride], K.m_fFactorB, K.m_fShiftB);
+
+      double dLeft, dRight;
+      GetOperands<bRatio>(K, fA, fB, dLeft, dRight);
+      double dResult = Apply<nOperator>(K, dLeft, dRight);
+
+      dResult = (dResult < dLower) ? dLower
+              : (dResult > dUpper) ? dUpper : dResult;
+      pfDest[i] = float(dResult);
+   }
+}
+
+#define MATHKERNELS(T, bRatio) \
+   { &MathKernel<T, bRatio, eADD>,    &MathKernel<T, bRatio, eSUBTRACT>, \
+     &MathKernel<T, bRatio, eMULTIPLY>, &MathKernel<T, bRatio, eDIVIDE>, \
+     &MathKernel<T, bRatio, eNONE> }
+
+static const PFNMATHKERNEL s_apfnFloat[2][eOPERATORS] = { MATHKERNELS(float, FALSE), MATHKERNELS(float, TRUE) };
+static const PFNMATHKERNEL s_apfnADC[2][eOPERATORS]   = { MATHKERNELS(short, FALSE), MATHKERNELS(short, TRUE) };
+
+//===============================================================================================
+// FUNCTION: Constructor
+// PURPOSE:  Compiles the math expression of the header.
+//
+CABFMathKernel::CABFMathKernel(const ABFFileHeader *pFH)
+{
+   ABFH_ASSERT(pFH);
+   m_fK1 = pFH->fArithmeticK1;
+   m_fK2 = pFH->fArithmeticK2;
+   m_fK3 = pFH->fArithmeticK3;
+   m_fK4 = pFH->fArithmeticK4;
+   m_fK5 = pFH->fArithmeticK5;
+   m_fK6 = pFH->fArithmeticK6;
+   m_fLowerLimit = pFH->fArithmeticLowerLimit;
+   m_fUpperLimit = pFH->fArithmeticUpperLimit;
+   m_cOperator   = pFH->sArithmeticOperator[0];
+   SetADCScaling(1.0F, 0.0F, 1.0F, 0.0F);
+
+   int nOperator;
+   switch (pFH->sArithmeticOperator[0])
+   {
+      case '+':
+         nOperator = eADD;
+         break;
+      case '-':
+         nOperator = eSUBTRACT;
+         break;
+      case '*':
+         nOperator = eMULTIPLY;
+         break;
+      case '/':
+         nOperator = eDIVIDE;
+         break;
+      default:
+         nOperator = eNONE;   // Reported when evaluated, as by ABFH_GetMathValue().
+         break;
+   }
+
+   int nRatio = (pFH->nArithmeticExpression != ABF_SIMPLE_EXPRESSION);
+   m_pfnFloat = s_apfnFloat[nRatio][nOperator];
+   m_pfnADC   = s_apfnADC[nRatio][nOperator];
+}
+
+//===============================================================================================
+// FUNCTION: SetADCScaling
+// PURPOSE:  Sets the scaling of ADC operands to UserUnits, as from ABFH_GetADCtoUUFactors().
+//
+void CABFMathKernel::SetADCScaling(float fFactorA, float fShiftA, float fFactorB, float fShiftB)
+{
+   m_fFactorA = fFactorA;
+   m_fShiftA  = fShiftA;
+   m_fFactorB = fFactorB;
+   m_fShiftB  = fShiftB;
+}
@@ -0,0 +1,70 @@
+//***********************************************************************************************
+//
+//    Copyright (c) 2005 Molecular Devices.
+//    All rights reserved.
+//    Permission is granted to freely to use, modify and copy the code in this file.
+//
+//***********************************************************************************************
+// HEADER:  MathKernel.hpp
+// PURPOSE: Math channel expressions compiled for evaluation over whole buffers.
+// NOTES:   ABFH_GetMathValue() switches on the expression type and the operator for every
+//          sample. CABFMathKernel makes those choices once, when it is constructed from a
+//          header, and selects a loop specialized for them in which the remaining special
+//          cases (divide by zero, clipping) are selects, so the compiler can vectorize it.
+//          The results are the same as those of ABFH_GetMathValue().
+//
+
+#ifndef INC_MATHKERNEL_HPP
+#define INC_MATHKERNEL_HPP
+
+#include "AxAbfFio32/abfheader.h"
+
+class CABFMathKernel;
+
+// Evaluates uCount samples of the operands pvA[i*uStride] and pvB[i*uStride].
+typedef void (*PFNMATHKERNEL)(const CABFMathKernel &Kernel, const void *pvA, const void *pvB,
+                              UINT uStride, float *pfDest, UINT uCount);
+
+//===============================================================================================
+// CLASS:   CABFMathKernel
+// PURPOSE: The math channel expression of a header, with a loop specialized for it.
+//
+class CABFMathKernel
+{
+public:     // Member variables, read by the kernels.
+   float  m_fK1, m_fK2, m_fK3, m_fK4, m_fK5, m_fK6;
+   float  m_fLowerLimit, m_fUpperLimit;
+   char   m_cOperator;
+
+   // UserUnits scaling of ADC operands.
+   float  m_fFactorA, m_fShiftA;
+   float  m_fFactorB, m_fShiftB;
+
+private:
+   PFNMATHKERNEL m_pfnFloat;
+   PFNMATHKERNEL m_pfnADC;
+
+private:    // Unimplemented copy functions.
+   CABFMathKernel(const CABFMathKernel &);
+   const CABFMathKernel &operator=(const CABFMathKernel &);
+
+public:
+   CABFMathKernel(const ABFFileHeader *pFH);
+
+   // Sets the scaling of ADC operands to UserUnits.
+   void SetADCScaling(float fFactorA, float fShiftA, float fFactorB, float fShiftB);
+
+   // Evaluates the expression for operands in UserUnits.
+   void Evaluate(const float *pfA, const float *pfB, UINT uStride, float *pfDest, UINT uCount) const
+   {
+      m_pfnFloat(*this, pfA, pfB, uStride, pfDest, uCount);
+   }
+
+   // Evaluates the expression for ADC operands, scaled as set by SetADCScaling().
+   void Evaluate(const short *pnA, const short *pnB, UINT uStride, float *pfDest, UINT uCount) const
+   {
+      m_pfnADC(*this, pnA, pnB, uStride, pfDest, uCount);
+   }
+};
+
+#endif   // INC_MATHKERNEL_HPP
@@ -20,6 +20,10 @@
 #include "oldheadr.h"               // old header conversion prototypes
 #include "csynch.hpp"               // Virtual synch array object
 #include "filedesc.hpp"             // File descriptors for ABF files.
+#include "HeaderCache.hpp"          // Persistent cache of parsed headers.
+#include "../adc_convert.h"         // Vectorized ADC to UserUnits conversion.
+#include "DemuxKernels.hpp"         // De-multiplexing kernels specialized by channel count.
+#include "MathKernel.hpp"           // Compiled math channel expressions.
 #include "\AxonDev\Comp\common\ArrayPtr.hpp"   // Smart array pointer template class.
 #include "\AxonDev\Comp\common\FileReadCache.hpp"
 #include "\AxonDev\Comp\AxoUtils32\AxoUtils32.h"     // for AXU_* functions
@@ -37,6 +41,8 @@
 #endif
 
 #define ABF_DEFAULTCHUNKSIZE  8192     // Default chunk size for reading gap-free amd var-len files.
+#define ABF_RANGEBLOCKSIZE    65536    // Samples read at a time by ABF_ReadChannelRange.
+#define ABF_BATCHREADSIZE     (1024*1024) // Bytes read at a time by ABF_ReadEpisodes.
 
 
 // Set USE_DACFILE_FIX to 1 to use the fix (incomplete) for DAC File channels.
@@ -324,6 +330,7 @@ void ABF_Cleanup(void)
          ABF_Close(i, NULL);
       }
    }
+   ABFHC_Close();
 }
 
 //===============================================================================================
@@ -361,6 +368,8 @@ BOOL WINAPI ABF_ReadOpen(LPCSTR szFileName, int *phFile, UINT fFlags, ABFFileHea
    int nError = 0;
    CFileDescriptor *pFI = NULL;
    UINT uDAC = 0;
+   ABFHC_Key CacheKey;
+   BOOL bCacheable = FALSE;
 
    // Get a new file descriptor if available.
    if (!GetNewFileDescriptor(&pFI, phFile, pnError))
@@ -373,11 +382,18 @@ BOOL WINAPI ABF_ReadOpen(LPCSTR szFileName, int *phFile, UINT fFlags, ABFFileHea
       goto RCloseAndAbort;
    }
 
-   // Read the data file parameters.
-   if (!ABFH_ParamReader(pFI->GetFileHandle(), &NewFH, &nError))
+   // Read the data file parameters, from the header cache if this file is in it.
+   if (ABFHC_IsOpen())
+      bCacheable = ABFHC_GetKey(szFileName, &CacheKey);
+   if (!bCacheable || !ABFHC_Lookup(CacheKey, &NewFH, NULL))
    {
-      nError = (nError == ABFH_EUNKNOWNFILETYPE) ? ABF_EUNKNOWNFILETYPE : ABF_EBADPARAMETERS;
-      goto RCloseAndAbort;
+      if (!ABFH_ParamReader(pFI->GetFileHandle(), &NewFH, &nError))
+      {
+         nError = (nError == ABFH_EUNKNOWNFILETYPE) ? ABF_EUNKNOWNFILETYPE : ABF_EBADPARAMETERS;
+         goto RCloseAndAbort;
+      }
+      if (bCacheable && (NewFH.lFileSignature != ABF_REVERSESIGNATURE))
+         ABFHC_Store(CacheKey, &NewFH, NULL);
    }
 
    if (NewFH.lFileSignature == ABF_REVERSESIGNATURE)
@@ -463,6 +479,15 @@ BOOL WINAPI ABF_ReadOpen(LPCSTR szFileName, int *phFile, UINT fFlags, ABFFileHea
    pFI->SetAcquiredEpisodes(*pdwMaxEpi);
    pFI->SetAcquiredSamples(NewFH.lActualAcqLength);
 
+   // Let ABF_GetCachedHeader answer without reading the synch array.
+   if (bCacheable)
+   {
+      ABFHC_SynchSummary Summary;
+      Summary.uMaxSamples = *puMaxSamples;
+      Summary.dwMaxEpi    = *pdwMaxEpi;
+      ABFHC_StoreSummary(CacheKey, &Summary);
+   }
+
    // Seek to start of Data section
    VERIFY(pFI->Seek(GetDataOffset(&NewFH), FILE_BEGIN));
 
@@ -1083,7 +1108,7 @@ static BOOL _SetChunkSize( CFileDescriptor *pFI, ABFFileHeader *pFH,
    // Set header variable for the number of episodes in the file.
    pFH->lActualEpisodes = *pdwMaxEpi;
    pFI->SetAcquiredEpisodes(*pdwMaxEpi);
-   pFI->FreeReadBuffer();
+   pFI->GetEpisodeCache()->Flush();
 
    return TRUE;
 }
@@ -1467,27 +1492,13 @@ static BOOL GetSynchEntry( const ABFFileHeader *pFH, CFileDescriptor *pFI, UINT
 
 
 //===============================================================================================
-// FUNCTION: ABF_MultiplexRead
-// PURPOSE:  This routine reads an episode of data from the data file previously opened.
+// FUNCTION: ReadEpisode
+// PURPOSE:  Reads an episode of data from the data file, bypassing the episode cache.
 //
-// INPUT:
-//   nFile          the file index into the g_FileData structure array
-//   dwEpisode      the episode number to be read. Episodes start at 1
-// 
-// OUTPUT:
-//   pvBuffer       the data buffer for the data
-//   puSizeInSamples the number of valid points in the data buffer
-// 
-BOOL WINAPI ABF_MultiplexRead(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
-                              void *pvBuffer, UINT *puSizeInSamples, int *pnError)
+static BOOL ReadEpisode(CFileDescriptor *pFI, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                        void *pvBuffer, UINT *puSizeInSamples, int *pnError)
 {
    ABFH_ASSERT(pFH);
-   CFileDescriptor *pFI = NULL;
-   if (!GetFileDescriptor(&pFI, nFile, pnError))
-      return FALSE;
-   
-   if (!pFI->CheckEpisodeNumber(dwEpisode))
-      ERRORRETURN(pnError, ABF_EEPISODERANGE);
 
    // Set the sample size in the data.
    UINT uSampleSize = SampleSize(pFH);
@@ -1523,6 +1534,129 @@ BOOL WINAPI ABF_MultiplexRead(int nFile, const ABFFileHeader *pFH, DWORD dwEpiso
    return TRUE;
 }
 
+//===============================================================================================
+// FUNCTION: ReadCachedEpisode
+// PURPOSE:  Returns a complete multiplexed episode from the episode cache of the file descriptor,
+//           reading it from the file if it is not there, and its size in samples.
+//           The episode stays valid until the cache is next used.
+//
+static BOOL ReadCachedEpisode(CFileDescriptor *pFI, const ABFFileHeader *pFH, DWORD dwEpisode,
+                              void **ppvEpisode, UINT *puEpisodeSize, int *pnError)
+{
+   CEpisodeCache *pCache = pFI->GetEpisodeCache();
+   UINT uBytesPerEpisode = UINT(pFH->lNumSamplesPerEpisode) * SampleSize(pFH);
+
+   // Read the whole episode from the ABF file only if it is not already cached.
+   UINT uEpisodeSize = 0;
+   void *pvEpisode = pCache->Find(dwEpisode, uBytesPerEpisode, &uEpisodeSize);
+   if (!pvEpisode)
+   {
+      pvEpisode = pCache->Insert(dwEpisode, uBytesPerEpisode);
+      if (!pvEpisode)
+         ERRORRETURN(pnError, ABF_OUTOFMEMORY);
+
+      if (!ReadEpisode(pFI, pFH, dwEpisode, pvEpisode, &uEpisodeSize, pnError))
+      {
+         pCache->Discard();
+         return FALSE;
+      }
+      pCache->Commit(uEpisodeSize);
+   }
+   *ppvEpisode    = pvEpisode;
+   *puEpisodeSize = uEpisodeSize;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_MultiplexRead
+// PURPOSE:  This routine reads an episode of data from the data file previously opened.
+//
+// INPUT:
+//   nFile          the file index into the g_FileData structure array
+//   dwEpisode      the episode number to be read. Episodes start at 1
+// 
+// OUTPUT:
+//   pvBuffer       the data buffer for the data
+//   puSizeInSamples the number of valid points in the data buffer
+// 
+BOOL WINAPI ABF_MultiplexRead(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                              void *pvBuffer, UINT *puSizeInSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+   
+   if (!pFI->CheckEpisodeNumber(dwEpisode))
+      ERRORRETURN(pnError, ABF_EEPISODERANGE);
+
+   // Episodes go through the cache, so that one read by another call is not read again.
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, dwEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
+
+   UINT uBytesPerEpisode = UINT(pFH->lNumSamplesPerEpisode) * SampleSize(pFH);
+   ARRAYASSERT((BYTE *)pvBuffer, uBytesPerEpisode);
+   memcpy(pvBuffer, pvEpisode, uBytesPerEpisode);
+
+   if (puSizeInSamples)
+      *puSizeInSamples = uEpisodeSize;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_MultiplexReadMapped
+// PURPOSE:  Returns a pointer to an episode of data in a read-only memory mapping of the file,
+//           instead of copying it into a buffer as ABF_MultiplexRead does.
+//           The data is multiplexed, in the native byte order, and is not padded out to a full
+//           episode. It stays valid until the file is closed.
+//           Only files opened for reading are mapped; if ABF_EMAPDATA is returned the episode
+//           can still be read with ABF_MultiplexRead.
+//
+// INPUT:
+//   nFile          the file index into the g_FileData structure array
+//   dwEpisode      the episode number to be read. Episodes start at 1
+// 
+// OUTPUT:
+//   ppvData        a pointer to the data of the episode
+//   puSizeInSamples the number of samples in the episode
+// 
+BOOL WINAPI ABF_MultiplexReadMapped(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                                    const void **ppvData, UINT *puSizeInSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   WPTRASSERT(ppvData);
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+   
+   if (!pFI->CheckEpisodeNumber(dwEpisode))
+      ERRORRETURN(pnError, ABF_EEPISODERANGE);
+
+   Synch SynchEntry;
+   if (!GetSynchEntry( pFH, pFI, dwEpisode, &SynchEntry ))
+      ERRORRETURN(pnError, ABF_EEPISODERANGE);
+
+   // Data still being written would not be in the view.
+   if (!pFI->TestFlag(FI_READONLY))
+      ERRORRETURN(pnError, ABF_EMAPDATA);
+
+   LONGLONG llDataOffset = LONGLONG(GetDataOffset(pFH));
+   if (!pFI->MapData(llDataOffset))
+      ERRORRETURN(pnError, ABF_EMAPDATA);
+
+   UINT uSizeInBytes = UINT(SynchEntry.dwLength) * SampleSize(pFH);
+   const void *pvData = pFI->GetMappedData(llDataOffset + SynchEntry.dwFileOffset, uSizeInBytes);
+   if (!pvData)
+      ERRORRETURN(pnError, ABF_EREADDATA);
+
+   *ppvData = pvData;
+   if (puSizeInSamples)
+      *puSizeInSamples = UINT(SynchEntry.dwLength);
+   return TRUE;
+}
+
 //===============================================================================================
 // FUNCTION: SynchCountToSamples
 // PURPOSE:  Rounds a synch count to the nearest sample count.
@@ -1720,22 +1854,14 @@ static void PackSamples(void *pvSource, void *pvDestination, UINT uSourceLen, UI
    ARRAYASSERT((BYTE *)pvSource, uSourceLen * uSampleSize);
    ARRAYASSERT((BYTE *)pvDestination, (uSourceLen / uSkip) * uSampleSize);
 
-   if (uSampleSize == sizeof(short))
-   {
-      // adjust the starting offset
-      short *piSource      = (short *)pvSource;
-      short *piDestination = (short *)pvDestination;
-      for (UINT i=uFirstSample; i<uSourceLen; i+=uSkip)
-         *piDestination++ = piSource[i];
-   }
-   else 
-   {
-      // adjust the starting offset
-      long *plSource      = (long *)pvSource;
-      long *plDestination = (long *)pvDestination;
-      for (UINT i=uFirstSample; i<uSourceLen; i+=uSkip)
-         *plDestination++ = plSource[i];
-   }
+   if (uFirstSample >= uSourceLen)
+      return;
+
+   // The skip factor is the channel count, so this dispatches to a kernel built for it.
+   UINT uOffset    = uFirstSample % uSkip;
+   UINT uNumFrames = (uSourceLen - uFirstSample + uSkip - 1) / uSkip;
+   DEMUX_Pack((BYTE *)pvSource + (uFirstSample - uOffset) * uSampleSize, pvDestination, uSampleSize,
+              uSkip, uOffset, uNumFrames);
 }
 
 //===============================================================================================
@@ -1755,8 +1881,77 @@ static void ConvertADCToFloats( const ABFFileHeader *pFH, int nChannel, UINT uCh
    float fValToUUFactor, fValToUUShift;
    ABFH_GetADCtoUUFactors( pFH, nChannel, &fValToUUFactor, &fValToUUShift);
 
+   if (uChannelOffset >= uSourceLen)
+      return;
+
+   UINT uNumSamples = (uSourceLen - uChannelOffset + uSkip - 1) / uSkip;
+   adc_to_float_strided(pnSource + uChannelOffset, uSkip, pfDestination, uNumSamples,
+                        fValToUUFactor, fValToUUShift);
+}
+
+//===============================================================================================
+// FUNCTION: ConvertADCToDoubles
+// PURPOSE:  Convert an array of ADC values to UserUnits in double precision, with the
+//           factors from ABFH_GetADCtoUUFactorsD.
+//
+static void ConvertADCToDoubles( const ABFFileHeader *pFH, int nChannel, UINT uChannelOffset, 
+                                 double *pdDestination, const short *pnSource )
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(pdDestination, (UINT)(pFH->lNumSamplesPerEpisode/pFH->nADCNumChannels));
+   ARRAYASSERT(pnSource, (UINT)(pFH->lNumSamplesPerEpisode));
+   
+   UINT uSkip      = (UINT)pFH->nADCNumChannels;
+   UINT uSourceLen = (UINT)pFH->lNumSamplesPerEpisode;
+   
+   double dValToUUFactor, dValToUUShift;
+   ABFH_GetADCtoUUFactorsD( pFH, nChannel, &dValToUUFactor, &dValToUUShift);
+
+   if (uChannelOffset >= uSourceLen)
+      return;
+
+   // Scaled in the same pass as the channel is de-multiplexed.
+   UINT uNumSamples = (uSourceLen - uChannelOffset + uSkip - 1) / uSkip;
+   adc_to_double_strided(pnSource + uChannelOffset, uSkip, pdDestination, uNumSamples,
+                         dValToUUFactor, dValToUUShift);
+}
+
+//===============================================================================================
+// FUNCTION: ConvertFloatsToDoubles
+// PURPOSE:  Widen one channel of a multiplexed array of floats to doubles.
+//
+static void ConvertFloatsToDoubles( const ABFFileHeader *pFH, UINT uChannelOffset, 
+                                    double *pdDestination, const float *pfSource )
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(pdDestination, (UINT)(pFH->lNumSamplesPerEpisode/pFH->nADCNumChannels));
+   ARRAYASSERT(pfSource, (UINT)(pFH->lNumSamplesPerEpisode));
+   
+   UINT uSkip      = (UINT)pFH->nADCNumChannels;
+   UINT uSourceLen = (UINT)pFH->lNumSamplesPerEpisode;
+
    for (UINT i=uChannelOffset; i<uSourceLen; i+=uSkip)
-      *pfDestination++ = pnSource[i] * fValToUUFactor + fValToUUShift;
+      *pdDestination++ = pfSource[i];
+}
+
+//===============================================================================================
+// FUNCTION: WidenInPlace
+// PURPOSE:  Convert floats at the start of a buffer to doubles, in-place.
+//
+static void WidenInPlace(void *pvBuffer, UINT uNumSamples)
+{
+   ARRAYASSERT((double *)pvBuffer, uNumSamples);
+
+   // Works backwards from the end, as each double overwrites the floats that follow it.
+   // The buffer holds both types, so values go through memcpy.
+   BYTE *pby = (BYTE *)pvBuffer;
+   while (uNumSamples-- > 0)
+   {
+      float  fValue;
+      memcpy(&fValue, pby + uNumSamples * sizeof(float), sizeof(fValue));
+      double dValue = fValue;
+      memcpy(pby + uNumSamples * sizeof(double), &dValue, sizeof(dValue));
+   }
 }
 
 //===============================================================================================
@@ -1768,37 +1963,34 @@ static void ConvertInPlace(const ABFFileHeader *pFH, int nChannel, UINT uNumSamp
    ABFH_ASSERT(pFH);
    ARRAYASSERT((float *)pvBuffer, uNumSamples);
    
-   ADC_VALUE *pnSource      = ((ADC_VALUE *)pvBuffer);
-   float     *pfDestination = ((float *)pvBuffer);
-   
    float fValToUUFactor, fValToUUShift;
    ABFH_GetADCtoUUFactors( pFH, nChannel, &fValToUUFactor, &fValToUUShift);
 
-   for (int i=uNumSamples-1; i>=0; i--)
-      pfDestination[i] = pnSource[i] * fValToUUFactor + fValToUUShift;
+   // Works backwards from the end, as each float overwrites the samples that follow it.
+   adc_to_float_inplace(pvBuffer, uNumSamples, fValToUUFactor, fValToUUShift);
 }
 
 //===============================================================================================
 // FUNCTION: ConvertADCToResults
 // PURPOSE:  Get the results array for the math channel.
+//           The number of results written is returned in *puNumResults, if given.
 //
-static BOOL ConvertADCToResults(const ABFFileHeader *pFH, float *pfDestination, short *pnSource)
+static BOOL ConvertADCToResults(const ABFFileHeader *pFH, float *pfDestination, short *pnSource,
+                                UINT *puNumResults=NULL)
 {
    ABFH_ASSERT(pFH);
    ARRAYASSERT(pfDestination, (UINT)(pFH->lNumSamplesPerEpisode/pFH->nADCNumChannels));
    ARRAYASSERT(pnSource, (UINT)(pFH->lNumSamplesPerEpisode));
    UINT uAOffset, uBOffset;
-   short *pnSourceA, *pnSourceB;
 
    int nChannelA = pFH->nArithmeticADCNumA;
    int nChannelB = pFH->nArithmeticADCNumB;
 
-   UINT i, uSkip = pFH->nADCNumChannels;
+   UINT uSkip = pFH->nADCNumChannels;
    UINT uSourceArrayLen = (UINT)pFH->lNumSamplesPerEpisode;
 
    float fValToUUFactorA, fValToUUShiftA;
    float fValToUUFactorB, fValToUUShiftB;
-   float fUserUnitA, fUserUnitB;
 
    if (!ABFH_GetChannelOffset(pFH, nChannelA, &uAOffset))
       return FALSE;
@@ -1809,24 +2001,29 @@ static BOOL ConvertADCToResults(const ABFFileHeader *pFH, float *pfDestination,
    ABFH_GetADCtoUUFactors( pFH, nChannelA, &fValToUUFactorA, &fValToUUShiftA);
    ABFH_GetADCtoUUFactors( pFH, nChannelB, &fValToUUFactorB, &fValToUUShiftB);
 
-   pnSourceA = pnSource + uAOffset;  // adjust the starting offset
-   pnSourceB = pnSource + uBOffset;  // adjust the starting offset
-   uSourceArrayLen -= max(uAOffset, uBOffset);
-   for (i=0; i<uSourceArrayLen; i+=uSkip)
-   {
-      fUserUnitA = pnSourceA[i] * fValToUUFactorA + fValToUUShiftA;
-      fUserUnitB = pnSourceB[i] * fValToUUFactorB + fValToUUShiftB;
+   if (puNumResults)
+      *puNumResults = 0;
+   UINT uLastOffset = max(uAOffset, uBOffset);
+   if (uLastOffset >= uSourceArrayLen)
+      return TRUE;
 
-      ABFH_GetMathValue(pFH, fUserUnitA, fUserUnitB, pfDestination++);
-   }
+   // The expression is compiled once for the whole buffer rather than decoded per sample.
+   CABFMathKernel Kernel(pFH);
+   Kernel.SetADCScaling(fValToUUFactorA, fValToUUShiftA, fValToUUFactorB, fValToUUShiftB);
+   UINT uCount = (uSourceArrayLen - uLastOffset + uSkip - 1) / uSkip;
+   Kernel.Evaluate(pnSource + uAOffset, pnSource + uBOffset, uSkip, pfDestination, uCount);
+   if (puNumResults)
+      *puNumResults = uCount;
    return TRUE;
 }
 
 //===============================================================================================
 // FUNCTION: ConvertToResults
 // PURPOSE:  Fills the math channel array from a multichannel buffer of float's.
+//           The number of results written is returned in *puNumResults, if given.
 //
-static BOOL ConvertToResults(const ABFFileHeader *pFH, float *pfDestination, float *pfSource)
+static BOOL ConvertToResults(const ABFFileHeader *pFH, float *pfDestination, float *pfSource,
+                             UINT *puNumResults=NULL)
 {
    ARRAYASSERT(pfDestination, pFH->lNumSamplesPerEpisode/pFH->nADCNumChannels);
    ARRAYASSERT(pfSource, pFH->lNumSamplesPerEpisode);
@@ -1844,14 +2041,55 @@ static BOOL ConvertToResults(const ABFFileHeader *pFH, float *pfDestination, flo
    if (!ABFH_GetChannelOffset(pFH, nChannelB, &uBOffset))
       return FALSE;
 
-   float *pfSourceA = pfSource + uAOffset;  // adjust the starting offset
-   float *pfSourceB = pfSource + uBOffset;  // adjust the starting offset
-   uSourceArrayLen -= max(uAOffset, uBOffset);
-   for (UINT i=0; i<uSourceArrayLen; i+=uSkip)
-      ABFH_GetMathValue(pFH, pfSourceA[i], pfSourceB[i], pfDestination++);
+   if (puNumResults)
+      *puNumResults = 0;
+   UINT uLastOffset = max(uAOffset, uBOffset);
+   if (uLastOffset >= uSourceArrayLen)
+      return TRUE;
+
+   CABFMathKernel Kernel(pFH);
+   UINT uCount = (uSourceArrayLen - uLastOffset + uSkip - 1) / uSkip;
+   Kernel.Evaluate(pfSource + uAOffset, pfSource + uBOffset, uSkip, pfDestination, uCount);
+   if (puNumResults)
+      *puNumResults = uCount;
    return TRUE;
 }
 
+//===============================================================================================
+// FUNCTION: DemultiplexADC
+// PURPOSE:  Convert every channel of a multiplexed array of ADC values to UserUnits, in one pass.
+//           papfDestination has one buffer per multiplex offset; NULL buffers are skipped.
+//
+static void DemultiplexADC(const ABFFileHeader *pFH, float **papfDestination, const short *pnSource,
+                           UINT uNumFrames)
+{
+   ABFH_ASSERT(pFH);
+   UINT uChannels = (UINT)pFH->nADCNumChannels;
+
+   ASSERT(uChannels <= ABF_ADCCOUNT);
+
+   float afFactor[ABF_ADCCOUNT], afShift[ABF_ADCCOUNT];
+   for (UINT c=0; c<uChannels; c++)
+      ABFH_GetADCtoUUFactors( pFH, pFH->nADCSamplingSeq[c], &afFactor[c], &afShift[c]);
+
+   // Frames are read in order and each channel's buffer is written sequentially.
+   DEMUX_ScaleAllADC(pnSource, papfDestination, uChannels, uNumFrames, afFactor, afShift);
+}
+
+//===============================================================================================
+// FUNCTION: DemultiplexFloats
+// PURPOSE:  Split every channel out of a multiplexed array of floats, in one pass.
+//           papfDestination has one buffer per multiplex offset; NULL buffers are skipped.
+//
+static void DemultiplexFloats(const ABFFileHeader *pFH, float **papfDestination, const float *pfSource,
+                              UINT uNumFrames)
+{
+   ABFH_ASSERT(pFH);
+   UINT uChannels = (UINT)pFH->nADCNumChannels;
+
+   DEMUX_PackAll(pfSource, (void * const *)papfDestination, sizeof(float), uChannels, uNumFrames);
+}
+
 //===============================================================================================
 // FUNCTION: ABF_ReadChannel
 // PURPOSE:  This function reads a complete multiplexed episode from the data file and
@@ -1892,31 +2130,16 @@ BOOL WINAPI ABF_ReadChannel(int nFile, const ABFFileHeader *pFH, int nChannel, D
    // Set the sample size in the data.
    UINT uSampleSize = SampleSize(pFH);
 
-   // Only create the read buffer on demand, it is freed when the file is closed.
-   if (!pFI->GetReadBuffer())
-   {      
-      if (!pFI->AllocReadBuffer(pFH->lNumSamplesPerEpisode * uSampleSize))
-         ERRORRETURN(pnError, ABF_OUTOFMEMORY);
-   }
-
-   // Read the whole episode from the ABF file only if it is not already cached.
-   UINT uEpisodeSize = pFI->GetCachedEpisodeSize();
-   if (dwEpisode != pFI->GetCachedEpisode())
-   {         
-      uEpisodeSize = (UINT)pFH->lNumSamplesPerEpisode;
-      if (!ABF_MultiplexRead(nFile, pFH, dwEpisode, pFI->GetReadBuffer(), &uEpisodeSize, pnError))
-      {
-         pFI->SetCachedEpisode(UINT(-1), 0);
-         return FALSE;
-      }
-      pFI->SetCachedEpisode(dwEpisode, uEpisodeSize);
-   }
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, dwEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
    
    // if data is 2byte ints, convert to floats
    if (pFH->nDataFormat == ABF_INTEGERDATA)
    {
       // Cast the read buffer to the appropriate format.
-      ADC_VALUE *pnReadBuffer = (ADC_VALUE *)pFI->GetReadBuffer();
+      ADC_VALUE *pnReadBuffer = (ADC_VALUE *)pvEpisode;
 
       // A channel number of -1 refers to the results channel
       if (nChannel >= 0)
@@ -1927,7 +2150,7 @@ BOOL WINAPI ABF_ReadChannel(int nFile, const ABFFileHeader *pFH, int nChannel, D
    else     // Data is 4-byte floats.
    {
       // Cast the read buffer to the appropriate format.
-      float *pfReadBuffer = (float *)pFI->GetReadBuffer();
+      float *pfReadBuffer = (float *)pvEpisode;
 
       // A channel number of -1 refers to the results channel
       if (nChannel >= 0)
@@ -1943,6 +2166,117 @@ BOOL WINAPI ABF_ReadChannel(int nFile, const ABFFileHeader *pFH, int nChannel, D
    return TRUE;
 }
 
+//===============================================================================================
+// FUNCTION: ABF_ReadChannelD
+// PURPOSE:  This function reads a complete multiplexed episode from the data file and
+//           then converts a single de-multiplexed channel to "UserUnits" in pdBuffer, in
+//           double precision.
+//           ADC values are scaled in double precision as they are de-multiplexed, rather
+//           than being converted to floats by ABF_ReadChannel and then widened. The factors
+//           are from ABFH_GetADCtoUUFactorsD, so the gains are not rounded to floats either.
+//           The math channel is evaluated as by ABF_ReadChannel and widened.
+//
+// The required size of the passed buffer is:
+// pdBuffer     -> pFH->lNumSamplesPerEpisode / pFH->nADCNumChannels  (doubles)
+//
+BOOL WINAPI ABF_ReadChannelD(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwEpisode, 
+                             double *pdBuffer, UINT *puNumSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(pdBuffer, (UINT)(pFH->lNumSamplesPerEpisode/pFH->nADCNumChannels));
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   if (!pFI->CheckEpisodeNumber(dwEpisode))
+      ERRORRETURN(pnError, ABF_EEPISODERANGE);
+
+   // Get the offset into the multiplexed data array for the first point
+   UINT uChannelOffset;
+   if (!ABFH_GetChannelOffset(pFH, nChannel, &uChannelOffset))
+      ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
+
+   // Even with one channel, the episode is converted from the cache rather than read into
+   // the buffer and converted in-place, as that would take a second pass over it.
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, dwEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
+
+   // A channel number of -1 refers to the results channel
+   if (nChannel < 0)
+   {
+      // Math channel values are floats, so they are evaluated into the buffer and widened.
+      // Only the results written are widened; the rest of the buffer is left as it was.
+      float *pfResults = (float *)pdBuffer;
+      UINT uNumResults = 0;
+      BOOL bOK = (pFH->nDataFormat == ABF_INTEGERDATA)
+               ? ConvertADCToResults(pFH, pfResults, (ADC_VALUE *)pvEpisode, &uNumResults)
+               : ConvertToResults(pFH, pfResults, (float *)pvEpisode, &uNumResults);
+      if (!bOK)
+         ERRORRETURN(pnError, ABF_BADMATHCHANNEL);
+      WidenInPlace(pdBuffer, uNumResults);
+   }
+   else if (pFH->nDataFormat == ABF_INTEGERDATA)
+      ConvertADCToDoubles(pFH, nChannel, uChannelOffset, pdBuffer, (const ADC_VALUE *)pvEpisode);
+   else     // Data is 4-byte floats.
+      ConvertFloatsToDoubles(pFH, uChannelOffset, pdBuffer, (const float *)pvEpisode);
+   
+   // Return the length of the data block.
+   if (puNumSamples)
+      *puNumSamples = uEpisodeSize / pFH->nADCNumChannels;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_ReadAllChannels
+// PURPOSE:  This function reads a complete multiplexed episode from the data file and
+//           de-multiplexes every channel of it to "UserUnits" in a single pass.
+//
+// papfBuffers holds pFH->nADCNumChannels buffers, one per channel in sampling sequence order
+// (the channel of papfBuffers[i] is pFH->nADCSamplingSeq[i]). A NULL entry skips that channel.
+// The required size of each buffer is:
+// papfBuffers[i] -> pFH->lNumSamplesPerEpisode / pFH->nADCNumChannels  (floats)
+//
+BOOL WINAPI ABF_ReadAllChannels(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                                float **papfBuffers, UINT *puNumSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(papfBuffers, (UINT)pFH->nADCNumChannels);
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   if (!pFI->CheckEpisodeNumber(dwEpisode))
+      ERRORRETURN(pnError, ABF_EEPISODERANGE);
+
+   UINT uChannels = (UINT)pFH->nADCNumChannels;
+   if ((uChannels < 1) || (uChannels > ABF_ADCCOUNT))
+      ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
+
+   // With one channel there is nothing to de-multiplex, so use the ABF_ReadChannel path.
+   // A skipped channel goes through the general path, which still returns the length.
+   if ((uChannels == 1) && papfBuffers[0])
+      return ABF_ReadChannel(nFile, pFH, pFH->nADCSamplingSeq[0], dwEpisode, papfBuffers[0],
+                             puNumSamples, pnError);
+
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, dwEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
+
+   UINT uNumFrames = uEpisodeSize / uChannels;
+   if (pFH->nDataFormat == ABF_INTEGERDATA)
+      DemultiplexADC(pFH, papfBuffers, (const ADC_VALUE *)pvEpisode, uNumFrames);
+   else
+      DemultiplexFloats(pFH, papfBuffers, (const float *)pvEpisode, uNumFrames);
+
+   // Return the length of the data block.
+   if (puNumSamples)
+      *puNumSamples = uNumFrames;
+   return TRUE;
+}
+
 //===============================================================================================
 // FUNCTION: ABF_ReadRawChannel
 // PURPOSE:  This function reads a complete multiplexed episode from the data file and
@@ -1976,27 +2310,12 @@ BOOL WINAPI ABF_ReadRawChannel(int nFile, const ABFFileHeader *pFH, int nChannel
    if (pFH->nADCNumChannels == 1)
       return ABF_MultiplexRead(nFile, pFH, dwEpisode, pvBuffer, puNumSamples, pnError);
 
-   // Only create the read buffer on demand, it is freed when the file is closed.
-   if (!pFI->GetReadBuffer())
-   {      
-      if (!pFI->AllocReadBuffer(pFH->lNumSamplesPerEpisode * uSampleSize))
-         ERRORRETURN(pnError, ABF_OUTOFMEMORY);
-   }
-
-   // Read the whole episode from the ABF file only if it is not already cached.
-   UINT uEpisodeSize = pFI->GetCachedEpisodeSize();
-   if (dwEpisode != pFI->GetCachedEpisode())
-   {         
-      uEpisodeSize = (UINT)pFH->lNumSamplesPerEpisode;
-      if (!ABF_MultiplexRead(nFile, pFH, dwEpisode, pFI->GetReadBuffer(), &uEpisodeSize, pnError))
-      {
-         pFI->SetCachedEpisode(UINT(-1), 0);
-         return FALSE;
-      }
-      pFI->SetCachedEpisode(dwEpisode, uEpisodeSize);
-   }
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, dwEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
    
-   PackSamples(pFI->GetReadBuffer(), pvBuffer, uEpisodeSize, uChannelOffset,
+   PackSamples(pvEpisode, pvBuffer, uEpisodeSize, uChannelOffset,
                uSampleSize, pFH->nADCNumChannels);
    
    // Return the length of the data block.
@@ -2005,6 +2324,304 @@ BOOL WINAPI ABF_ReadRawChannel(int nFile, const ABFFileHeader *pFH, int nChannel
    return TRUE;
 }
 
+//===============================================================================================
+// FUNCTION: ABF_ReadChannelRange
+// PURPOSE:  Reads samples [dwFirstSample, dwFirstSample+uNumSamples) of one channel of a gap-free
+//           file, counted from the start of the recording, and converts them to "UserUnits".
+//           The samples are read straight from the data section, across chunk boundaries and
+//           whatever the chunk size set by ABF_SetChunkSize; the episode cache is not used.
+// OUTPUT:
+//   pfBuffer       the samples; uNumSamples floats.
+//   puNumSamples   the number of samples read, fewer than uNumSamples if the range runs past
+//                  the end of the recording.
+//
+BOOL WINAPI ABF_ReadChannelRange(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwFirstSample,
+                                 UINT uNumSamples, float *pfBuffer, UINT *puNumSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(pfBuffer, uNumSamples);
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   if (pFH->nOperationMode != ABF_GAPFREEFILE)
+      ERRORRETURN(pnError, ABF_ENOTGAPFREE);
+
+   // Get the offset into the multiplexed data array for the first point
+   UINT uChannelOffset;
+   if (!ABFH_GetChannelOffset(pFH, nChannel, &uChannelOffset))
+      ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
+
+   // Gap-free data is stored contiguously, even where the recording was paused.
+   UINT uChannels   = (UINT)pFH->nADCNumChannels;
+   UINT uSampleSize = SampleSize(pFH);
+   UINT uRecorded   = UINT(pFH->lActualAcqLength) / uChannels;
+   if (dwFirstSample >= uRecorded)
+      ERRORRETURN(pnError, ABF_ESAMPLERANGE);
+   uNumSamples = min(uNumSamples, uRecorded - UINT(dwFirstSample));
+
+   LONGLONG llOffset = LONGLONG(GetDataOffset(pFH)) + LONGLONG(dwFirstSample) * uChannels * uSampleSize;
+   VERIFY(pFI->Seek(llOffset, FILE_BEGIN));
+
+   // If there is only one channel, read the data directly into the passed buffer,
+   // converting it in-place if required.
+   if ((uChannels == 1) && (nChannel >= 0))
+   {
+      if (!pFI->Read(pfBuffer, uNumSamples * uSampleSize))
+         ERRORRETURN(pnError, ABF_EREADDATA);
+
+      if (pFH->nDataFormat == ABF_INTEGERDATA)
+         ConvertInPlace(pFH, nChannel, uNumSamples, pfBuffer);
+      if (puNumSamples)
+         *puNumSamples = uNumSamples;
+      return TRUE;
+   }
+
+   // Otherwise read whole frames a block at a time and convert the channel out of each block.
+   UINT uBlockFrames = ABF_RANGEBLOCKSIZE / uChannels;
+   CArrayPtr<BYTE> pBlock(uBlockFrames * uChannels * uSampleSize);
+   if (!pBlock)
+      ERRORRETURN(pnError, ABF_OUTOFMEMORY);
+
+   float fValToUUFactor = 1.0F, fValToUUShift = 0.0F;
+   if ((nChannel >= 0) && (pFH->nDataFormat == ABF_INTEGERDATA))
+      ABFH_GetADCtoUUFactors( pFH, nChannel, &fValToUUFactor, &fValToUUShift);
+
+   // A channel number of -1 refers to the results channel
+   CABFMathKernel MathKernel(pFH);
+   UINT uAOffset = 0, uBOffset = 0;
+   if (nChannel < 0)
+   {
+      if (!ABFH_GetChannelOffset(pFH, pFH->nArithmeticADCNumA, &uAOffset) ||
+          !ABFH_GetChannelOffset(pFH, pFH->nArithmeticADCNumB, &uBOffset))
+         ERRORRETURN(pnError, ABF_BADMATHCHANNEL);
+
+      if (pFH->nDataFormat == ABF_INTEGERDATA)
+      {
+         float fValToUUFactorA, fValToUUShiftA;
+         float fValToUUFactorB, fValToUUShiftB;
+         ABFH_GetADCtoUUFactors( pFH, pFH->nArithmeticADCNumA, &fValToUUFactorA, &fValToUUShiftA);
+         ABFH_GetADCtoUUFactors( pFH, pFH->nArithmeticADCNumB, &fValToUUFactorB, &fValToUUShiftB);
+         MathKernel.SetADCScaling(fValToUUFactorA, fValToUUShiftA, fValToUUFactorB, fValToUUShiftB);
+      }
+   }
+
+   for (UINT uDone=0; uDone<uNumSamples; )
+   {
+      UINT uFrames = min(uBlockFrames, uNumSamples - uDone);
+      if (!pFI->Read(pBlock, uFrames * uChannels * uSampleSize))
+         ERRORRETURN(pnError, ABF_EREADDATA);
+
+      float *pfDest = pfBuffer + uDone;
+      if (pFH->nDataFormat == ABF_INTEGERDATA)
+      {
+         const ADC_VALUE *pnBlock = (const ADC_VALUE *)(BYTE *)pBlock;
+         if (nChannel >= 0)
+            adc_to_float_strided(pnBlock + uChannelOffset, uChannels, pfDest, uFrames,
+                                 fValToUUFactor, fValToUUShift);
+         else
+            MathKernel.Evaluate(pnBlock + uAOffset, pnBlock + uBOffset, uChannels, pfDest, uFrames);
+      }
+      else     // Data is 4-byte floats.
+      {
+         const float *pfBlock = (const float *)(BYTE *)pBlock;
+         if (nChannel >= 0)
+            DEMUX_Pack(pfBlock, pfDest, sizeof(float), uChannels, uChannelOffset, uFrames);
+         else
+            MathKernel.Evaluate(pfBlock + uAOffset, pfBlock + uBOffset, uChannels, pfDest, uFrames);
+      }
+      uDone += uFrames;
+   }
+
+   if (puNumSamples)
+      *puNumSamples = uNumSamples;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_ReadEpisodes
+// PURPOSE:  Reads a list or range of episodes and converts one or more channels of each of them
+//           to "UserUnits". Episodes that follow each other in the data section are read
+//           together, so a run of episodes takes one seek and one read rather than one each.
+// INPUT:
+//   pnChannels     the uNumChannels channels to return; -1 is the math channel.
+//   pdwEpisodes    the uNumEpisodes episodes to read, in any order, or NULL to read uNumEpisodes 
+//                  episodes starting at dwFirstEpisode.
+// OUTPUT:
+//   papfBuffers    one buffer per channel in pnChannels, each of uNumEpisodes rows (one per
+//                  episode, in the order requested) of pFH->lNumSamplesPerEpisode / 
+//                  pFH->nADCNumChannels floats.
+//   puNumSamples   optional: uNumEpisodes counts of the samples returned in each row. A short
+//                  final episode of a gap-free file leaves the rest of its row unchanged.
+//
+// The episode cache is not used, the data is read straight from the file.
+//
+BOOL WINAPI ABF_ReadEpisodes(int nFile, const ABFFileHeader *pFH, const int *pnChannels, UINT uNumChannels,
+                             DWORD dwFirstEpisode, const DWORD *pdwEpisodes, UINT uNumEpisodes,
+                             float **papfBuffers, UINT *puNumSamples, int *pnError)
+{
+   ABFH_ASSERT(pFH);
+   ARRAYASSERT(pnChannels, uNumChannels);
+   ARRAYASSERT(papfBuffers, uNumChannels);
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   if ((uNumChannels < 1) || (uNumChannels > ABF_ADCCOUNT+1))
+      ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
+   if (uNumEpisodes == 0)
+      return TRUE;
+
+   UINT uChannels        = (UINT)pFH->nADCNumChannels;
+   UINT uSampleSize      = SampleSize(pFH);
+   UINT uPerChannel      = UINT(pFH->lNumSamplesPerEpisode) / uChannels;
+   UINT uBytesPerEpisode = UINT(pFH->lNumSamplesPerEpisode) * uSampleSize;
+   BOOL bIntegerData     = (pFH->nDataFormat == ABF_INTEGERDATA);
+
+   // Look up each channel once, rather than once per episode.
+   UINT  auOffset[ABF_ADCCOUNT+1];
+   float afFactor[ABF_ADCCOUNT+1], afShift[ABF_ADCCOUNT+1];
+   BOOL  bMath = FALSE;
+   for (UINT c=0; c<uNumChannels; c++)
+   {
+      if (!ABFH_GetChannelOffset(pFH, pnChannels[c], &auOffset[c]))
+         ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
+
+      afFactor[c] = 1.0F;
+      afShift[c]  = 0.0F;
+      if (pnChannels[c] < 0)
+         bMath = TRUE;
+      else if (bIntegerData)
+         ABFH_GetADCtoUUFactors( pFH, pnChannels[c], &afFactor[c], &afShift[c]);
+   }
+
+   CABFMathKernel MathKernel(pFH);
+   UINT uAOffset = 0, uBOffset = 0;
+   if (bMath)
+   {
+      if (!ABFH_GetChannelOffset(pFH, pFH->nArithmeticADCNumA, &uAOffset) ||
+          !ABFH_GetChannelOffset(pFH, pFH->nArithmeticADCNumB, &uBOffset))
+         ERRORRETURN(pnError, ABF_BADMATHCHANNEL);
+
+      if (bIntegerData)
+      {
+         float fValToUUFactorA, fValToUUShiftA;
+         float fValToUUFactorB, fValToUUShiftB;
+         ABFH_GetADCtoUUFactors( pFH, pFH->nArithmeticADCNumA, &fValToUUFactorA, &fValToUUShiftA);
+         ABFH_GetADCtoUUFactors( pFH, pFH->nArithmeticADCNumB, &fValToUUFactorB, &fValToUUShiftB);
+         MathKernel.SetADCScaling(fValToUUFactorA, fValToUUShiftA, fValToUUFactorB, fValToUUShiftB);
+      }
+   }
+
+   // Runs of episodes are read into a buffer that holds at least one episode.
+   UINT uBufferSize = max(uBytesPerEpisode, UINT(ABF_BATCHREADSIZE));
+   CArrayPtr<BYTE> pBuffer(uBufferSize);
+   if (!pBuffer)
+      ERRORRETURN(pnError, ABF_OUTOFMEMORY);
+
+   // Synch entries of the run that is in the buffer; short episodes may make it any length.
+   CArrayPtr<Synch> pRun(uNumEpisodes);
+   if (!pRun)
+      ERRORRETURN(pnError, ABF_OUTOFMEMORY);
+
+   UINT i = 0;
+   while (i < uNumEpisodes)
+   {
+      // Extend the run while the next episode follows on in the file and still fits.
+      UINT uRun = 0, uRunBytes = 0;
+      for (; i+uRun < uNumEpisodes; uRun++)
+      {
+         DWORD dwEpisode = pdwEpisodes ? pdwEpisodes[i+uRun] : dwFirstEpisode + i + uRun;
+         Synch SynchEntry;
+         if (!GetSynchEntry( pFH, pFI, dwEpisode, &SynchEntry ))
+            ERRORRETURN(pnError, ABF_EEPISODERANGE);
+         ASSERT(SynchEntry.dwLength <= UINT(pFH->lNumSamplesPerEpisode));
+
+         UINT uBytes = SynchEntry.dwLength * uSampleSize;
+         if ((uRun > 0) && 
+             ((SynchEntry.dwFileOffset != pRun[0].dwFileOffset + uRunBytes) ||
+              (uRunBytes + uBytes > uBufferSize)))
+            break;
+
+         pRun[uRun] = SynchEntry;
+         uRunBytes += uBytes;
+      }
+
+      // Read the whole run at once.
+      VERIFY(pFI->Seek(LONGLONG(GetDataOffset(pFH)) + pRun[0].dwFileOffset, FILE_BEGIN));
+      if (!pFI->Read(pBuffer, uRunBytes))
+         ERRORRETURN(pnError, ABF_EREADDATA);
+
+      // Convert each episode of it into its row of each channel.
+      BYTE *pbyEpisode = pBuffer;
+      for (UINT e=0; e<uRun; e++, i++)
+      {
+         UINT uFrames = pRun[e].dwLength / uChannels;
+         for (UINT c=0; c<uNumChannels; c++)
+         {
+            float *pfDest = papfBuffers[c] + i * uPerChannel;
+            if (bIntegerData)
+            {
+               const ADC_VALUE *pnEpisode = (const ADC_VALUE *)pbyEpisode;
+               if (pnChannels[c] >= 0)
+                  adc_to_float_strided(pnEpisode + auOffset[c], uChannels, pfDest, uFrames,
+                                       afFactor[c], afShift[c]);
+               else
+                  MathKernel.Evaluate(pnEpisode + uAOffset, pnEpisode + uBOffset, uChannels, pfDest, uFrames);
+            }
+            else     // Data is 4-byte floats.
+            {
+               const float *pfEpisode = (const float *)pbyEpisode;
+               if (pnChannels[c] >= 0)
+                  DEMUX_Pack(pfEpisode, pfDest, sizeof(float), uChannels, auOffset[c], uFrames);
+               else
+                  MathKernel.Evaluate(pfEpisode + uAOffset, pfEpisode + uBOffset, uChannels, pfDest, uFrames);
+            }
+         }
+         if (puNumSamples)
+            puNumSamples[i] = uFrames;
+         pbyEpisode += pRun[e].dwLength * uSampleSize;
+      }
+   }
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_SetEpisodeCacheSize
+// PURPOSE:  Sets the number of bytes of episodes that are kept in memory for a file, to be
+//           shared by ABF_MultiplexRead, ABF_ReadChannel, ABF_ReadAllChannels and
+//           ABF_ReadRawChannel. The least recently read episodes are freed first.
+// NOTES:    The most recently read episode is always kept, so 0 caches a single episode.
+//
+BOOL WINAPI ABF_SetEpisodeCacheSize(int nFile, UINT uMaxBytes, int *pnError)
+{
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   pFI->GetEpisodeCache()->SetBudget(uMaxBytes);
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_GetEpisodeCacheStats
+// PURPOSE:  Returns the number of episode reads for a file that were served from the episode
+//           cache, and the number that had to be read from the file, since it was opened.
+//
+BOOL WINAPI ABF_GetEpisodeCacheStats(int nFile, UINT *puHits, UINT *puMisses, int *pnError)
+{
+   CFileDescriptor *pFI = NULL;
+   if (!GetFileDescriptor(&pFI, nFile, pnError))
+      return FALSE;
+
+   CEpisodeCache *pCache = pFI->GetEpisodeCache();
+   if (puHits)
+      *puHits = pCache->GetHits();
+   if (puMisses)
+      *puMisses = pCache->GetMisses();
+   return TRUE;
+}
+
                                    
 //===============================================================================================
 // FUNCTION: ABF_ReadDACFileEpi
@@ -2165,11 +2782,13 @@ static void ScaleDACBuffer(const ABFFileHeader *pFH, UINT uDACChannel, UINT uADC
 
 #if USE_DACFILE_FIX
    UINT uNumDACFileChannels = pFH->nADCNumChannels + s_nFudgeChannels;
-   for (UINT i=uADCChannelOffset; i<uNumSamples; i+=uNumDACFileChannels)
 #else
-   for (UINT i=uADCChannelOffset; i<uNumSamples; i++)
+   UINT uNumDACFileChannels = 1;
 #endif
-      *pfBuffer++ = pnReadBuffer[i] * fDACToUUFactor + fDACToUUShift;
+   if (uADCChannelOffset < uNumSamples)
+      adc_to_float_strided(pnReadBuffer + uADCChannelOffset, uNumDACFileChannels, pfBuffer,
+                           (uNumSamples - uADCChannelOffset + uNumDACFileChannels - 1) / uNumDACFileChannels,
+                           fDACToUUFactor, fDACToUUShift);
 }
 
 //===============================================================================================
@@ -3398,31 +4017,15 @@ BOOL WINAPI ABF_UpdateEpisodeSamples(int nFile, const ABFFileHeader *pFH, int nC
    if (!ABFH_GetChannelOffset(pFH, nChannel, &uChannelOffset))
       ERRORRETURN(pnError, ABF_EINVALIDCHANNEL);
 
-   // Set the sample size in the data.
-   UINT uSampleSize = SampleSize(pFH);
-
-   // Only create the read buffer on demand, it is freed when the file is closed.
-   if (!pFI->GetReadBuffer())
-   {      
-      if (!pFI->AllocReadBuffer(pFH->lNumSamplesPerEpisode * uSampleSize))
-         ERRORRETURN(pnError, ABF_OUTOFMEMORY);
-   }
-
    // Read the whole episode from the ABF file only if it is not already cached.
-   if (uEpisode != pFI->GetCachedEpisode())
-   {         
-      UINT uEpisodeSize = (UINT)pFH->lNumSamplesPerEpisode;
-      if (!ABF_MultiplexRead(nFile, pFH, uEpisode, pFI->GetReadBuffer(), &uEpisodeSize, pnError))
-      {
-         pFI->SetCachedEpisode(UINT(-1), 0);
-         return FALSE;
-      }
-      pFI->SetCachedEpisode(uEpisode, uEpisodeSize);
-   }
+   void *pvEpisode   = NULL;
+   UINT uEpisodeSize = 0;
+   if (!ReadCachedEpisode(pFI, pFH, uEpisode, &pvEpisode, &uEpisodeSize, pnError))
+      return FALSE;
 
    // Update the samples in the episode cache.
    UINT   uEpisodeOffset = uStartSample * pFH->nADCNumChannels;
-   float *pfEpisodeBuffer = (float *)pFI->GetReadBuffer() + uEpisodeOffset;
+   float *pfEpisodeBuffer = (float *)pvEpisode + uEpisodeOffset;
    float *pfData = pfEpisodeBuffer + uChannelOffset;
    for (UINT i=0; i<uNumSamples; i++)
    {
@@ -3774,6 +4377,69 @@ BOOL WINAPI ABF_ValidateFileCRC( int nFile, int *pnError )
    return TRUE;
 }
 
+
+//===============================================================================================
+// FUNCTION: ABF_SetHeaderCache
+// PURPOSE:  Opens a persistent cache of parsed headers that ABF_ReadOpen consults before it
+//           decodes a file header, creating it with room for uMaxEntries files (0 = default).
+//           Pass NULL to close the cache.
+// NOTES:    The cache file may be shared by several processes. Entries are keyed by file
+//           identity and modification time, so a changed file is decoded again.
+//           This function must not be called while another thread is opening a file.
+//
+BOOL WINAPI ABF_SetHeaderCache( LPCSTR szCacheFile, UINT uMaxEntries, int *pnError )
+{
+   if (szCacheFile == NULL)
+   {
+      ABFHC_Close();
+      return TRUE;
+   }
+
+   LPSZASSERT(szCacheFile);
+   if (!ABFHC_Open(szCacheFile, uMaxEntries))
+      ERRORRETURN(pnError, ABF_EHEADERCACHE);
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: ABF_GetCachedHeader
+// PURPOSE:  Returns the header of a data file from the header cache, without opening it.
+// OUTPUT:
+//   pFH            the header as ABF_ReadOpen would return it.
+//   puMaxSamples   optional: as returned by ABF_ReadOpen, 0 if the file was only opened 
+//                  as a parameter file.
+//   pdwMaxEpi      optional: as returned by ABF_ReadOpen, 0 if not known.
+// RETURNS:  FALSE with ABF_ENOTCACHED if the file has not been opened with the cache in use
+//           since it last changed.
+//
+BOOL WINAPI ABF_GetCachedHeader( LPCSTR szFileName, ABFFileHeader *pFH, UINT *puMaxSamples, 
+                                 DWORD *pdwMaxEpi, int *pnError )
+{
+   LPSZASSERT(szFileName);
+   ABFH_WASSERT(pFH);
+
+   // Take a copy of the passed in header to ensure it is 6k long.
+   ABFFileHeader NewFH;
+   ABFH_PromoteHeader( &NewFH, pFH );
+
+   ABFHC_Key CacheKey;
+   ABFHC_SynchSummary Summary;
+   if (!ABFHC_IsOpen())
+      ERRORRETURN(pnError, ABF_EHEADERCACHE);
+   if (!ABFHC_GetKey(szFileName, &CacheKey) || !ABFHC_Lookup(CacheKey, &NewFH, &Summary))
+      ERRORRETURN(pnError, ABF_ENOTCACHED);
+
+   if (Summary.uMaxSamples)
+      NewFH.lActualEpisodes = Summary.dwMaxEpi;
+   if (puMaxSamples)
+      *puMaxSamples = Summary.uMaxSamples;
+   if (pdwMaxEpi)
+      *pdwMaxEpi = Summary.dwMaxEpi;
+
+   ABFH_DemoteHeader( pFH, &NewFH );
+   return TRUE;
+}
+
   
 //***********************************************************************************************
 //***********************************************************************************************
@@ -68,6 +68,11 @@ extern "C" {
 #define ABF_EREADANNOTATION         1039
 #define ABF_ENOANNOTATIONS          1040
 #define ABF_ECRCVALIDATIONFAILED    1041
+#define ABF_EHEADERCACHE            1042
+#define ABF_ENOTCACHED              1043
+#define ABF_ENOTGAPFREE             1044
+#define ABF_ESAMPLERANGE            1045
+#define ABF_EMAPDATA                1046
 
 // Notifications that can be passed to the registered callback function.
 #define ABF_NVOICETAGSTART    2000
@@ -114,6 +119,9 @@ BOOL WINAPI ABF_Close(int nFile, int *pnError);
 BOOL WINAPI ABF_MultiplexRead(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
                               void *pvBuffer, UINT *puSizeInSamples, int *pnError);
 
+BOOL WINAPI ABF_MultiplexReadMapped(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                                    const void **ppvData, UINT *puSizeInSamples, int *pnError);
+
 BOOL WINAPI ABF_MultiplexWrite(int nFile, ABFFileHeader *pFH, UINT uFlags, const void *pvBuffer, 
                                DWORD dwEpiStart, UINT uSizeInSamples, int *pnError);
 
@@ -121,9 +129,25 @@ BOOL WINAPI ABF_WriteRawData(int nFile, const void *pvBuffer, DWORD dwSizeInByte
 
 BOOL WINAPI ABF_ReadChannel(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwEpisode, 
                             float *pfBuffer, UINT *puNumSamples, int *pnError);
+
+BOOL WINAPI ABF_ReadChannelD(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwEpisode, 
+                             double *pdBuffer, UINT *puNumSamples, int *pnError);
+
+BOOL WINAPI ABF_ReadAllChannels(int nFile, const ABFFileHeader *pFH, DWORD dwEpisode, 
+                                float **papfBuffers, UINT *puNumSamples, int *pnError);
                                    
 BOOL WINAPI ABF_ReadRawChannel(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwEpisode, 
                                void *pvBuffer, UINT *puNumSamples, int *pnError);
+
+BOOL WINAPI ABF_ReadChannelRange(int nFile, const ABFFileHeader *pFH, int nChannel, DWORD dwFirstSample,
+                                 UINT uNumSamples, float *pfBuffer, UINT *puNumSamples, int *pnError);
+
+BOOL WINAPI ABF_ReadEpisodes(int nFile, const ABFFileHeader *pFH, const int *pnChannels, UINT uNumChannels,
+                             DWORD dwFirstEpisode, const DWORD *pdwEpisodes, UINT uNumEpisodes,
+                             float **papfBuffers, UINT *puNumSamples, int *pnError);
+
+BOOL WINAPI ABF_SetEpisodeCacheSize(int nFile, UINT uMaxBytes, int *pnError);
+BOOL WINAPI ABF_GetEpisodeCacheStats(int nFile, UINT *puHits, UINT *puMisses, int *pnError);
                                    
 BOOL WINAPI ABF_ReadDACFileEpi(int nFile, const ABFFileHeader *pFH, short *pnDACArray,
                                DWORD dwEpisode, int *pnError);
@@ -248,6 +272,10 @@ BOOL WINAPI ABF_ParseStringAnnotation( LPCSTR pszAnn, LPSTR pszName, UINT uSizeN
 
 BOOL WINAPI ABF_ValidateFileCRC(  int nFile, int *pnError );
 
+BOOL WINAPI ABF_SetHeaderCache( LPCSTR szCacheFile, UINT uMaxEntries, int *pnError );
+BOOL WINAPI ABF_GetCachedHeader( LPCSTR szFileName, ABFFileHeader *pFH, UINT *puMaxSamples, 
+                                 DWORD *pdwMaxEpi, int *pnError );
+
 #ifdef __cplusplus
 }
 #endif
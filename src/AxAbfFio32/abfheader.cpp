@@ -611,6 +611,45 @@ void WINAPI ABFH_GetADCtoUUFactors( const ABFFileHeader *pFH, int nChannel,
    *pfADCToUUShift  = -fInputOffset;
 }
 
+//==============================================================================================
+// FUNCTION:   GetADCtoUUFactorsD
+// PURPOSE:    As ABFH_GetADCtoUUFactors, with the gains combined in double precision so that
+//             the factor is not rounded to a float, which matters most at high gains.
+// PARAMETERS:
+//    nChannel        - The physical channel number to get the factors for.
+//    pdADCToUUFactor - Pointers to return locations for scale and offset.
+//    pdADCToUUShift    UserUnits = ADCValue * dADCToUUFactor + dADCToUUShift;
+//
+void WINAPI ABFH_GetADCtoUUFactorsD( const ABFFileHeader *pFH, int nChannel, 
+                                     double *pdADCToUUFactor, double *pdADCToUUShift )
+{
+   ABFH_ASSERT(pFH);
+   WPTRASSERT(pdADCToUUFactor);
+   WPTRASSERT(pdADCToUUShift);
+   ASSERT(nChannel < ABF_ADCCOUNT);
+
+   double dTotalScaleFactor = double(pFH->fInstrumentScaleFactor[nChannel]) *
+                              pFH->fADCProgrammableGain[nChannel];
+   if (pFH->nSignalType != 0)
+      dTotalScaleFactor *= pFH->fSignalGain[nChannel];
+
+   // Adjust for the telegraphed gain.
+   if( pFH->nTelegraphEnable[nChannel] )
+      dTotalScaleFactor *= pFH->fTelegraphAdditGain[nChannel];
+
+   ASSERT(dTotalScaleFactor != 0.0);
+   if (dTotalScaleFactor==0.0)
+      dTotalScaleFactor = 1.0;
+
+   double dInputRange = pFH->fADCRange / dTotalScaleFactor;
+   double dInputOffset= -double(pFH->fInstrumentOffset[nChannel]);
+   if (pFH->nSignalType != 0)
+      dInputOffset += pFH->fSignalOffset[nChannel];
+
+   *pdADCToUUFactor = dInputRange / pFH->lADCResolution;
+   *pdADCToUUShift  = -dInputOffset;
+}
+
 //==============================================================================================
 // FUNCTION:   ABFH_GetADCDisplayRange
 // PURPOSE:    Calculates the upper and lower limits of the display given the display
@@ -1538,14 +1577,14 @@ SHOW_STRUCT_SIZE(ABFDelta);
 // If there is a compiler error here, it means the struct in question is the wrong size
 // - fix it in ABFHEADR.H
 
-char FH     [sizeof(ABFFileHeader) == ABF_HEADERSIZE ? 1 : 0];
-char LogF   [sizeof(ABFLogFont) == 40 ? 1 : 0];
-char Signal [sizeof(ABFSignal) == 34 ? 1 : 0];
-char SC     [sizeof(ABFScopeConfig) == 769 ? 1 : 0];
-char Synch  [sizeof(ABFSynch) == 8 ? 1 : 0];
-char Tag    [sizeof(ABFTag) == 64 ? 1 : 0];
-char VTag   [sizeof(ABFVoiceTagInfo) == 32 ? 1 : 0];
-char Delta  [sizeof(ABFDelta) == 12 ? 1 : 0];
+static_assert(sizeof(ABFFileHeader) == ABF_HEADERSIZE, "ABFFileHeader");
+static_assert(sizeof(ABFLogFont) == 40,                "ABFLogFont");
+static_assert(sizeof(ABFSignal) == 34,                 "ABFSignal");
+static_assert(sizeof(ABFScopeConfig) == 769,           "ABFScopeConfig");
+static_assert(sizeof(ABFSynch) == 8,                   "ABFSynch");
+static_assert(sizeof(ABFTag) == 64,                    "ABFTag");
+static_assert(sizeof(ABFVoiceTagInfo) == 32,           "ABFVoiceTagInfo");
+static_assert(sizeof(ABFDelta) == 12,                  "ABFDelta");
 
 #endif   // SHOW_STRUCT_SIZES
 
@@ -1279,6 +1279,8 @@ void WINAPI ABFH_GetADCDisplayRange( const ABFFileHeader *pFH, int nChannel,
                                      
 void WINAPI ABFH_GetADCtoUUFactors( const ABFFileHeader *pFH, int nChannel, 
                                     float *pfADCToUUFactor, float *pfADCToUUShift );
+void WINAPI ABFH_GetADCtoUUFactorsD( const ABFFileHeader *pFH, int nChannel, 
+                                     double *pdADCToUUFactor, double *pdADCToUUShift );
 void WINAPI ABFH_ClipADCUUValue(const ABFFileHeader *pFH, int nChannel, float *pfUUValue);
                                            
 void WINAPI ABFH_GetDACtoUUFactors( const ABFFileHeader *pFH, int nChannel, 
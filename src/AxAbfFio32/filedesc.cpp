@@ -13,6 +13,16 @@
 #include "wincpp.hpp"
 #include "filedesc.hpp"
 
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Views start on a multiple of the allocation granularity of MapViewOfFile().
+#define MAPPING_ALIGNMENT  65536
+
 //===============================================================================================
 // FUNCTION: Constructor
 // PURPOSE:  Initialize the object
@@ -22,14 +32,17 @@ CFileDescriptor::CFileDescriptor()
    MEMBERASSERT();
    m_uLastEpiSize       = 0;
    m_uFlags             = 0;
-   m_pvReadBuffer       = NULL;
-   m_uCachedEpisode     = UINT(-1);
-   m_uCachedEpisodeSize = 0;
    m_uAcquiredEpisodes  = 0;
    m_uAcquiredSamples   = 0;
    m_bHasOverlappedData = FALSE;
    m_nLastError         = 0;
    m_szFileName[0]      = '\0';
+   m_pbyMapping         = NULL;
+   m_uMappingBytes      = 0;
+   m_llMappingOffset    = 0;
+#ifdef _WINDOWS
+   m_hMapping           = NULL;
+#endif
 }
 
 //===============================================================================================
@@ -39,7 +52,7 @@ CFileDescriptor::CFileDescriptor()
 CFileDescriptor::~CFileDescriptor()
 {
    MEMBERASSERT();
-   FreeReadBuffer();
+   UnmapData();
 }
 
 //===============================================================================================
@@ -118,6 +131,89 @@ BOOL CFileDescriptor::Reopen(BOOL bReadOnly)
    return TRUE;
 }
 
+//===============================================================================================
+// FUNCTION: MapData
+// PURPOSE:  Maps the file read-only from llFirstByte to its end, if it is not already mapped.
+//           The view is kept until the object is deleted, so pointers into it stay valid.
+//
+BOOL CFileDescriptor::MapData(LONGLONG llFirstByte)
+{
+   MEMBERASSERT();
+   if (m_pbyMapping)
+      return (llFirstByte >= m_llMappingOffset);
+
+   LONGLONG llStart = llFirstByte - (llFirstByte % MAPPING_ALIGNMENT);
+   LONGLONG llBytes = GetFileSize() - llStart;
+   if ((llBytes <= 0) || (LONGLONG(size_t(llBytes)) != llBytes))
+      return FALSE;
+
+#ifdef _WINDOWS
+   m_hMapping = CreateFileMapping( GetFileHandle(), NULL, PAGE_READONLY, 0, 0, NULL );
+   if (!m_hMapping)
+      return FALSE;
+   m_pbyMapping = (BYTE *)MapViewOfFile( m_hMapping, FILE_MAP_READ, DWORD(llStart >> 32),
+                                         DWORD(llStart & 0xFFFFFFFF), size_t(llBytes) );
+   if (!m_pbyMapping)
+   {
+      CloseHandle( m_hMapping );
+      m_hMapping = NULL;
+      return FALSE;
+   }
+#else
+   int fd = open( m_szFileName, O_RDONLY );
+   if (fd < 0)
+      return FALSE;
+   void *pv = mmap( NULL, size_t(llBytes), PROT_READ, MAP_SHARED, fd, off_t(llStart) );
+   close( fd );
+   if (pv == MAP_FAILED)
+      return FALSE;
+   m_pbyMapping = (BYTE *)pv;
+#endif
+
+   m_uMappingBytes   = size_t(llBytes);
+   m_llMappingOffset = llStart;
+   return TRUE;
+}
+
+//===============================================================================================
+// FUNCTION: GetMappedData
+// PURPOSE:  Returns a pointer to uBytes at the file offset llOffset in the view.
+// RETURNS:  NULL if the data is not all in the view.
+//
+const void *CFileDescriptor::GetMappedData(LONGLONG llOffset, UINT uBytes) const
+{
+   MEMBERASSERT();
+   if (!m_pbyMapping || (llOffset < m_llMappingOffset))
+      return NULL;
+
+   LONGLONG llStart = llOffset - m_llMappingOffset;
+   if (llStart + uBytes > LONGLONG(m_uMappingBytes))
+      return NULL;
+   return m_pbyMapping + size_t(llStart);
+}
+
+//===============================================================================================
+// FUNCTION: UnmapData
+// PURPOSE:  Releases the view mapped by MapData().
+//
+void CFileDescriptor::UnmapData()
+{
+   MEMBERASSERT();
+#ifdef _WINDOWS
+   if (m_pbyMapping)
+      UnmapViewOfFile( m_pbyMapping );
+   if (m_hMapping)
+      CloseHandle( m_hMapping );
+   m_hMapping = NULL;
+#else
+   if (m_pbyMapping)
+      munmap( m_pbyMapping, m_uMappingBytes );
+#endif
+   m_pbyMapping      = NULL;
+   m_uMappingBytes   = 0;
+   m_llMappingOffset = 0;
+}
+
 //===============================================================================================
 // FUNCTION: GetFileName
 // PURPOSE:  Return the name of the file.
@@ -276,63 +372,6 @@ UINT CFileDescriptor::GetAcquiredSamples() const
 }
 
 
-//===============================================================================================
-// FUNCTION: AllocReadBuffer
-// PURPOSE:  Allocates the read buffer and resets the cached episode.
-//
-BOOL CFileDescriptor::AllocReadBuffer(UINT uBytes)
-{
-   MEMBERASSERT();
-   FreeReadBuffer();
-   m_pvReadBuffer = malloc(uBytes);
-   return (m_pvReadBuffer!=NULL);
-}
-
-//===============================================================================================
-// FUNCTION: FreeReadBuffer
-// PURPOSE:  Frees the read buffer and resets the cached episode.
-//
-void CFileDescriptor::FreeReadBuffer()
-{
-   MEMBERASSERT();
-   if (m_pvReadBuffer != NULL)
-      free(m_pvReadBuffer);
-   m_pvReadBuffer = NULL;
-   m_uCachedEpisode = UINT(-1);
-   m_uCachedEpisodeSize = 0;
-}
-
-//===============================================================================================
-// FUNCTION: SetCachedEpisode
-// PURPOSE:  Sets the count and size of the cached episode.
-//
-void CFileDescriptor::SetCachedEpisode(UINT uEpisode, UINT uEpisodeSize)
-{
-   MEMBERASSERT();
-   m_uCachedEpisode     = uEpisode;
-   m_uCachedEpisodeSize = uEpisodeSize;
-}
-
-//===============================================================================================
-// FUNCTION: GetCachedEpisode
-// PURPOSE:  Gets the count of the cached episode.
-//
-UINT CFileDescriptor::GetCachedEpisode() const
-{
-   MEMBERASSERT();
-   return m_uCachedEpisode;
-}
-
-//===============================================================================================
-// FUNCTION: GetCachedEpisodeSize
-// PURPOSE:  Gets the size of the cached episode.
-//
-UINT CFileDescriptor::GetCachedEpisodeSize() const
-{
-   MEMBERASSERT();
-   return m_uCachedEpisodeSize;
-}
-
 //===============================================================================================
 // FUNCTION: SetLastEpiSize
 // PURPOSE:  Sets the size of the last episode.
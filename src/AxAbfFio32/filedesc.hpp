@@ -22,6 +22,7 @@
 #include "voicetag.hpp"             // Array of voice tag descriptors.
 #include "notify.hpp"               // CABFNotify class -- wraps ABFCallback function.
 #include "SimpleStringCache.hpp"    // Virtual annotations object
+#include "EpisodeCache.hpp"         // Cache of episodes read for de-multiplexing.
 
 #define FI_PARAMFILE  0x0001
 #define FI_READONLY   0x0002
@@ -45,18 +46,25 @@ private:    // Member variables.
 
    UINT           m_uAcquiredEpisodes;  // The number of episodes written to this file.
    UINT           m_uAcquiredSamples;   // The total number of samples written to this file.
-   void          *m_pvReadBuffer;       // Buffer to be used for de-multiplexing data
-   UINT           m_uCachedEpisode;     // Episode number for the episode cached in the read buffer.
-   UINT           m_uCachedEpisodeSize; // Size of the cached episode.
+   CEpisodeCache  m_EpisodeCache;       // Episodes read for de-multiplexing data.
    UINT           m_uLastEpiSize;       // The size of the last episode for continuous files
    BOOL           m_bHasOverlappedData; // TRUE if the file contains overlapped data.
    char           m_szFileName[_MAX_PATH];
+
+   BYTE          *m_pbyMapping;         // Read-only view of the file from the data section.
+   size_t         m_uMappingBytes;      // The size of the view.
+   LONGLONG       m_llMappingOffset;    // The file offset of the start of the view.
+#ifdef _WINDOWS
+   HANDLE         m_hMapping;           // The file mapping object of the view.
+#endif
    
    CSimpleStringCache   m_Annotations;        // The annotations writing object.
    
 private:
    CFileDescriptor(const CFileDescriptor &FI);
    const CFileDescriptor &operator=(const CFileDescriptor &FI);
+
+   void  UnmapData();
    
 public:   
    CFileDescriptor();
@@ -84,13 +92,11 @@ public:
    void  SetAcquiredSamples(UINT uSamples);  
    UINT  GetAcquiredSamples() const;  
 
-   BOOL  AllocReadBuffer(UINT uBytes);
-   void  FreeReadBuffer();
-   void *GetReadBuffer();       // Buffer to be used for de-multiplexing data
+   CEpisodeCache *GetEpisodeCache();   // Episodes read for de-multiplexing data.
 
-   void  SetCachedEpisode(UINT uEpisode, UINT uEpisodeSize);
-   UINT  GetCachedEpisode() const;
-   UINT  GetCachedEpisodeSize() const; // Size of the cached episode.
+   // Read-only mapping of the file, which stays valid until the file is closed.
+   BOOL  MapData(LONGLONG llFirstByte);
+   const void *GetMappedData(LONGLONG llOffset, UINT uBytes) const;
 
    void  SetLastEpiSize(UINT uEpiSize);
    UINT  GetLastEpiSize() const;
@@ -239,13 +245,13 @@ inline BOOL CFileDescriptor::GetSynchEntry( UINT uEpisode, Synch *pSynch )
 }
 
 //===============================================================================================
-// FUNCTION: GetReadBuffer
-// PURPOSE:  returns a pointer to the read buffer.
+// FUNCTION: GetEpisodeCache
+// PURPOSE:  returns a pointer to the cache of episodes read for de-multiplexing.
 //
-inline void *CFileDescriptor::GetReadBuffer()
+inline CEpisodeCache *CFileDescriptor::GetEpisodeCache()
 {
    MEMBERASSERT();
-   return m_pvReadBuffer;
+   return &m_EpisodeCache;
 }
 
 #endif   // INC_FILEDESC_HPP
@@ -0,0 +1,27 @@
+#ifndef ABF2_LAYOUT_HPP
+#define ABF2_LAYOUT_HPP
+
+// Compile-time layouts for the records in abf2_struct.h (C++ only)
+//
+// The structs in abf2_struct.h are naturally aligned, so they cannot
+// be read from the file directly. ABFLayoutOf<abf2_...>::Decode
+// fills one from its packed bytes with code generated entirely at
+// compile time from the field lists in ABFFIO/StructLayout.hpp; it is
+// the inlined counterpart of abf2_decode() in abf2_records.h.
+
+#include "abf2_struct.h"
+#include "ABFFIO/StructLayout.hpp"
+
+ABF_DEFINE_LAYOUT(guid,                  16, ABF2_GUID_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_section,          16, ABF2_SECTION_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_fileinfo,        512, ABF2_FILEINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_protocolinfo,    512, ABF2_PROTOCOLINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_mathinfo,        128, ABF2_MATHINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_adcinfo,         128, ABF2_ADCINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_dacinfo,         256, ABF2_DACINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_epochinfoperdac,  48, ABF2_EPOCHINFOPERDAC_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_epochinfo,        32, ABF2_EPOCHINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_statsregioninfo, 128, ABF2_STATSREGIONINFO_FIELDS);
+ABF_DEFINE_LAYOUT(abf2_userlistinfo,     64, ABF2_USERLISTINFO_FIELDS);
+
+#endif
@@ -0,0 +1,390 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "abf2_records.h"
+#include "swap.h"
+
+#define ABF2_FIELD(s, m, offset, type, count) \
+    { #m, offset, offsetof(struct s, m), type, count }
+#define ABF2_RECORD(name, s, size, fields) \
+    { name, size, sizeof(struct s), fields, sizeof(fields) / sizeof(fields[0]) }
+
+static const struct abf2_field section_fields[] = {
+    ABF2_FIELD(abf2_section, uBlockIndex, 0, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_section, uBytes, 4, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_section, llNumEntries, 8, Abf2Field_Int64, 1),
+};
+const struct abf2_record abf2_section_record =
+    ABF2_RECORD("ABF_Section", abf2_section, 16, section_fields);
+
+static const struct abf2_field fileinfo_fields[] = {
+    ABF2_FIELD(abf2_fileinfo, uFileSignature, 0, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uFileVersionNumber, 4, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uFileInfoSize, 8, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uActualEpisodes, 12, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uFileStartDate, 16, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uFileStartTimeMS, 20, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uStopwatchTime, 24, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, nFileType, 28, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_fileinfo, nDataFormat, 30, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_fileinfo, nSimultaneousScan, 32, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_fileinfo, nCRCEnable, 34, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_fileinfo, uFileCRC, 36, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, FileGUID, 40, Abf2Field_Guid, 1),
+    ABF2_FIELD(abf2_fileinfo, uCreatorVersion, 56, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uCreatorNameIndex, 60, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uModifierVersion, 64, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uModifierNameIndex, 68, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, uProtocolPathIndex, 72, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_fileinfo, ProtocolSection, 76, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, ADCSection, 92, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, DACSection, 108, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, EpochSection, 124, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, ADCPerDACSection, 140, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, EpochPerDACSection, 156, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, UserListSection, 172, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, StatsRegionSection, 188, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, MathSection, 204, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, StringsSection, 220, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, DataSection, 236, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, TagSection, 252, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, ScopeSection, 268, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, DeltaSection, 284, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, VoiceTagSection, 300, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, SynchArraySection, 316, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, AnnotationSection, 332, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, StatsSection, 348, Abf2Field_Section, 1),
+    ABF2_FIELD(abf2_fileinfo, sUnused, 364, Abf2Field_Int8, 148),
+};
+const struct abf2_record abf2_fileinfo_record =
+    ABF2_RECORD("ABF_FileInfo", abf2_fileinfo, 512, fileinfo_fields);
+
+static const struct abf2_field protocolinfo_fields[] = {
+    ABF2_FIELD(abf2_protocolinfo, nOperationMode, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fADCSequenceInterval, 2, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, bEnableFileCompression, 6, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_protocolinfo, sUnused1, 7, Abf2Field_Int8, 3),
+    ABF2_FIELD(abf2_protocolinfo, uFileCompressionRatio, 10, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fSynchTimeUnit, 14, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fSecondsPerRun, 18, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lNumSamplesPerEpisode, 22, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lPreTriggerSamples, 26, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lEpisodesPerRun, 30, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lRunsPerTrial, 34, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lNumberOfTrials, 38, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAveragingMode, 42, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nUndoRunCount, 44, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nFirstEpisodeInRun, 46, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fTriggerThreshold, 48, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nTriggerSource, 52, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nTriggerAction, 54, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nTriggerPolarity, 56, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fScopeOutputInterval, 58, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fEpisodeStartToStart, 62, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fRunStartToStart, 66, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lAverageCount, 70, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fTrialStartToStart, 74, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAutoTriggerStrategy, 78, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fFirstRunDelayS, 80, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nChannelStatsStrategy, 84, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, lSamplesPerTrace, 86, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lStartDisplayNum, 90, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lFinishDisplayNum, 94, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nShowPNRawData, 98, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fStatisticsPeriod, 100, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lStatisticsMeasurements, 104, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nStatisticsSaveStrategy, 108, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fADCRange, 110, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, fDACRange, 114, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lADCResolution, 118, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, lDACResolution, 122, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nExperimentType, 126, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nManualInfoStrategy, 128, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nCommentsEnable, 130, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, lFileCommentIndex, 132, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAutoAnalyseEnable, 136, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nSignalType, 138, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitalEnable, 140, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nActiveDACChannel, 142, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitalHolding, 144, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitalInterEpisode, 146, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitalDACChannel, 148, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitalTrainActiveLogic, 150, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nStatsEnable, 152, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nStatisticsClearStrategy, 154, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nLevelHysteresis, 156, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, lTimeHysteresis, 158, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAllowExternalTags, 162, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAverageAlgorithm, 164, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fAverageWeighting, 166, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_protocolinfo, nUndoPromptStrategy, 170, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nTrialTriggerSource, 172, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nStatisticsDisplayStrategy, 174, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nExternalTagType, 176, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nScopeTriggerOut, 178, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nLTPType, 180, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAlternateDACOutputState, 182, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nAlternateDigitalOutputState, 184, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, fCellID, 186, Abf2Field_Int32, 3),
+    ABF2_FIELD(abf2_protocolinfo, nDigitizerADCs, 198, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitizerDACs, 200, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitizerTotalDigitalOuts, 202, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitizerSynchDigitalOuts, 204, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, nDigitizerType, 206, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_protocolinfo, sUnused, 208, Abf2Field_Int8, 304),
+};
+const struct abf2_record abf2_protocolinfo_record =
+    ABF2_RECORD("ABF_ProtocolInfo", abf2_protocolinfo, 512, protocolinfo_fields);
+
+static const struct abf2_field mathinfo_fields[] = {
+    ABF2_FIELD(abf2_mathinfo, nMathEnable, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_mathinfo, nMathExpression, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_mathinfo, uMathOperatorIndex, 4, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_mathinfo, uMathUnitsIndex, 8, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_mathinfo, fMathUpperLimit, 12, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_mathinfo, fMathLowerLimit, 16, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_mathinfo, nMathADCNum, 20, Abf2Field_Int16, 2),
+    ABF2_FIELD(abf2_mathinfo, sUnused, 24, Abf2Field_Int8, 16),
+    ABF2_FIELD(abf2_mathinfo, fMathK, 40, Abf2Field_Int32, 6),
+    ABF2_FIELD(abf2_mathinfo, sUnused2, 64, Abf2Field_Int8, 64),
+};
+const struct abf2_record abf2_mathinfo_record =
+    ABF2_RECORD("ABF_MathInfo", abf2_mathinfo, 128, mathinfo_fields);
+
+static const struct abf2_field adcinfo_fields[] = {
+    ABF2_FIELD(abf2_adcinfo, nADCNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, nTelegraphEnable, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, nTelegraphInstrument, 4, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, fTelegraphAdditGain, 6, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fTelegraphFilter, 10, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fTelegraphMembraneCap, 14, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, nTelegraphMode, 18, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, fTelegraphAccessResistance, 20, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, nADCPtoLChannelMap, 24, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, nADCSamplingSeq, 26, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, fADCProgrammableGain, 28, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fADCDisplayAmplification, 32, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fADCDisplayOffset, 36, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fInstrumentScaleFactor, 40, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fInstrumentOffset, 44, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fSignalGain, 48, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fSignalOffset, 52, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fSignalLowpassFilter, 56, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, fSignalHighpassFilter, 60, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, nLowpassFilterType, 64, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_adcinfo, nHighpassFilterType, 65, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_adcinfo, fPostProcessLowpassFilter, 66, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, nPostProcessLowpassFilterType, 70, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_adcinfo, bEnabledDuringPN, 71, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_adcinfo, nStatsChannelPolarity, 72, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_adcinfo, lADCChannelNameIndex, 74, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, lADCUnitsIndex, 78, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_adcinfo, sUnused, 82, Abf2Field_Int8, 46),
+};
+const struct abf2_record abf2_adcinfo_record =
+    ABF2_RECORD("ABF_ADCInfo", abf2_adcinfo, 128, adcinfo_fields);
+
+static const struct abf2_field dacinfo_fields[] = {
+    ABF2_FIELD(abf2_dacinfo, nDACNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nTelegraphDACScaleFactorEnable, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, fInstrumentHoldingLevel, 4, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACScaleFactor, 8, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACHoldingLevel, 12, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACCalibrationFactor, 16, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACCalibrationOffset, 20, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACChannelNameIndex, 24, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACChannelUnitsIndex, 28, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACFilePtr, 32, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACFileNumEpisodes, 36, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nWaveformEnable, 40, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nWaveformSource, 42, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nInterEpisodeLevel, 44, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACFileScale, 46, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fDACFileOffset, 50, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACFileEpisodeNum, 54, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nDACFileADCNum, 58, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nConditEnable, 60, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, lConditNumPulses, 62, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fBaselineDuration, 66, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fBaselineLevel, 70, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fStepDuration, 74, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fStepLevel, 78, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fPostTrainPeriod, 82, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fPostTrainLevel, 86, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nMembTestEnable, 90, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nLeakSubtractType, 92, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nPNPolarity, 94, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, fPNHoldingLevel, 96, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nPNNumADCChannels, 100, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nPNPosition, 102, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nPNNumPulses, 104, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, fPNSettlingTime, 106, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fPNInterpulse, 110, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nLTPUsageOfDAC, 114, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, nLTPPresynapticPulses, 116, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, lDACFilePathIndex, 118, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fMembTestPreSettlingTimeMS, 122, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, fMembTestPostSettlingTimeMS, 126, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_dacinfo, nLeakSubtractADCIndex, 130, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_dacinfo, sUnused, 132, Abf2Field_Int8, 124),
+};
+const struct abf2_record abf2_dacinfo_record =
+    ABF2_RECORD("ABF_DACInfo", abf2_dacinfo, 256, dacinfo_fields);
+
+static const struct abf2_field epochinfoperdac_fields[] = {
+    ABF2_FIELD(abf2_epochinfoperdac, nEpochNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, nDACNum, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, nEpochType, 4, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, fEpochInitLevel, 6, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, fEpochLevelInc, 10, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, lEpochInitDuration, 14, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, lEpochDurationInc, 18, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, lEpochPulsePeriod, 22, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, lEpochPulseWidth, 26, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_epochinfoperdac, sUnused, 30, Abf2Field_Int8, 18),
+};
+const struct abf2_record abf2_epochinfoperdac_record =
+    ABF2_RECORD("ABF_EpochInfoPerDAC", abf2_epochinfoperdac, 48, epochinfoperdac_fields);
+
+static const struct abf2_field epochinfo_fields[] = {
+    ABF2_FIELD(abf2_epochinfo, nEpochNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfo, nDigitalValue, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfo, nDigitalTrainValue, 4, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfo, nAlternateDigitalValue, 6, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfo, nAlternateDigitalTrainValue, 8, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_epochinfo, bEpochCompression, 10, Abf2Field_Int8, 1),
+    ABF2_FIELD(abf2_epochinfo, sUnused, 11, Abf2Field_Int8, 21),
+};
+const struct abf2_record abf2_epochinfo_record =
+    ABF2_RECORD("ABF_EpochInfo", abf2_epochinfo, 32, epochinfo_fields);
+
+static const struct abf2_field statsregioninfo_fields[] = {
+    ABF2_FIELD(abf2_statsregioninfo, nRegionNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nADCNum, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsActiveChannels, 4, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSearchRegionFlags, 6, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSelectedRegion, 8, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSmoothing, 10, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSmoothingEnable, 12, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsBaseline, 14, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, lStatsBaselineStart, 16, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_statsregioninfo, lStatsBaselineEnd, 20, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_statsregioninfo, lStatsMeasurements, 24, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_statsregioninfo, lStatsStart, 28, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_statsregioninfo, lStatsEnd, 32, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nRiseBottomPercentile, 36, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nRiseTopPercentile, 38, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nDecayBottomPercentile, 40, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nDecayTopPercentile, 42, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSearchMode, 44, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsSearchDAC, 46, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, nStatsBaselineDAC, 48, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_statsregioninfo, sUnused, 50, Abf2Field_Int8, 78),
+};
+const struct abf2_record abf2_statsregioninfo_record =
+    ABF2_RECORD("ABF_StatsRegionInfo", abf2_statsregioninfo, 128, statsregioninfo_fields);
+
+static const struct abf2_field userlistinfo_fields[] = {
+    ABF2_FIELD(abf2_userlistinfo, nListNum, 0, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_userlistinfo, nULEnable, 2, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_userlistinfo, nULParamToVary, 4, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_userlistinfo, nULRepeat, 6, Abf2Field_Int16, 1),
+    ABF2_FIELD(abf2_userlistinfo, lULParamValueListIndex, 8, Abf2Field_Int32, 1),
+    ABF2_FIELD(abf2_userlistinfo, sUnused, 12, Abf2Field_Int8, 52),
+};
+const struct abf2_record abf2_userlistinfo_record =
+    ABF2_RECORD("ABF_UserListInfo", abf2_userlistinfo, 64, userlistinfo_fields);
+
+const struct abf2_record *const abf2_records[] = {
+    &abf2_section_record,
+    &abf2_fileinfo_record,
+    &abf2_protocolinfo_record,
+    &abf2_mathinfo_record,
+    &abf2_adcinfo_record,
+    &abf2_dacinfo_record,
+    &abf2_epochinfoperdac_record,
+    &abf2_epochinfo_record,
+    &abf2_statsregioninfo_record,
+    &abf2_userlistinfo_record,
+    NULL
+};
+
+size_t abf2_field_size(Abf2Field type)
+{
+    switch (type) {
+    case Abf2Field_Int8:
+        return 1;
+    case Abf2Field_Int16:
+        return 2;
+    case Abf2Field_Int32:
+        return 4;
+    case Abf2Field_Int64:
+        return 8;
+    case Abf2Field_Guid:
+    case Abf2Field_Section:
+        return 16;
+    }
+    return 0;
+}
+
+/* Swap the multi-byte elements of a field in place. Guids and
+ * sections have the same member offsets packed and aligned. */
+static void abf2_swap_field(char *p, Abf2Field type, size_t count)
+{
+    size_t i;
+    switch (type) {
+    case Abf2Field_Int8:
+        break;
+    case Abf2Field_Int16:
+        swap16_array(p, count);
+        break;
+    case Abf2Field_Int32:
+        swap32_array(p, count);
+        break;
+    case Abf2Field_Int64:
+        swap64_array(p, count);
+        break;
+    case Abf2Field_Guid:
+        for (i = 0; i < count; i++, p += 16) {
+            swap32_array(p, 1);
+            swap16_array(p + 4, 2);
+        }
+        break;
+    case Abf2Field_Section:
+        for (i = 0; i < count; i++, p += 16) {
+            swap32_array(p, 2);
+            swap64_array(p + 8, 1);
+        }
+        break;
+    }
+}
+
+void abf2_decode(const struct abf2_record *record, const char *buffer, void *to, bool swap)
+{
+    const struct abf2_field *f = record->fields;
+    const struct abf2_field *end = f + record->num_fields;
+    char *out = to;
+    size_t size;
+
+    for (; f != end; f++) {
+        size = abf2_field_size(f->type) * f->count;
+        memcpy(out + f->struct_offset, buffer + f->file_offset, size);
+        if (swap)
+            abf2_swap_field(out + f->struct_offset, f->type, f->count);
+    }
+}
+
+void abf2_encode(const struct abf2_record *record, const void *from, char *buffer, bool swap)
+{
+    const struct abf2_field *f = record->fields;
+    const struct abf2_field *end = f + record->num_fields;
+    const char *in = from;
+    size_t size;
+
+    for (; f != end; f++) {
+        size = abf2_field_size(f->type) * f->count;
+        memcpy(buffer + f->file_offset, in + f->struct_offset, size);
+        if (swap)
+            abf2_swap_field(buffer + f->file_offset, f->type, f->count);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef ABF2_RECORDS_H
+#define ABF2_RECORDS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "abf2_struct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Descriptor tables for the records in abf2_struct.h
+ *
+ * Each record is stored packed in the file, while the structs in
+ * abf2_struct.h are naturally aligned, so the two layouts differ. A
+ * record descriptor lists every field once, with its offset in the
+ * file and in the struct, and abf2_decode()/abf2_encode() convert a
+ * whole record between the two layouts in a single loop, byte-swapping
+ * when asked to. The file offsets follow abf2struct_packedsizes.txt. */
+
+typedef enum Abf2Field {
+    Abf2Field_Int8,     /* also t_BOOL and padding; never swapped */
+    Abf2Field_Int16,
+    Abf2Field_Int32,    /* also float */
+    Abf2Field_Int64,
+    Abf2Field_Guid,     /* struct guid: 32, 16, 16 bit and 8 bytes */
+    Abf2Field_Section   /* struct abf2_section: 32, 32 and 64 bit */
+} Abf2Field;
+
+struct abf2_field
+{
+    const char *name;
+    size_t file_offset;
+    size_t struct_offset;
+    Abf2Field type;
+    size_t count;       /* number of elements for arrays, else 1 */
+};
+
+struct abf2_record
+{
+    const char *name;   /* name used in abf2struct_packedsizes.txt */
+    size_t file_size;
+    size_t struct_size;
+    const struct abf2_field *fields;
+    size_t num_fields;
+};
+
+extern const struct abf2_record abf2_section_record;
+extern const struct abf2_record abf2_fileinfo_record;
+extern const struct abf2_record abf2_protocolinfo_record;
+extern const struct abf2_record abf2_mathinfo_record;
+extern const struct abf2_record abf2_adcinfo_record;
+extern const struct abf2_record abf2_dacinfo_record;
+extern const struct abf2_record abf2_epochinfoperdac_record;
+extern const struct abf2_record abf2_epochinfo_record;
+extern const struct abf2_record abf2_statsregioninfo_record;
+extern const struct abf2_record abf2_userlistinfo_record;
+
+/* All of the above, terminated by NULL */
+extern const struct abf2_record *const abf2_records[];
+
+/* Size in bytes of one element of a field of the given type */
+size_t abf2_field_size(Abf2Field type);
+
+/* abf2_decode
+ *
+ * Fills the struct at *to* from the *record->file_size* packed bytes
+ * at *buffer*. If *swap* is true, multi-byte fields are byte-swapped. */
+void abf2_decode(const struct abf2_record *record, const char *buffer, void *to, bool swap);
+
+/* abf2_encode
+ *
+ * The inverse of abf2_decode: writes the struct at *from* to
+ * *record->file_size* packed bytes at *buffer*. */
+void abf2_encode(const struct abf2_record *record, const void *from, char *buffer, bool swap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
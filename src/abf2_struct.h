@@ -3,19 +3,24 @@
 
 #include <stdint.h>
 
+/* Also defined by platform.h, which may come first */
+#ifndef PLATFORM_H
 typedef int8_t t_BOOL;
 
 /* FALSE = 0, TRUE = 1 */
 typedef enum { FALSE, TRUE } Boolean;
-#ifndef GUID_DEFINED
-#define GUID_DEFINED
-typedef struct guid
+#endif
+
+struct guid
 {
     uint32_t Data1;
     uint16_t Data2;
     uint16_t Data3;
     uint8_t Data4[8];
-} GUID;
+};
+#ifndef GUID_DEFINED
+#define GUID_DEFINED
+typedef struct guid GUID;
 #endif /* GUID_DEFINED */
 
 // Structure definitions for Axon Binary File v2 (ABF2) format
@@ -24,6 +29,7 @@ typedef struct guid
 
 #define ABF2_FILESIGNATURE   0x32464241      /* "ABF2" in little-endian ASCII */
                                              /* "2FBA" in big-endian ASCII */
+#define ABF2_BLOCKSIZE       512             /* sections start on block boundaries */
 
 struct abf2_section
 {
@@ -312,7 +318,7 @@ struct abf2_epochinfo
     t_BOOL bEpochCompression;   // Compress the data from this epoch using uFileCompressionRatio
 
     int8_t sUnused[21];      // size = 32 bytes
-} ABF_EpochInfo;
+};
 
 struct abf2_statsregioninfo
 {
@@ -0,0 +1,871 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "abf2_records.h"
+#include "abf_catalog.h"
+#include "swap.h"
+#include "fdstream.h"
+
+#include "memory.c"
+
+#if defined(_POSIX_VERSION)
+# include <dirent.h>
+# include <sys/stat.h>
+# define CATALOG_USE_DIRENT
+#endif
+
+#if defined(_POSIX_THREADS) && (_POSIX_THREADS > 0)
+# define CATALOG_USE_THREADS
+# include <pthread.h>
+#endif
+
+/* The first bytes of each kind of file, read as a native uint32 */
+#define ABF1_SIGNATURE 0x20464241u      /* "ABF " */
+#define ABF2_SIGNATURE 0x32464241u      /* "ABF2" */
+
+/* Offsets in the ABF 1 header (ABFFileHeader in abfheader.h) */
+#define ABF1_FILEVERSION        4
+#define ABF1_ACTUALEPISODES     16
+#define ABF1_FILESTARTDATE      20
+#define ABF1_FILESTARTTIME      24      /* seconds */
+#define ABF1_NUMCHANNELS        120
+#define ABF1_SAMPLEINTERVAL     122     /* us, between any two samples */
+#define ABF1_STARTMILLISECS     366
+#define ABF1_PROTOCOLPATH       4898    /* 1.8 and later */
+#define ABF1_PROTOCOLPATHLEN    256
+#define ABF1_FILEGUID           5282    /* 1.8 and later */
+#define ABF1_OLDHEADERSIZE      2048
+#define ABF1_HEADERSIZE         6144
+
+/* The string section starts with a SimpleStringCacheHeader */
+#define STRINGS_SIGNATURE       0x48435353u     /* "SSCH" */
+#define STRINGS_HEADERSIZE      44
+#define STRINGS_NUMSTRINGS      8
+#define STRINGS_TOTALBYTES      16
+#define STRINGS_MAXBYTES        (1024 * 1024)
+
+/* Directory entries are handed out one task per file or directory. */
+struct catalog_task
+{
+    char *path;
+    bool is_dir;
+};
+
+/* Tasks [head, tail) of a worker; the owner works from the tail and
+ * idle workers steal from the head. */
+struct catalog_deque
+{
+    struct catalog_task *tasks;
+    size_t head, tail, capacity;
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_t lock;
+#endif
+};
+
+struct catalog_pool;
+
+struct catalog_worker
+{
+    struct catalog_pool *pool;
+    struct catalog_deque deque;
+    struct abf_catalog_entry *entries;
+    size_t count, capacity, failed;
+    unsigned index;
+#ifdef CATALOG_USE_THREADS
+    pthread_t thread;
+#endif
+};
+
+struct catalog_pool
+{
+    struct catalog_worker *workers;
+    unsigned num_workers;
+    bool all_files;
+    size_t queued;      /* tasks waiting in any deque */
+    size_t pending;     /* tasks queued or running */
+    bool out_of_memory;
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+};
+
+static char *catalog_strndup(const char *s, size_t n)
+{
+    char *copy = malloc(n + 1);
+    if (copy != NULL) {
+        memcpy(copy, s, n);
+        copy[n] = '\0';
+    }
+    return copy;
+}
+
+static uint16_t get_u16(const uint8_t *p, bool swap)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? _swap16(v) : v;
+}
+
+static uint32_t get_u32(const uint8_t *p, bool swap)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? _swap32(v) : v;
+}
+
+static float get_float(const uint8_t *p, bool swap)
+{
+    uint32_t bits = get_u32(p, swap);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/* Fixed-width ABF 1 strings are padded with spaces or NULs. */
+static char *copy_fixed_string(const uint8_t *p, size_t size)
+{
+    while (size > 0 && (p[size - 1] == ' ' || p[size - 1] == '\0'))
+        size--;
+    return catalog_strndup((const char *)p, size);
+}
+
+static StreamError inspect_abf1(stream_dt *stream, const uint8_t *block, streampos_dt length,
+                                bool swap, struct abf_catalog_entry *entry)
+{
+    uint8_t header[ABF1_HEADERSIZE];
+    size_t size = ABF1_OLDHEADERSIZE;
+    int32_t start_time;
+    StreamError err;
+
+    entry->format = 1;
+    entry->file_version = get_float(block + ABF1_FILEVERSION, swap);
+    if (entry->file_version >= 1.8f && length >= ABF1_HEADERSIZE)
+        size = ABF1_HEADERSIZE;
+    if (length < size)
+        return StreamError_Failure;
+
+    memcpy(header, block, ABF2_BLOCKSIZE);
+    err = stream_readAt(stream, ABF2_BLOCKSIZE, header + ABF2_BLOCKSIZE, size - ABF2_BLOCKSIZE);
+    if (err != StreamError_Success)
+        return err;
+
+    entry->episodes = get_u32(header + ABF1_ACTUALEPISODES, swap);
+    entry->channels = get_u16(header + ABF1_NUMCHANNELS, swap);
+    entry->sample_interval_us = get_float(header + ABF1_SAMPLEINTERVAL, swap) * entry->channels;
+    entry->start_date = get_u32(header + ABF1_FILESTARTDATE, swap);
+    start_time = (int32_t)get_u32(header + ABF1_FILESTARTTIME, swap);
+    entry->start_time_ms = (uint32_t)start_time * 1000u
+                           + get_u16(header + ABF1_STARTMILLISECS, swap);
+
+    if (size == ABF1_HEADERSIZE) {
+        entry->guid.Data1 = get_u32(header + ABF1_FILEGUID, swap);
+        entry->guid.Data2 = get_u16(header + ABF1_FILEGUID + 4, swap);
+        entry->guid.Data3 = get_u16(header + ABF1_FILEGUID + 6, swap);
+        memcpy(entry->guid.Data4, header + ABF1_FILEGUID + 8, sizeof(entry->guid.Data4));
+        entry->protocol_path = copy_fixed_string(header + ABF1_PROTOCOLPATH, ABF1_PROTOCOLPATHLEN);
+    } else {
+        entry->protocol_path = catalog_strndup("", 0);
+    }
+    return entry->protocol_path ? StreamError_Success : StreamError_NoMemory;
+}
+
+/* Finds string *index* (1-based) in the *size* bytes of a string
+ * section at *strings*. Returns NULL if it does not end within them. */
+static const char *find_string(const uint8_t *strings, size_t size, uint32_t index, size_t *len)
+{
+    const uint8_t *p = strings, *end = strings + size, *nul;
+    while (p < end) {
+        nul = memchr(p, '\0', (size_t)(end - p));
+        if (nul == NULL)
+            return NULL;
+        if (--index == 0) {
+            *len = (size_t)(nul - p);
+            return (const char *)p;
+        }
+        p = nul + 1;
+    }
+    return NULL;
+}
+
+static StreamError read_protocol_path(stream_dt *stream, const struct abf2_fileinfo *info,
+                                      const uint8_t *block, bool swap, char **path)
+{
+    uint32_t num_strings, total;
+    uint8_t *strings;
+    const char *s;
+    size_t len;
+    StreamError err;
+
+    *path = NULL;
+    if (info->uProtocolPathIndex == 0 || info->StringsSection.uBlockIndex == 0
+        || get_u32(block, swap) != STRINGS_SIGNATURE)
+        return (*path = catalog_strndup("", 0)) ? StreamError_Success : StreamError_NoMemory;
+
+    num_strings = get_u32(block + STRINGS_NUMSTRINGS, swap);
+    total = get_u32(block + STRINGS_TOTALBYTES, swap);
+    if (info->uProtocolPathIndex > num_strings || total > STRINGS_MAXBYTES)
+        return (*path = catalog_strndup("", 0)) ? StreamError_Success : StreamError_NoMemory;
+
+    /* Most string sections fit in the block already read. */
+    len = ABF2_BLOCKSIZE - STRINGS_HEADERSIZE;
+    s = find_string(block + STRINGS_HEADERSIZE, total < len ? total : len,
+                    info->uProtocolPathIndex, &len);
+    if (s != NULL)
+        return (*path = catalog_strndup(s, len)) ? StreamError_Success : StreamError_NoMemory;
+    if (total <= ABF2_BLOCKSIZE - STRINGS_HEADERSIZE)
+        return StreamError_Failure;
+
+    strings = malloc(total);
+    if (strings == NULL)
+        return StreamError_NoMemory;
+    err = stream_readAt(stream, (streampos_dt)info->StringsSection.uBlockIndex * ABF2_BLOCKSIZE
+                        + STRINGS_HEADERSIZE, strings, total);
+    if (err == StreamError_Success) {
+        s = find_string(strings, total, info->uProtocolPathIndex, &len);
+        if (s == NULL)
+            err = StreamError_Failure;
+        else if ((*path = catalog_strndup(s, len)) == NULL)
+            err = StreamError_NoMemory;
+    }
+    free(strings);
+    return err;
+}
+
+static StreamError inspect_abf2(stream_dt *stream, const uint8_t *block, streampos_dt length,
+                                bool swap, struct abf_catalog_entry *entry)
+{
+    struct abf2_fileinfo info;
+    struct abf2_protocolinfo protocol;
+    uint8_t blocks[2][ABF2_BLOCKSIZE];
+    struct stream_iovec vec[2];
+    size_t count = 1;
+    StreamError err;
+
+    abf2_decode(&abf2_fileinfo_record, (const char *)block, &info, swap);
+    entry->format = 2;
+    entry->file_version = (float)((info.uFileVersionNumber >> 24) & 0xFF)
+                          + (float)((info.uFileVersionNumber >> 16) & 0xFF) / 100.0f;
+    entry->channels = (uint16_t)info.ADCSection.llNumEntries;
+    entry->episodes = info.uActualEpisodes;
+    entry->start_date = info.uFileStartDate;
+    entry->start_time_ms = info.uFileStartTimeMS;
+    entry->guid = info.FileGUID;
+
+    /* The protocol block and the first block of the strings, together */
+    if (info.ProtocolSection.uBlockIndex == 0)
+        return StreamError_Failure;
+    vec[0].offset = (streampos_dt)info.ProtocolSection.uBlockIndex * ABF2_BLOCKSIZE;
+    vec[0].ptr = blocks[0];
+    vec[0].size = ABF2_BLOCKSIZE;
+    memset(blocks[1], 0, sizeof(blocks[1]));
+    if (info.StringsSection.uBlockIndex != 0) {
+        vec[1].offset = (streampos_dt)info.StringsSection.uBlockIndex * ABF2_BLOCKSIZE;
+        vec[1].ptr = blocks[1];
+        vec[1].size = ABF2_BLOCKSIZE;
+        if (vec[1].offset + vec[1].size > length)
+            vec[1].size = (size_t)(length > vec[1].offset ? length - vec[1].offset : 0);
+        count++;
+    }
+    err = stream_readv(stream, vec, count);
+    if (err != StreamError_Success)
+        return err;
+
+    abf2_decode(&abf2_protocolinfo_record, (const char *)blocks[0], &protocol, swap);
+    entry->sample_interval_us = protocol.fADCSequenceInterval;
+
+    return read_protocol_path(stream, &info, blocks[1], swap, &entry->protocol_path);
+}
+
+StreamError abf_catalog_inspectStream(stream_dt *stream, struct abf_catalog_entry *entry)
+{
+    uint8_t block[ABF2_BLOCKSIZE];
+    streampos_dt length;
+    uint32_t signature;
+    StreamError err;
+
+    memset(entry, 0, sizeof(*entry));
+    err = stream_length(stream, &length);
+    if (err != StreamError_Success)
+        return err;
+    if (length < ABF2_BLOCKSIZE)
+        return StreamError_Failure;
+    err = stream_readAt(stream, 0, block, sizeof(block));
+    if (err != StreamError_Success)
+        return err;
+
+    memcpy(&signature, block, sizeof(signature));
+    if (signature == ABF2_SIGNATURE)
+        err = inspect_abf2(stream, block, length, false, entry);
+    else if (signature == _swap32(ABF2_SIGNATURE))
+        err = inspect_abf2(stream, block, length, true, entry);
+    else if (signature == ABF1_SIGNATURE)
+        err = inspect_abf1(stream, block, length, false, entry);
+    else if (signature == _swap32(ABF1_SIGNATURE))
+        err = inspect_abf1(stream, block, length, true, entry);
+    else
+        err = StreamError_Failure;
+
+    if (err != StreamError_Success)
+        abf_catalog_entry_free(entry);
+    return err;
+}
+
+StreamError abf_catalog_inspect(const char *path, struct abf_catalog_entry *entry)
+{
+    stream_dt *stream;
+    StreamError err;
+
+    memset(entry, 0, sizeof(*entry));
+    err = fdstream_openForRead(path, &stream);
+    if (err != StreamError_Success)
+        return err;
+    err = abf_catalog_inspectStream(stream, entry);
+    fdstream_destroy(stream);
+    if (err != StreamError_Success)
+        return err;
+
+    entry->path = catalog_strndup(path, strlen(path));
+    if (entry->path == NULL) {
+        abf_catalog_entry_free(entry);
+        return StreamError_NoMemory;
+    }
+    return StreamError_Success;
+}
+
+void abf_catalog_entry_free(struct abf_catalog_entry *entry)
+{
+    FREE(entry->path);
+    FREE(entry->protocol_path);
+}
+
+void abf_catalog_free(struct abf_catalog *catalog)
+{
+    size_t i;
+    for (i = 0; i < catalog->count; i++)
+        abf_catalog_entry_free(&catalog->entries[i]);
+    FREE(catalog->entries);
+    catalog->count = 0;
+    catalog->failed = 0;
+}
+
+/* Crawling */
+
+static void pool_lock(struct catalog_pool *pool)
+{
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static void pool_unlock(struct catalog_pool *pool)
+{
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+static void deque_lock(struct catalog_deque *deque)
+{
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_lock(&deque->lock);
+#endif
+}
+
+static void deque_unlock(struct catalog_deque *deque)
+{
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_unlock(&deque->lock);
+#endif
+}
+
+/* Appends *count* tasks to the worker's own deque. */
+static bool worker_push(struct catalog_worker *worker, struct catalog_task *tasks, size_t count)
+{
+    struct catalog_deque *deque = &worker->deque;
+    struct catalog_pool *pool = worker->pool;
+    struct catalog_task *grown;
+    size_t used, capacity;
+
+    if (count == 0)
+        return true;
+
+    deque_lock(deque);
+    used = deque->tail - deque->head;
+    if (deque->tail + count > deque->capacity) {
+        memmove(deque->tasks, deque->tasks + deque->head, used * sizeof(*deque->tasks));
+        deque->head = 0;
+        deque->tail = used;
+        if (used + count > deque->capacity) {
+            capacity = deque->capacity ? deque->capacity : 64;
+            while (capacity < used + count)
+                capacity *= 2;
+            grown = realloc(deque->tasks, capacity * sizeof(*deque->tasks));
+            if (grown == NULL) {
+                deque_unlock(deque);
+                return false;
+            }
+            deque->tasks = grown;
+            deque->capacity = capacity;
+        }
+    }
+    memcpy(deque->tasks + deque->tail, tasks, count * sizeof(*tasks));
+    deque->tail += count;
+    deque_unlock(deque);
+
+    pool_lock(pool);
+    pool->queued += count;
+    pool->pending += count;
+#ifdef CATALOG_USE_THREADS
+    if (count > 1)
+        pthread_cond_broadcast(&pool->wake);
+    else
+        pthread_cond_signal(&pool->wake);
+#endif
+    pool_unlock(pool);
+    return true;
+}
+
+static bool deque_take(struct catalog_deque *deque, bool steal, struct catalog_task *task)
+{
+    bool found = false;
+    deque_lock(deque);
+    if (deque->head < deque->tail) {
+        *task = steal ? deque->tasks[deque->head++] : deque->tasks[--deque->tail];
+        found = true;
+    }
+    deque_unlock(deque);
+    return found;
+}
+
+/* Takes the newest task of the worker's own deque, or else the oldest
+ * task of another worker's deque. */
+static bool worker_take(struct catalog_worker *worker, struct catalog_task *task)
+{
+    struct catalog_pool *pool = worker->pool;
+    unsigned i;
+    bool found = deque_take(&worker->deque, false, task);
+
+    for (i = 1; !found && i < pool->num_workers; i++)
+        found = deque_take(&pool->workers[(worker->index + i) % pool->num_workers].deque,
+                           true, task);
+    if (found) {
+        pool_lock(pool);
+        pool->queued--;
+        pool_unlock(pool);
+    }
+    return found;
+}
+
+static void worker_done(struct catalog_worker *worker)
+{
+    struct catalog_pool *pool = worker->pool;
+    pool_lock(pool);
+    if (--pool->pending == 0) {
+#ifdef CATALOG_USE_THREADS
+        pthread_cond_broadcast(&pool->wake);
+#endif
+    }
+    pool_unlock(pool);
+}
+
+static bool has_abf_extension(const char *name)
+{
+    size_t len = strlen(name);
+    const char *ext = name + len - 4;
+    return len > 4 && ext[0] == '.'
+        && (ext[1] == 'a' || ext[1] == 'A')
+        && (ext[2] == 'b' || ext[2] == 'B')
+        && (ext[3] == 'f' || ext[3] == 'F');
+}
+
+static void worker_out_of_memory(struct catalog_worker *worker)
+{
+    pool_lock(worker->pool);
+    worker->pool->out_of_memory = true;
+    pool_unlock(worker->pool);
+}
+
+static void worker_scan(struct catalog_worker *worker, const char *dir)
+{
+#ifdef CATALOG_USE_DIRENT
+    struct catalog_task batch[64];
+    size_t n = 0, dir_len = strlen(dir), name_len;
+    struct dirent *ent;
+    struct stat st;
+    char *path;
+    bool is_dir;
+    DIR *d;
+
+    d = opendir(dir);
+    if (d == NULL)
+        return;
+
+    while ((ent = readdir(d)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+
+        name_len = strlen(ent->d_name);
+        path = malloc(dir_len + name_len + 2);
+        if (path == NULL) {
+            worker_out_of_memory(worker);
+            break;
+        }
+        memcpy(path, dir, dir_len);
+        path[dir_len] = '/';
+        memcpy(path + dir_len + 1, ent->d_name, name_len + 1);
+
+# ifdef _DIRENT_HAVE_D_TYPE
+        if (ent->d_type == DT_DIR || ent->d_type == DT_REG) {
+            is_dir = (ent->d_type == DT_DIR);
+        } else
+# endif
+        if (lstat(path, &st) == 0 && (S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) {
+            is_dir = S_ISDIR(st.st_mode);
+        } else {
+            free(path);
+            continue;
+        }
+
+        if (!is_dir && !worker->pool->all_files && !has_abf_extension(ent->d_name)) {
+            free(path);
+            continue;
+        }
+
+        batch[n].path = path;
+        batch[n].is_dir = is_dir;
+        if (++n == sizeof(batch) / sizeof(batch[0])) {
+            if (!worker_push(worker, batch, n)) {
+                while (n > 0)
+                    free(batch[--n].path);
+                worker_out_of_memory(worker);
+                break;
+            }
+            n = 0;
+        }
+    }
+    closedir(d);
+
+    if (!worker_push(worker, batch, n)) {
+        while (n > 0)
+            free(batch[--n].path);
+        worker_out_of_memory(worker);
+    }
+#endif
+}
+
+static void worker_inspect(struct catalog_worker *worker, char *path)
+{
+    struct abf_catalog_entry entry, *grown;
+    size_t capacity;
+
+    if (abf_catalog_inspect(path, &entry) != StreamError_Success) {
+        worker->failed++;
+        return;
+    }
+
+    if (worker->count == worker->capacity) {
+        capacity = worker->capacity ? worker->capacity * 2 : 256;
+        grown = realloc(worker->entries, capacity * sizeof(*grown));
+        if (grown == NULL) {
+            abf_catalog_entry_free(&entry);
+            worker_out_of_memory(worker);
+            return;
+        }
+        worker->entries = grown;
+        worker->capacity = capacity;
+    }
+    worker->entries[worker->count++] = entry;
+}
+
+static void *worker_run(void *arg)
+{
+    struct catalog_worker *worker = arg;
+    struct catalog_pool *pool = worker->pool;
+    struct catalog_task task;
+
+    for (;;) {
+        if (worker_take(worker, &task)) {
+            if (task.is_dir)
+                worker_scan(worker, task.path);
+            else
+                worker_inspect(worker, task.path);
+            free(task.path);
+            worker_done(worker);
+            continue;
+        }
+
+        /* Nothing to take: wait until a task is queued or all are done. */
+        pool_lock(pool);
+#ifdef CATALOG_USE_THREADS
+        while (pool->queued == 0 && pool->pending > 0)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+#endif
+        if (pool->pending == 0) {
+            pool_unlock(pool);
+            break;
+        }
+        pool_unlock(pool);
+    }
+    return NULL;
+}
+
+static unsigned catalog_threads(const struct abf_catalog_options *options)
+{
+#ifdef CATALOG_USE_THREADS
+    long online = 1;
+    if (options != NULL && options->threads > 0)
+        return options->threads;
+# ifdef _SC_NPROCESSORS_ONLN
+    online = sysconf(_SC_NPROCESSORS_ONLN);
+# endif
+    return online > 0 ? (unsigned)online : 1;
+#else
+    return 1;
+#endif
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    return strcmp(((const struct abf_catalog_entry *)a)->path,
+                  ((const struct abf_catalog_entry *)b)->path);
+}
+
+StreamError abf_catalog_build(const char *root, const struct abf_catalog_options *options,
+                              struct abf_catalog *catalog)
+{
+    struct catalog_pool pool;
+    struct catalog_worker *worker;
+    struct catalog_task task;
+    size_t total = 0;
+    unsigned i, started = 0;
+    StreamError err = StreamError_Success;
+
+    catalog->entries = NULL;
+    catalog->count = 0;
+    catalog->failed = 0;
+
+    memset(&pool, 0, sizeof(pool));
+    pool.num_workers = catalog_threads(options);
+    pool.all_files = (options != NULL && options->all_files);
+    pool.workers = calloc(pool.num_workers, sizeof(*pool.workers));
+    if (pool.workers == NULL)
+        return StreamError_NoMemory;
+#ifdef CATALOG_USE_THREADS
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.wake, NULL);
+#endif
+    for (i = 0; i < pool.num_workers; i++) {
+        pool.workers[i].pool = &pool;
+        pool.workers[i].index = i;
+#ifdef CATALOG_USE_THREADS
+        pthread_mutex_init(&pool.workers[i].deque.lock, NULL);
+#endif
+    }
+
+    task.path = catalog_strndup(root, strlen(root));
+    task.is_dir = true;
+    if (task.path == NULL || !worker_push(&pool.workers[0], &task, 1)) {
+        free(task.path);
+        err = StreamError_NoMemory;
+        goto cleanup;
+    }
+
+#ifdef CATALOG_USE_THREADS
+    for (started = 1; started < pool.num_workers; started++) {
+        if (pthread_create(&pool.workers[started].thread, NULL, worker_run,
+                           &pool.workers[started]) != 0)
+            break;
+    }
+#endif
+    worker_run(&pool.workers[0]);
+#ifdef CATALOG_USE_THREADS
+    for (i = 1; i < started; i++)
+        pthread_join(pool.workers[i].thread, NULL);
+#endif
+
+    /* Gather the entries of all workers in path order. */
+    for (i = 0; i < pool.num_workers; i++) {
+        total += pool.workers[i].count;
+        catalog->failed += pool.workers[i].failed;
+    }
+    if (pool.out_of_memory) {
+        err = StreamError_NoMemory;
+        goto cleanup;
+    }
+    if (total > 0) {
+        catalog->entries = malloc(total * sizeof(*catalog->entries));
+        if (catalog->entries == NULL) {
+            err = StreamError_NoMemory;
+            goto cleanup;
+        }
+        for (i = 0; i < pool.num_workers; i++) {
+            worker = &pool.workers[i];
+            memcpy(catalog->entries + catalog->count, worker->entries,
+                   worker->count * sizeof(*worker->entries));
+            catalog->count += worker->count;
+            worker->count = 0;
+        }
+        qsort(catalog->entries, catalog->count, sizeof(*catalog->entries), compare_entries);
+    }
+
+cleanup:
+    for (i = 0; i < pool.num_workers; i++) {
+        worker = &pool.workers[i];
+        while (worker->count > 0)
+            abf_catalog_entry_free(&worker->entries[--worker->count]);
+        free(worker->entries);
+        while (worker->deque.head < worker->deque.tail)
+            free(worker->deque.tasks[worker->deque.head++].path);
+        free(worker->deque.tasks);
+#ifdef CATALOG_USE_THREADS
+        pthread_mutex_destroy(&worker->deque.lock);
+#endif
+    }
+#ifdef CATALOG_USE_THREADS
+    pthread_cond_destroy(&pool.wake);
+    pthread_mutex_destroy(&pool.lock);
+#endif
+    free(pool.workers);
+    if (err != StreamError_Success)
+        abf_catalog_free(catalog);
+    return err;
+}
+
+/* Serialization */
+
+static StreamError write_string(stream_dt *out, const char *s, bool swap)
+{
+    size_t len = (s != NULL) ? strlen(s) : 0;
+    StreamError err;
+    if (len > UINT16_MAX)
+        return StreamError_Failure;
+    err = stream_write_uint16(out, (uint16_t)len, swap);
+    if (err == StreamError_Success && len > 0)
+        err = stream_write(out, s, len);
+    return err;
+}
+
+static StreamError read_string(stream_dt *in, char **s, bool swap)
+{
+    uint16_t len;
+    StreamError err = stream_read_uint16(in, &len, swap);
+    if (err != StreamError_Success)
+        return err;
+    *s = malloc((size_t)len + 1);
+    if (*s == NULL)
+        return StreamError_NoMemory;
+    err = (len > 0) ? stream_read(in, *s, len) : StreamError_Success;
+    (*s)[len] = '\0';
+    return err;
+}
+
+StreamError abf_catalog_write(const struct abf_catalog *catalog, stream_dt *out)
+{
+    bool swap = (get_endian() == ENDIAN_BIG);
+    const struct abf_catalog_entry *e;
+    StreamError err;
+    size_t i;
+
+    if (catalog->count > UINT32_MAX)
+        return StreamError_Failure;
+    err = stream_write(out, "ABFC", 4);
+    if (err == StreamError_Success)
+        err = stream_write_uint32(out, ABF_CATALOG_VERSION, swap);
+    if (err == StreamError_Success)
+        err = stream_write_uint32(out, (uint32_t)catalog->count, swap);
+
+    for (i = 0; err == StreamError_Success && i < catalog->count; i++) {
+        e = &catalog->entries[i];
+        err = write_string(out, e->path, swap);
+        if (err == StreamError_Success)
+            err = write_string(out, e->protocol_path, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint16(out, e->format, swap);
+        if (err == StreamError_Success)
+            err = stream_write_float(out, e->file_version, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint16(out, e->channels, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint32(out, e->episodes, swap);
+        if (err == StreamError_Success)
+            err = stream_write_float(out, e->sample_interval_us, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint32(out, e->start_date, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint32(out, e->start_time_ms, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint32(out, e->guid.Data1, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint16(out, e->guid.Data2, swap);
+        if (err == StreamError_Success)
+            err = stream_write_uint16(out, e->guid.Data3, swap);
+        if (err == StreamError_Success)
+            err = stream_write(out, e->guid.Data4, sizeof(e->guid.Data4));
+    }
+    return err;
+}
+
+StreamError abf_catalog_read(stream_dt *in, struct abf_catalog *catalog)
+{
+    bool swap = (get_endian() == ENDIAN_BIG);
+    struct abf_catalog_entry *e;
+    char magic[4];
+    uint32_t version, count;
+    StreamError err;
+
+    catalog->entries = NULL;
+    catalog->count = 0;
+    catalog->failed = 0;
+
+    err = stream_read(in, magic, sizeof(magic));
+    if (err == StreamError_Success)
+        err = stream_read_uint32(in, &version, swap);
+    if (err == StreamError_Success)
+        err = stream_read_uint32(in, &count, swap);
+    if (err != StreamError_Success)
+        return err;
+    if (memcmp(magic, "ABFC", 4) != 0 || version != ABF_CATALOG_VERSION)
+        return StreamError_Failure;
+    if (count == 0)
+        return StreamError_Success;
+
+    catalog->entries = calloc(count, sizeof(*catalog->entries));
+    if (catalog->entries == NULL)
+        return StreamError_NoMemory;
+
+    while (err == StreamError_Success && catalog->count < count) {
+        e = &catalog->entries[catalog->count++];
+        err = read_string(in, &e->path, swap);
+        if (err == StreamError_Success)
+            err = read_string(in, &e->protocol_path, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint16(in, &e->format, swap);
+        if (err == StreamError_Success)
+            err = stream_read_float(in, &e->file_version, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint16(in, &e->channels, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint32(in, &e->episodes, swap);
+        if (err == StreamError_Success)
+            err = stream_read_float(in, &e->sample_interval_us, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint32(in, &e->start_date, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint32(in, &e->start_time_ms, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint32(in, &e->guid.Data1, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint16(in, &e->guid.Data2, swap);
+        if (err == StreamError_Success)
+            err = stream_read_uint16(in, &e->guid.Data3, swap);
+        if (err == StreamError_Success)
+            err = stream_read(in, e->guid.Data4, sizeof(e->guid.Data4));
+    }
+
+    if (err != StreamError_Success)
+        abf_catalog_free(catalog);
+    return err;
+}
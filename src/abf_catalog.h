@@ -0,0 +1,102 @@
+#ifndef ABF_CATALOG_H
+#define ABF_CATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "abf2_struct.h"
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Metadata catalog for a tree of ABF files
+ *
+ * abf_catalog_build() crawls a directory tree with a pool of worker
+ * threads and inspects every ABF file it finds. Each worker keeps its
+ * own queue of directories and files to visit and takes work from the
+ * other queues when its own runs dry, so one very large directory does
+ * not leave the other threads idle.
+ *
+ * Only the header bytes the catalog needs are read from each file: the
+ * first header block of an ABF 1 file, or the FileInfo, protocol and
+ * string blocks of an ABF 2 file, which is two or three positional
+ * reads per file. Nothing else of the ABF library is involved, so the
+ * catalog can be built without opening files through ABF_ReadOpen.
+ *
+ * abf_catalog_write() stores the result in a compact binary form that
+ * abf_catalog_read() loads back. All integers in it are little-endian:
+ *
+ *   "ABFC", uint32 format version (1), uint32 entry count, then for
+ *   each entry: uint16 path length, path bytes, uint16 protocol path
+ *   length, protocol path bytes, uint16 ABF format (1 or 2), float32
+ *   file version, uint16 channels, uint32 episodes, float32 sample
+ *   interval in us, uint32 start date, uint32 start time in ms, and
+ *   the 16 GUID bytes in file order (Data1, Data2, Data3 little-endian).
+ */
+
+#define ABF_CATALOG_VERSION 1
+
+struct abf_catalog_entry
+{
+    char *path;
+    char *protocol_path;        /* empty if the file has none */
+    uint16_t format;            /* 1 or 2 */
+    float file_version;
+    uint16_t channels;          /* ADC channels sampled */
+    uint32_t episodes;
+    float sample_interval_us;   /* between two samples of one channel */
+    uint32_t start_date;        /* YYYYMMDD */
+    uint32_t start_time_ms;     /* since midnight */
+    struct guid guid;           /* all zero before ABF 1.8 */
+};
+
+struct abf_catalog
+{
+    struct abf_catalog_entry *entries;  /* sorted by path */
+    size_t count;
+    size_t failed;      /* candidate files that could not be inspected */
+};
+
+struct abf_catalog_options
+{
+    unsigned threads;   /* worker threads; 0 for one per online processor */
+    bool all_files;     /* inspect every file, not only those named *.abf */
+};
+
+/* abf_catalog_build
+ *
+ * Catalogs every ABF file below the directory *root*. Symbolic links
+ * are not followed. *options* may be NULL for the defaults. Files that
+ * cannot be inspected are counted in *catalog->failed*; directories
+ * that cannot be read are skipped. */
+StreamError abf_catalog_build(const char *root, const struct abf_catalog_options *options,
+                              struct abf_catalog *catalog);
+
+/* abf_catalog_inspect
+ *
+ * Fills *entry* from the header of the file at *path*. Returns
+ * StreamError_Failure if the file is not an ABF file. */
+StreamError abf_catalog_inspect(const char *path, struct abf_catalog_entry *entry);
+
+/* abf_catalog_inspectStream
+ *
+ * As abf_catalog_inspect(), for a file that is already open. The
+ * entry's path is left NULL. */
+StreamError abf_catalog_inspectStream(stream_dt *stream, struct abf_catalog_entry *entry);
+
+StreamError abf_catalog_write(const struct abf_catalog *catalog, stream_dt *out);
+StreamError abf_catalog_read(stream_dt *in, struct abf_catalog *catalog);
+
+/* Frees the strings of one entry */
+void abf_catalog_entry_free(struct abf_catalog_entry *entry);
+/* Frees all entries and leaves *catalog* empty */
+void abf_catalog_free(struct abf_catalog *catalog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,348 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "adc_convert.h"
+#include "kernel_dispatch.h"
+
+/* Kernels
+ *
+ * As with the array swaps in swap.c, each vector kernel converts as
+ * many whole vectors as fit and leaves the rest to the scalar loop,
+ * and the vector kernels are compiled with per-function target
+ * attributes so that the best supported set can be picked at runtime.
+ *
+ * The contiguous and strided kernels work from the start of the array
+ * and return the number of samples they converted. The in-place kernels
+ * must work backwards, since each float overwrites the int16 samples
+ * that follow it, so they return the number of samples they converted
+ * at the end of the array.
+ */
+
+static size_t adc_scalar(const int16_t *src, float *dst, size_t count, float factor, float shift)
+{
+    size_t i;
+    for (i = 0; i < count; i++)
+        dst[i] = src[i] * factor + shift;
+    return count;
+}
+
+static size_t adc_strided_scalar(const int16_t *src, size_t stride, float *dst, size_t count,
+                                 float factor, float shift)
+{
+    size_t i;
+    for (i = 0; i < count; i++, src += stride)
+        dst[i] = *src * factor + shift;
+    return count;
+}
+
+static size_t adc_double_scalar(const int16_t *src, size_t stride, double *dst, size_t count,
+                                double factor, double shift)
+{
+    size_t i;
+    for (i = 0; i < count; i++, src += stride)
+        dst[i] = *src * factor + shift;
+    return count;
+}
+
+/* The buffer holds both types, so samples go through memcpy */
+static void adc_inplace_scalar(uint8_t *p, size_t count, float factor, float shift)
+{
+    int16_t v;
+    float f;
+    while (count-- > 0) {
+        memcpy(&v, p + count * sizeof(v), sizeof(v));
+        f = v * factor + shift;
+        memcpy(p + count * sizeof(f), &f, sizeof(f));
+    }
+}
+
+static size_t adc_inplace_none(uint8_t *p, size_t count, float factor, float shift)
+{
+    (void)p; (void)count; (void)factor; (void)shift;
+    return 0;
+}
+
+typedef size_t (*adc_kernel_fn)(const int16_t *src, float *dst, size_t count,
+                                float factor, float shift);
+typedef size_t (*adc_strided_kernel_fn)(const int16_t *src, size_t stride, float *dst,
+                                        size_t count, float factor, float shift);
+typedef size_t (*adc_inplace_kernel_fn)(uint8_t *p, size_t count, float factor, float shift);
+typedef size_t (*adc_double_kernel_fn)(const int16_t *src, size_t stride, double *dst,
+                                       size_t count, double factor, double shift);
+
+struct adc_kernels {
+    const char *name;
+    adc_kernel_fn contiguous;
+    adc_strided_kernel_fn strided;
+    adc_inplace_kernel_fn inplace;
+    adc_double_kernel_fn strided_double;
+};
+
+static const struct adc_kernels adc_kernels_scalar = {
+    "scalar", adc_scalar, adc_strided_scalar, adc_inplace_none, adc_double_scalar
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ADC_HAVE_X86_KERNELS
+#include <immintrin.h>
+
+/* SSE2 has no 16 to 32 bit sign extension, so each sample is paired
+ * with itself and shifted down */
+__attribute__((target("sse2")))
+static size_t adc_sse2(const int16_t *src, float *dst, size_t count, float factor, float shift)
+{
+    const __m128 f = _mm_set1_ps(factor);
+    const __m128 s = _mm_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), f), s));
+        _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), f), s));
+    }
+    return i;
+}
+
+/* Two channels: the wanted sample is the low half of each 32-bit pair.
+ * The last pair would read one sample past the last one asked for, so
+ * the final sample is always left to the scalar loop. */
+__attribute__((target("sse2")))
+static size_t adc_strided_sse2(const int16_t *src, size_t stride, float *dst, size_t count,
+                               float factor, float shift)
+{
+    const __m128 f = _mm_set1_ps(factor);
+    const __m128 s = _mm_set1_ps(shift);
+    size_t i = 0;
+
+    if (stride == 1)
+        return adc_sse2(src, dst, count, factor, shift);
+    if (stride == 2) {
+        for (; i + 4 < count; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+            v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), f), s));
+        }
+        return i;
+    }
+    for (; i + 4 <= count; i += 4, src += 4 * stride) {
+        __m128i v = _mm_setr_epi32(src[0], src[stride], src[2 * stride], src[3 * stride]);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), f), s));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static size_t adc_inplace_sse2(uint8_t *p, size_t count, float factor, float shift)
+{
+    const __m128 f = _mm_set1_ps(factor);
+    const __m128 s = _mm_set1_ps(shift);
+    size_t k = count;
+    for (; k >= 4; k -= 4) {
+        __m128i v = _mm_loadl_epi64((const __m128i*)(p + (k - 4) * 2));
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        _mm_storeu_ps((float*)(p + (k - 4) * 4), _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), f), s));
+    }
+    return count - k;
+}
+
+/* The double kernels load samples as the float kernels do and convert
+ * each half of the 32-bit lanes to doubles */
+__attribute__((target("sse2")))
+static size_t adc_double_sse2(const int16_t *src, size_t stride, double *dst, size_t count,
+                              double factor, double shift)
+{
+    const __m128d f = _mm_set1_pd(factor);
+    const __m128d s = _mm_set1_pd(shift);
+    size_t i = 0;
+    __m128i v;
+
+    if (stride == 1) {
+        for (; i + 8 <= count; i += 8) {
+            __m128i w = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+            _mm_storeu_pd(dst + i, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(lo), f), s));
+            _mm_storeu_pd(dst + i + 2,
+                          _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(lo, 8)), f), s));
+            _mm_storeu_pd(dst + i + 4, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(hi), f), s));
+            _mm_storeu_pd(dst + i + 6,
+                          _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(hi, 8)), f), s));
+        }
+        return i;
+    }
+    for (; i + 4 < count; i += 4, src += 4 * stride) {
+        if (stride == 2) {
+            v = _mm_loadu_si128((const __m128i*)src);
+            v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        } else {
+            v = _mm_setr_epi32(src[0], src[stride], src[2 * stride], src[3 * stride]);
+        }
+        _mm_storeu_pd(dst + i, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(v), f), s));
+        _mm_storeu_pd(dst + i + 2,
+                      _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), f), s));
+    }
+    return i;
+}
+
+__attribute__((target("avx2,fma")))
+static size_t adc_avx2(const int16_t *src, float *dst, size_t count, float factor, float shift)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    const __m256 s = _mm256_set1_ps(shift);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(lo), f, s));
+        _mm256_storeu_ps(dst + i + 8, _mm256_fmadd_ps(_mm256_cvtepi32_ps(hi), f, s));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(v), f, s));
+    }
+    return i;
+}
+
+/* Other channel counts gather 32 bits at each sample and keep the low
+ * half, so, as for two channels, the final sample is left over */
+__attribute__((target("avx2,fma")))
+static size_t adc_strided_avx2(const int16_t *src, size_t stride, float *dst, size_t count,
+                               float factor, float shift)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    const __m256 s = _mm256_set1_ps(shift);
+    size_t i = 0;
+
+    if (stride == 1)
+        return adc_avx2(src, dst, count, factor, shift);
+    if (stride == 2) {
+        for (; i + 8 < count; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i * 2));
+            v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+            _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(v), f, s));
+        }
+        return i;
+    }
+    if (stride <= 0xFFFF) {
+        const int n = (int)stride;
+        const __m256i index = _mm256_setr_epi32(0, n, 2 * n, 3 * n, 4 * n, 5 * n, 6 * n, 7 * n);
+        for (; i + 8 < count; i += 8, src += 8 * stride) {
+            __m256i v = _mm256_i32gather_epi32((const int*)src, index, 2);
+            v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+            _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(v), f, s));
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2,fma")))
+static size_t adc_inplace_avx2(uint8_t *p, size_t count, float factor, float shift)
+{
+    const __m256 f = _mm256_set1_ps(factor);
+    const __m256 s = _mm256_set1_ps(shift);
+    size_t k = count;
+    for (; k >= 8; k -= 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(p + (k - 8) * 2)));
+        _mm256_storeu_ps((float*)(p + (k - 8) * 4), _mm256_fmadd_ps(_mm256_cvtepi32_ps(v), f, s));
+    }
+    return count - k;
+}
+
+__attribute__((target("avx2,fma")))
+static size_t adc_double_avx2(const int16_t *src, size_t stride, double *dst, size_t count,
+                              double factor, double shift)
+{
+    const __m256d f = _mm256_set1_pd(factor);
+    const __m256d s = _mm256_set1_pd(shift);
+    size_t i = 0;
+    __m256i v;
+
+    if (stride > 0xFFFF)
+        return adc_double_sse2(src, stride, dst, count, factor, shift);
+    if (stride == 1) {
+        for (; i + 8 <= count; i += 8) {
+            v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+            _mm256_storeu_pd(dst + i,
+                             _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), f, s));
+            _mm256_storeu_pd(dst + i + 4,
+                             _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), f, s));
+        }
+        return i;
+    }
+    {
+        const int n = (int)stride;
+        const __m256i index = _mm256_setr_epi32(0, n, 2 * n, 3 * n, 4 * n, 5 * n, 6 * n, 7 * n);
+        for (; i + 8 < count; i += 8, src += 8 * stride) {
+            if (stride == 2)
+                v = _mm256_loadu_si256((const __m256i*)src);
+            else
+                v = _mm256_i32gather_epi32((const int*)src, index, 2);
+            v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+            _mm256_storeu_pd(dst + i,
+                             _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), f, s));
+            _mm256_storeu_pd(dst + i + 4,
+                             _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), f, s));
+        }
+    }
+    return i;
+}
+
+static const struct adc_kernels adc_kernels_sse2 = {
+    "sse2", adc_sse2, adc_strided_sse2, adc_inplace_sse2, adc_double_sse2
+};
+
+static const struct adc_kernels adc_kernels_avx2 = {
+    "avx2", adc_avx2, adc_strided_avx2, adc_inplace_avx2, adc_double_avx2
+};
+#endif /* x86 */
+
+static const void *adc_kernels_select(void)
+{
+#ifdef ADC_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return &adc_kernels_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return &adc_kernels_sse2;
+#endif
+    return &adc_kernels_scalar;
+}
+
+static const struct adc_kernels *adc_kernels(void)
+{
+    static const void *volatile selected = NULL;
+    return kernel_dispatch(&selected, adc_kernels_select);
+}
+
+const char *adc_convert_kernel(void)
+{
+    return adc_kernels()->name;
+}
+
+void adc_to_float(const int16_t *src, float *dst, size_t count, float factor, float shift)
+{
+    size_t done = adc_kernels()->contiguous(src, dst, count, factor, shift);
+    adc_scalar(src + done, dst + done, count - done, factor, shift);
+}
+
+void adc_to_float_strided(const int16_t *src, size_t stride, float *dst, size_t count,
+                          float factor, float shift)
+{
+    size_t done = adc_kernels()->strided(src, stride, dst, count, factor, shift);
+    adc_strided_scalar(src + done * stride, stride, dst + done, count - done, factor, shift);
+}
+
+void adc_to_double_strided(const int16_t *src, size_t stride, double *dst, size_t count,
+                           double factor, double shift)
+{
+    size_t done = adc_kernels()->strided_double(src, stride, dst, count, factor, shift);
+    adc_double_scalar(src + done * stride, stride, dst + done, count - done, factor, shift);
+}
+
+void adc_to_float_inplace(void *buffer, size_t count, float factor, float shift)
+{
+    uint8_t *p = buffer;
+    size_t done = adc_kernels()->inplace(p, count, factor, shift);
+    adc_inplace_scalar(p, count - done, factor, shift);
+}
@@ -0,0 +1,44 @@
+#ifndef LIBABF_ADC_CONVERT_H_
+#define LIBABF_ADC_CONVERT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Conversion of ADC samples to user units
+ *
+ * Each function computes dst[i] = src[i * stride] * factor + shift for
+ * `count` samples, which is how ABF integer data is scaled to user
+ * units. Vector kernels are selected at runtime from the features of
+ * the host CPU. Kernels with fused multiply-add round once instead of
+ * twice, so their results may differ from the scalar loop in the last
+ * bit. */
+
+/* Contiguous samples */
+void adc_to_float(const int16_t *src, float *dst, size_t count, float factor, float shift);
+
+/* One channel of multiplexed samples: src points at the first sample
+ * of the channel and `stride` is the number of channels. Only the
+ * samples src[i * stride] for i < count are read. */
+void adc_to_float_strided(const int16_t *src, size_t stride, float *dst, size_t count,
+                          float factor, float shift);
+
+/* As adc_to_float_strided, with the scaling done in double precision */
+void adc_to_double_strided(const int16_t *src, size_t stride, double *dst, size_t count,
+                           double factor, double shift);
+
+/* Converts `count` int16 samples at the start of `buffer` to floats
+ * over the same buffer, which must hold `count` floats */
+void adc_to_float_inplace(void *buffer, size_t count, float factor, float shift);
+
+/* Name of the kernel set used by the functions above */
+const char *adc_convert_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBABF_ADC_CONVERT_H_ */
@@ -5,6 +5,10 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* read_* functions
  * 
  * Each function reads the appropriate data type from the *buffer* at
@@ -42,4 +46,8 @@ char *read_int32p(char *buf, int32_t *to, bool swap);
 char *read_uint64p(char *buf, uint64_t *to, bool swap);
 char *read_int64p(char *buf, int64_t *to, bool swap);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
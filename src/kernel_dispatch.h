@@ -0,0 +1,42 @@
+#ifndef LIBABF_KERNEL_DISPATCH_H_
+#define LIBABF_KERNEL_DISPATCH_H_
+
+#include <stddef.h>
+
+/* Runtime kernel selection
+ *
+ * swap.c and adc_convert.c pick a table of kernels from the features of
+ * the host CPU on first use and keep it in a static pointer.
+ * kernel_dispatch() returns the table in `*slot`, calling `select` to
+ * fill it the first time. The slot is only accessed atomically, so
+ * threads that make their first calls at the same time may each run
+ * `select`, but they store the same table and never race on the slot.
+ */
+
+typedef const void *(*kernel_select_fn)(void);
+
+#if defined(__GNUC__)
+#define KERNEL_DISPATCH_LOAD(slot)         __atomic_load_n((slot), __ATOMIC_ACQUIRE)
+#define KERNEL_DISPATCH_STORE(slot, value) __atomic_store_n((slot), (value), __ATOMIC_RELEASE)
+#define KERNEL_DISPATCH_INLINE static inline
+#elif defined(_MSC_VER)
+/* MSVC gives accesses to aligned volatile pointers acquire and release
+ * semantics */
+#define KERNEL_DISPATCH_LOAD(slot)         (*(slot))
+#define KERNEL_DISPATCH_STORE(slot, value) (*(slot) = (value))
+#define KERNEL_DISPATCH_INLINE static __inline
+#else
+#error "kernel_dispatch.h: no atomic pointer access for this compiler"
+#endif
+
+KERNEL_DISPATCH_INLINE const void *kernel_dispatch(const void *volatile *slot, kernel_select_fn select)
+{
+    const void *kernels = KERNEL_DISPATCH_LOAD(slot);
+    if (kernels == NULL) {
+        kernels = select();
+        KERNEL_DISPATCH_STORE(slot, kernels);
+    }
+    return kernels;
+}
+
+#endif /* LIBABF_KERNEL_DISPATCH_H_ */
@@ -18,8 +18,8 @@
 # endif
 #endif
 
-/* If not using C99, create boolean macros as in stdbool ourselves */
-#if C99
+/* If not using C99 or C++, create boolean macros as in stdbool ourselves */
+#if defined(C99) || defined(__cplusplus)
 #include <stdbool.h>
 #else
 #define bool int8_t
@@ -27,11 +27,14 @@
 #define false 0
 #define __bool_true_false_are_defined 1
 #endif
+/* Also defined by abf2_struct.h, which may come first */
+#ifndef ABF2_STRUCT_H
 /* Ensure that booleans in filedata are 8-bit */
 typedef int8_t t_BOOL;
 
 /* FALSE = 0, TRUE = 1 */
 typedef enum { FALSE, TRUE } Boolean;
+#endif
 
 typedef int32_t INT;
 typedef uint32_t UINT;
@@ -0,0 +1,67 @@
+/**
+ * @file crcstream.h
+ * @brief CRC-32 computing pass-through decorator for any stream
+ *
+ * A crcstream forwards every operation to the stream it wraps and
+ * feeds the bytes that go through it, in either direction, into a
+ * CRC-32. The checksum is the one the ABF file CRC uses (CRC::CRC_32
+ * in Common/crc.cpp: reflected polynomial 0x04C11DB7, initial value
+ * and final xor 0xFFFFFFFF), so a file can be validated in the same
+ * pass that reads it instead of in a second pass over all its blocks.
+ *
+ * The checksum covers one contiguous run of bytes, starting where the
+ * wrapped stream was positioned when the decorator was created. Bytes
+ * are added when a read or write reaches the end of the run; reads
+ * that lie before it (re-reads) or beyond it (skips) leave the CRC
+ * alone. crcstream_value() reports how far the run extends, so the
+ * caller can tell whether the whole file was covered.
+ *
+ * A range can be masked so that it is checksummed as zeros; this is
+ * how the CRC field inside the ABF header is excluded from its own
+ * checksum.
+ *
+ * The decorator does not take ownership of the wrapped stream, which
+ * must outlive it. One thread at a time may use a crcstream.
+ */
+#ifndef CRCSTREAM_H
+#define CRCSTREAM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "stream.h"
+
+typedef struct crcstream crcstream_dt;
+
+StreamError crcstream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError crcstream_write(stream_dt *stream, const void *ptr, size_t size);
+StreamError crcstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError crcstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError crcstream_length(stream_dt *stream, streampos_dt *length);
+StreamError crcstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+bool crcstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
+bool crcstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining data fits size bytes */
+
+/** Wrap `inner` in a CRC-32 decorator, starting the run at its current position. */
+StreamError crcstream_create(stream_dt *inner, stream_dt **stream);
+StreamError crcstream_destroy(stream_dt *stream);
+
+/**
+ * Checksum the `size` bytes at `offset` as if they were zero. Only one
+ * range can be masked; a new call replaces the previous range.
+ */
+StreamError crcstream_mask(stream_dt *stream, streampos_dt offset, size_t size);
+
+/**
+ * Current CRC-32 of the run, and the offset one past its last byte in
+ * `end`. Either pointer may be NULL.
+ */
+StreamError crcstream_value(stream_dt *stream, uint32_t *crc, streampos_dt *end);
+
+/** Restart the run, empty, at the wrapped stream's current position. */
+StreamError crcstream_reset(stream_dt *stream);
+
+/** Continue the CRC-32 `crc` (0 to start) over `size` bytes at `data`. */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size);
+
+#endif
@@ -0,0 +1,358 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream.h"
+#include "fdstream.h"
+
+#include "memory.c"
+
+#if defined(_POSIX_VERSION)
+# define FDSTREAM_USE_PREAD
+# include <fcntl.h>
+# include <sys/stat.h>
+# if defined(__GLIBC__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#  define FDSTREAM_USE_PREADV
+#  include <sys/uio.h>
+# endif
+#endif
+
+/* Requests separated by at most this many bytes are read in one
+ * transfer; the bytes in between are read and discarded. ABF2
+ * sections are padded to 512-byte blocks, so this bridges the
+ * padding between neighbouring header sections. */
+#define FDSTREAM_MAXGAP 4096
+/* Maximum number of requests merged into one transfer */
+#define FDSTREAM_MAXRUN 32
+
+struct fdstream
+{
+    stream_dt base;
+    streampos_dt data_length;
+    streampos_dt position;
+    bool writable;
+#ifdef FDSTREAM_USE_PREAD
+    int fd;
+#else
+    FILE *fp;
+#endif
+};
+
+struct stream_operations fdstream_ops = {
+    .read = fdstream_read,
+    .write = fdstream_write,
+    .seek = fdstream_seek,
+    .tell = fdstream_tell,
+    .sizefits = fdstream_sizefits,
+    .posfits = fdstream_posfits,
+    .length = fdstream_length,
+    .readat = fdstream_readat,
+    .readv = fdstream_readv
+};
+
+#ifdef FDSTREAM_USE_PREAD
+/* pread()/pwrite() may transfer less than asked for; loop until done */
+static bool fdstream_preadAll(fdstream_dt *self, streampos_dt offset, void *ptr, size_t size)
+{
+    uint8_t *to = ptr;
+    while (size > 0) {
+        ssize_t n = pread(self->fd, to, size, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        to += n;
+        offset += (streampos_dt)n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static StreamError fdstream_pwriteAll(fdstream_dt *self, streampos_dt offset, const void *ptr, size_t size)
+{
+    const uint8_t *from = ptr;
+    while (size > 0) {
+        ssize_t n = pwrite(self->fd, from, size, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return (errno == ENOSPC) ? StreamError_NoSpace : StreamError_Failure;
+        if (n == 0)
+            return StreamError_Failure;
+        from += n;
+        offset += (streampos_dt)n;
+        size -= (size_t)n;
+    }
+    return StreamError_Success;
+}
+
+static StreamError fdstream_openFile(fdstream_dt *self, const char *path)
+{
+    struct stat st;
+    int flags = self->writable ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+    self->fd = open(path, flags, 0666);
+    if (self->fd < 0)
+        return StreamError_Failure;
+    if (fstat(self->fd, &st) != 0)
+        return StreamError_Failure;
+    self->data_length = (streampos_dt)st.st_size;
+    return StreamError_Success;
+}
+
+static void fdstream_closeFile(fdstream_dt *self)
+{
+    if (self->fd >= 0)
+        close(self->fd);
+    self->fd = -1;
+}
+#else
+static bool fdstream_preadAll(fdstream_dt *self, streampos_dt offset, void *ptr, size_t size)
+{
+    if (fseek(self->fp, (long)offset, SEEK_SET) != 0)
+        return false;
+    return fread(ptr, 1, size, self->fp) == size;
+}
+
+static StreamError fdstream_pwriteAll(fdstream_dt *self, streampos_dt offset, const void *ptr, size_t size)
+{
+    if (fseek(self->fp, (long)offset, SEEK_SET) != 0)
+        return StreamError_Failure;
+    errno = 0;
+    if (fwrite(ptr, 1, size, self->fp) != size)
+        return (errno == ENOSPC) ? StreamError_NoSpace : StreamError_Failure;
+    return StreamError_Success;
+}
+
+static StreamError fdstream_openFile(fdstream_dt *self, const char *path)
+{
+    long size;
+    self->fp = fopen(path, self->writable ? "w+b" : "rb");
+    if (self->fp == NULL)
+        return StreamError_Failure;
+    if (fseek(self->fp, 0, SEEK_END) != 0 || (size = ftell(self->fp)) < 0)
+        return StreamError_Failure;
+    self->data_length = (streampos_dt)size;
+    return StreamError_Success;
+}
+
+static void fdstream_closeFile(fdstream_dt *self)
+{
+    if (self->fp != NULL)
+        fclose(self->fp);
+    self->fp = NULL;
+}
+#endif
+
+/* Read the sorted, non-overlapping requests run[0..count) with a
+ * single preadv(), pointing the gaps between them at a scratch
+ * buffer */
+static bool fdstream_preadRun(fdstream_dt *self, const struct stream_iovec **run, size_t count)
+{
+#ifdef FDSTREAM_USE_PREADV
+    uint8_t gap[FDSTREAM_MAXGAP];
+    struct iovec iov[2 * FDSTREAM_MAXRUN];
+    struct iovec *next = iov;
+    int iovcnt = 0;
+    streampos_dt offset = run[0]->offset;
+    streampos_dt end = offset;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (run[i]->offset > end) {
+            iov[iovcnt].iov_base = gap;
+            iov[iovcnt].iov_len = (size_t)(run[i]->offset - end);
+            iovcnt++;
+        }
+        iov[iovcnt].iov_base = run[i]->ptr;
+        iov[iovcnt].iov_len = run[i]->size;
+        iovcnt++;
+        end = run[i]->offset + run[i]->size;
+    }
+
+    while (offset < end) {
+        ssize_t n = preadv(self->fd, next, iovcnt, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        offset += (streampos_dt)n;
+        /* short read: skip the filled iovecs and trim the partial one */
+        while (iovcnt > 0 && (size_t)n >= next->iov_len) {
+            n -= (ssize_t)next->iov_len;
+            next++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            next->iov_base = (uint8_t*)next->iov_base + n;
+            next->iov_len -= (size_t)n;
+        }
+    }
+    return true;
+#else
+    size_t i;
+    for (i = 0; i < count; i++) {
+        if (!fdstream_preadAll(self, run[i]->offset, run[i]->ptr, run[i]->size))
+            return false;
+    }
+    return true;
+#endif
+}
+
+static StreamError fdstream_open(const char *path, bool writable, stream_dt **stream)
+{
+    StreamError err;
+    *stream = NULL;
+    fdstream_dt *self = NEW(fdstream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "FdStream";
+    self->base.ops = &fdstream_ops;
+    self->data_length = 0;
+    self->position = 0;
+    self->writable = writable;
+
+    err = fdstream_openFile(self, path);
+    if (err != StreamError_Success) {
+        fdstream_destroy((stream_dt*)self);
+        return err;
+    }
+
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError fdstream_openForRead(const char *path, stream_dt **stream)
+{
+    return fdstream_open(path, false, stream);
+}
+
+StreamError fdstream_openForWrite(const char *path, stream_dt **stream)
+{
+    return fdstream_open(path, true, stream);
+}
+
+StreamError fdstream_destroy(stream_dt *super)
+{
+    fdstream_dt *self = (fdstream_dt*)super;
+    fdstream_closeFile(self);
+    FREE(self);
+    return StreamError_Success;
+}
+
+StreamError fdstream_tell(stream_dt *stream, streampos_dt *curr_pos)
+{
+    *curr_pos = ((fdstream_dt*)stream)->position;
+    return StreamError_Success;
+}
+
+StreamError fdstream_length(stream_dt *stream, streampos_dt *length)
+{
+    *length = ((fdstream_dt*)stream)->data_length;
+    return StreamError_Success;
+}
+
+StreamError fdstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    streampos_dt new_position = offset + origin;
+    if (!fdstream_posfits(stream, new_position))
+        return StreamError_NoSpace;
+    self->position = new_position;
+    return StreamError_Success;
+}
+
+StreamError fdstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    if (offset > self->data_length || size > self->data_length - offset)
+        return StreamError_NoSpace;
+    if (!fdstream_preadAll(self, offset, ptr, size))
+        return StreamError_Failure;
+    return StreamError_Success;
+}
+
+StreamError fdstream_read(stream_dt *stream, void *ptr, size_t size)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    StreamError err = fdstream_readat(stream, self->position, ptr, size);
+    if (err == StreamError_Success)
+        self->position += size;
+    return err;
+}
+
+StreamError fdstream_write(stream_dt *stream, const void *ptr, size_t size)
+{
+    StreamError err;
+    fdstream_dt *self = (fdstream_dt*)stream;
+    if (!self->writable)
+        return StreamError_Failure;
+    err = fdstream_pwriteAll(self, self->position, ptr, size);
+    if (err != StreamError_Success)
+        return err;
+    self->position += size;
+    if (self->position > self->data_length)
+        self->data_length = self->position;
+    return StreamError_Success;
+}
+
+/* A writable stream may be positioned at its end in order to append */
+bool fdstream_posfits(stream_dt *stream, streampos_dt position)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    if (self->writable)
+        return position <= self->data_length;
+    return position < self->data_length;
+}
+
+bool fdstream_sizefits(stream_dt *stream, size_t size)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    if (self->writable)
+        return true;
+    return size <= self->data_length - self->position;
+}
+
+static int fdstream_compareOffsets(const void *a, const void *b)
+{
+    const struct stream_iovec *x = *(const struct stream_iovec * const *)a;
+    const struct stream_iovec *y = *(const struct stream_iovec * const *)b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+StreamError fdstream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count)
+{
+    fdstream_dt *self = (fdstream_dt*)stream;
+    const struct stream_iovec **order;
+    size_t first, last, i;
+    bool ok = true;
+
+    for (i = 0; i < count; i++) {
+        if (vec[i].offset > self->data_length || vec[i].size > self->data_length - vec[i].offset)
+            return StreamError_NoSpace;
+    }
+    if (count == 0)
+        return StreamError_Success;
+
+    order = malloc(count * sizeof(*order));
+    if (order == NULL)
+        return StreamError_NoMemory;
+    for (i = 0; i < count; i++)
+        order[i] = &vec[i];
+    qsort(order, count, sizeof(*order), fdstream_compareOffsets);
+
+    for (first = 0; ok && first < count; first = last) {
+        streampos_dt end = order[first]->offset + order[first]->size;
+        for (last = first + 1; last < count && last - first < FDSTREAM_MAXRUN; last++) {
+            if (order[last]->offset < end || order[last]->offset - end > FDSTREAM_MAXGAP)
+                break;
+            end = order[last]->offset + order[last]->size;
+        }
+        ok = fdstream_preadRun(self, order + first, last - first);
+    }
+    free(order);
+    return ok ? StreamError_Success : StreamError_Failure;
+}
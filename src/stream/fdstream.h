@@ -0,0 +1,38 @@
+/**
+ * @file fdstream.h
+ * @brief file stream built on positional reads and writes
+ *
+ * An fdstream keeps no shared file cursor: every transfer names its
+ * own file offset (pread()/pwrite() on POSIX systems). The stream
+ * position used by stream_read() and stream_seek() lives in the
+ * stream object only, so stream_readAt() may be called from several
+ * threads on one fdstream at once, each reading a different section
+ * of the file.
+ *
+ * On systems without positional I/O the stream is backed by a FILE
+ * and stream_readAt() seeks internally; it is then not thread-safe.
+ */
+#ifndef FDSTREAM_H
+#define FDSTREAM_H
+
+#include <stdlib.h>
+
+#include "stream.h"
+
+typedef struct fdstream fdstream_dt;
+
+StreamError fdstream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError fdstream_write(stream_dt *stream, const void *ptr, size_t size);
+StreamError fdstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError fdstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError fdstream_length(stream_dt *stream, streampos_dt *length);
+StreamError fdstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+StreamError fdstream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count);
+bool fdstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
+bool fdstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining space fits size bytes */
+
+StreamError fdstream_openForRead(const char *path, stream_dt **stream);
+StreamError fdstream_openForWrite(const char *path, stream_dt **stream); /**< creates or truncates */
+StreamError fdstream_destroy(stream_dt *stream);
+
+#endif
@@ -7,12 +7,17 @@
 
 #include "memory.c"
 
+/* Minimum capacity of a growable memstream once it holds any data */
+#define MEMSTREAM_MIN_CAPACITY 4096
+
 struct memstream
 {
     stream_dt base;
     streampos_dt data_length;
     streampos_dt position;
     uint8_t *data;
+    bool growable;              /**< writes past the end grow the buffer */
+    size_t capacity;            /**< allocated size of data (growable only) */
 };
 
 struct stream_operations memstream_ops = {
@@ -21,7 +26,10 @@ struct stream_operations memstream_ops = {
     .seek = memstream_seek,
     .tell = memstream_tell,
     .sizefits = memstream_sizefits,
-    .posfits = memstream_posfits
+    .posfits = memstream_posfits,
+    .length = memstream_length,
+    .view = memstream_view,
+    .readat = memstream_readat
 };
 
 StreamError memstream_create(size_t numberBytes, stream_dt **stream)
@@ -43,10 +51,92 @@ StreamError memstream_create(size_t numberBytes, stream_dt **stream)
 
     self->data_length = (size_t)numberBytes;
     self->position = 0;
+    self->growable = false;
+    self->capacity = numberBytes;
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError memstream_createGrowable(size_t initialBytes, stream_dt **stream)
+{
+    *stream = NULL;
+    memstream_dt *self = NEW(memstream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "MemStream";
+    self->base.ops = &memstream_ops;
+    self->data = NULL;
+    self->data_length = 0;
+    self->position = 0;
+    self->growable = true;
+    self->capacity = 0;
+
+    if (initialBytes > 0) {
+        self->data = malloc(initialBytes);
+        if (self->data == NULL) {
+            memstream_destroy((stream_dt*)self);
+            return StreamError_NoMemory;
+        }
+        self->capacity = initialBytes;
+    }
+
     *stream = (stream_dt*)self;
     return StreamError_Success;
 }
 
+/* Grow a growable memstream so that it can hold `needed` bytes. The
+ * capacity at least doubles, so n appends cost O(n) copying overall. */
+static StreamError memstream_reserve(memstream_dt *self, streampos_dt needed)
+{
+    size_t capacity;
+    uint8_t *data;
+    if (needed <= self->capacity)
+        return StreamError_Success;
+    if (needed > SIZE_MAX)
+        return StreamError_NoMemory;
+
+    capacity = (self->capacity < MEMSTREAM_MIN_CAPACITY) ? MEMSTREAM_MIN_CAPACITY : self->capacity;
+    while (capacity < needed) {
+        if (capacity > SIZE_MAX / 2) {
+            capacity = (size_t)needed;
+            break;
+        }
+        capacity *= 2;
+    }
+
+    data = realloc(self->data, capacity);
+    if (data == NULL)
+        return StreamError_NoMemory;
+    self->data = data;
+    self->capacity = capacity;
+    return StreamError_Success;
+}
+
+StreamError memstream_detach(stream_dt *stream, void **data, size_t *size)
+{
+    memstream_dt *self = (memstream_dt*)stream;
+    if (!self->growable)
+        return StreamError_Failure;
+    *data = self->data;
+    *size = (size_t)self->data_length;
+    self->data = NULL;
+    self->data_length = 0;
+    self->position = 0;
+    self->capacity = 0;
+    return StreamError_Success;
+}
+
+StreamError memstream_writeTo(stream_dt *stream, stream_dt *to)
+{
+    memstream_dt *self = (memstream_dt*)stream;
+    if (self->data_length == 0)
+        return StreamError_Success;
+    /* Through the ops table, so memstream.c does not depend on stream.c */
+    return to->ops->write(to, self->data, (size_t)self->data_length);
+}
+
 StreamError memstream_destroy(stream_dt *super)
 {
     memstream_dt* self = (memstream_dt*)super;
@@ -100,57 +190,89 @@ StreamError memstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt
     return StreamError_Success;
 }
 
-StreamError stream_seekFromEnd(stream_dt *stm, streampos_dt offset)
+StreamError memstream_length(stream_dt *stream, streampos_dt *length)
+{
+    *length = ((memstream_dt*)stream)->data_length;
+    return StreamError_Success;
+}
+
+StreamError memstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr)
 {
-    memstream_dt *self = (memstream_dt*) stm;
-    streampos_dt lastByte = self->data_length - 1;
-    return memstream_seek((stream_dt*)self, -offset, lastByte);
+    memstream_dt *self = (memstream_dt*) stream;
+    if (offset > self->data_length || size > self->data_length - offset)
+        return StreamError_NoSpace;
+    *ptr = self->data + offset;
+    return StreamError_Success;
 }
 
 StreamError memstream_write(stream_dt *stream, const void *ptr, size_t size)
 {
     memstream_dt* self = (memstream_dt*) stream;
-    if (!memstream_sizefits((stream_dt*)self, size)) {
+    if (self->growable) {
+        if (memstream_reserve(self, self->position + size) != StreamError_Success)
+            return StreamError_NoMemory;
+    } else if (!memstream_sizefits((stream_dt*)self, size)) {
         return StreamError_NoSpace;
     }
-    memcpy(self->data, ptr, size);
-    memstream_seek((stream_dt*)self, size, self->position);
+    if (size > 0)
+        memcpy(self->data + self->position, ptr, size);
+    self->position += size;
+    if (self->position > self->data_length)
+        self->data_length = self->position;
     return StreamError_Success;
 }
 
 StreamError memstream_read(stream_dt *stream, void *ptr, size_t size)
 {
     memstream_dt *self = (memstream_dt*)stream;
-    if (!memstream_sizefits((stream_dt*)self, size)) {
+    if (size > self->data_length - self->position) {
         return StreamError_NoSpace;
     }
-    memcpy(ptr, self->data, size);
-    memstream_seek((stream_dt*)self, size, self->position);
+    if (size > 0)
+        memcpy(ptr, self->data + self->position, size);
+    self->position += size;
     return StreamError_Success;
 }
 
+/* A growable stream may be positioned at its end in order to append */
 bool memstream_posfits(stream_dt *stream, streampos_dt position)
 {
     memstream_dt *self = (memstream_dt*) stream;
-    if (0 <= position && self->data_length > position) {
-        return true;
-    }
-    return false;
+    if (self->growable)
+        return position <= self->data_length;
+    return position < self->data_length;
 }
 
 bool memstream_sizefits(stream_dt *stream, size_t size)
 {
     memstream_dt *self = (memstream_dt*) stream;
-    if (memstream_posfits((stream_dt*)self, self->position + size)) {
+    if (self->growable)
         return true;
-    }
-    return false;
+    return size <= self->data_length - self->position;
 }
 
+/* A growable stream has no fixed size, so it grows to fit the data */
 StreamError memstream_fillData(memstream_dt *ms, const uint8_t *from, size_t size)
 {
-    if (!memstream_sizefits((stream_dt *)ms, size))
+    if (ms->growable) {
+        if (memstream_reserve(ms, size) != StreamError_Success)
+            return StreamError_NoMemory;
+        if (size > ms->data_length)
+            ms->data_length = size;
+    } else if (!memstream_sizefits((stream_dt *)ms, size)) {
         return StreamError_NoSpace;
-    memcpy(ms->data, from, size);
+    }
+    if (size > 0)
+        memcpy(ms->data, from, size);
+    return StreamError_Success;
+}
+
+StreamError memstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    const void *from;
+    StreamError err = memstream_view(stream, offset, size, &from);
+    if (StreamError_Success != err)
+        return err;
+    memcpy(ptr, from, size);
     return StreamError_Success;
 }
@@ -11,6 +11,9 @@ StreamError memstream_read(stream_dt *stream, void *ptr, size_t size);
 StreamError memstream_write(stream_dt *stream, const void *ptr, size_t size);
 StreamError memstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
 StreamError memstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError memstream_length(stream_dt *stream, streampos_dt *length);
+StreamError memstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr);
+StreamError memstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
 bool memstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
 bool memstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining space fits size byte */
 
@@ -20,6 +23,27 @@ void *allocateByteArray(int numberBytes);
 StreamError memstream_create(size_t numberBytes, stream_dt **stream);
 StreamError memstream_destroy(stream_dt *stream);
 
+/**
+ * Create an empty memstream that grows as it is written.
+ *
+ * Writes at or past the end extend the stream; the buffer grows
+ * geometrically, starting from `initialBytes` of capacity. Growing
+ * may move the buffer, so pointers from stream_view() are only valid
+ * until the next write.
+ */
+StreamError memstream_createGrowable(size_t initialBytes, stream_dt **stream);
+
+/**
+ * Take ownership of the contents of a growable memstream.
+ *
+ * On success `*data` points to the `*size` bytes written so far, and
+ * the caller must free() it. The stream is left empty.
+ */
+StreamError memstream_detach(stream_dt *stream, void **data, size_t *size);
+
+/** Write the whole contents of a memstream to `to` with one write */
+StreamError memstream_writeTo(stream_dt *stream, stream_dt *to);
+
 /* For testing only */
 int8_t memstream_getByteAt(stream_dt *stream, streampos_dt index);
 StreamError memstream_fillData(memstream_dt *memstream, const uint8_t *from, size_t size);
@@ -0,0 +1,217 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream.h"
+#include "mmapstream.h"
+
+#include "memory.c"
+
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+# define MMAPSTREAM_USE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+struct mmapstream
+{
+    stream_dt base;
+    streampos_dt data_length;
+    streampos_dt position;
+    uint8_t *data;
+    bool is_mapped;             /**< data must be munmap()ed, not freed */
+};
+
+struct stream_operations mmapstream_ops = {
+    .read = mmapstream_read,
+    .write = mmapstream_write,
+    .seek = mmapstream_seek,
+    .tell = mmapstream_tell,
+    .sizefits = mmapstream_sizefits,
+    .posfits = mmapstream_posfits,
+    .length = mmapstream_length,
+    .view = mmapstream_view,
+    .readat = mmapstream_readat
+};
+
+#ifdef MMAPSTREAM_USE_MMAP
+static StreamError mmapstream_map(mmapstream_dt *self, const char *path)
+{
+    struct stat st;
+    void *addr;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return StreamError_Failure;
+
+    if (fstat(fd, &st) != 0 || st.st_size < 0) {
+        close(fd);
+        return StreamError_Failure;
+    }
+    self->data_length = (streampos_dt)st.st_size;
+    if (self->data_length == 0) {
+        /* mmap() rejects empty mappings; an empty stream needs no data */
+        close(fd);
+        return StreamError_Success;
+    }
+
+    addr = mmap(NULL, (size_t)self->data_length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);              /* the mapping holds its own reference */
+    if (addr == MAP_FAILED)
+        return StreamError_NoMemory;
+
+    self->data = addr;
+    self->is_mapped = true;
+    return StreamError_Success;
+}
+#endif
+
+/* Portable fallback: read the whole file into a heap buffer */
+static StreamError mmapstream_load(mmapstream_dt *self, const char *path)
+{
+    long size;
+    uint8_t *buffer;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        return StreamError_Failure;
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0
+        || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return StreamError_Failure;
+    }
+    self->data_length = (streampos_dt)size;
+    if (size == 0) {
+        fclose(fp);
+        return StreamError_Success;
+    }
+
+    buffer = malloc((size_t)size);
+    if (buffer == NULL) {
+        fclose(fp);
+        return StreamError_NoMemory;
+    }
+    if (fread(buffer, 1, (size_t)size, fp) != (size_t)size) {
+        free(buffer);
+        fclose(fp);
+        return StreamError_Failure;
+    }
+    fclose(fp);
+
+    self->data = buffer;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_open(const char *path, stream_dt **stream)
+{
+    StreamError err;
+    *stream = NULL;
+    mmapstream_dt *self = NEW(mmapstream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "MMapStream";
+    self->base.ops = &mmapstream_ops;
+    self->data_length = 0;
+    self->position = 0;
+    self->data = NULL;
+    self->is_mapped = false;
+
+#ifdef MMAPSTREAM_USE_MMAP
+    err = mmapstream_map(self, path);
+    if (err == StreamError_NoMemory)    /* mapping refused; try a plain read */
+        err = mmapstream_load(self, path);
+#else
+    err = mmapstream_load(self, path);
+#endif
+    if (err != StreamError_Success) {
+        mmapstream_destroy((stream_dt*)self);
+        return err;
+    }
+
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_destroy(stream_dt *super)
+{
+    mmapstream_dt *self = (mmapstream_dt*)super;
+#ifdef MMAPSTREAM_USE_MMAP
+    if (self->is_mapped) {
+        munmap(self->data, (size_t)self->data_length);
+        self->data = NULL;
+    }
+#endif
+    FREE(self->data);
+    FREE(self);
+    return StreamError_Success;
+}
+
+StreamError mmapstream_tell(stream_dt *stream, streampos_dt *curr_pos)
+{
+    *curr_pos = ((mmapstream_dt*)stream)->position;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_length(stream_dt *stream, streampos_dt *length)
+{
+    *length = ((mmapstream_dt*)stream)->data_length;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin)
+{
+    mmapstream_dt *self = (mmapstream_dt*)stream;
+    streampos_dt new_position = offset + origin;
+    if (!mmapstream_posfits(stream, new_position))
+        return StreamError_NoSpace;
+    self->position = new_position;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_write(stream_dt *stream, const void *ptr, size_t size)
+{
+    return StreamError_Failure;
+}
+
+StreamError mmapstream_read(stream_dt *stream, void *ptr, size_t size)
+{
+    mmapstream_dt *self = (mmapstream_dt*)stream;
+    if (!mmapstream_sizefits(stream, size))
+        return StreamError_NoSpace;
+    memcpy(ptr, self->data + self->position, size);
+    self->position += size;
+    return StreamError_Success;
+}
+
+StreamError mmapstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr)
+{
+    mmapstream_dt *self = (mmapstream_dt*)stream;
+    if (offset > self->data_length || size > self->data_length - offset)
+        return StreamError_NoSpace;
+    *ptr = self->data + offset;
+    return StreamError_Success;
+}
+
+bool mmapstream_posfits(stream_dt *stream, streampos_dt position)
+{
+    return position < ((mmapstream_dt*)stream)->data_length;
+}
+
+bool mmapstream_sizefits(stream_dt *stream, size_t size)
+{
+    mmapstream_dt *self = (mmapstream_dt*)stream;
+    return size <= self->data_length - self->position;
+}
+
+StreamError mmapstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    const void *from;
+    StreamError err = mmapstream_view(stream, offset, size, &from);
+    if (StreamError_Success != err)
+        return err;
+    memcpy(ptr, from, size);
+    return StreamError_Success;
+}
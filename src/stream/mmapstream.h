@@ -0,0 +1,35 @@
+/**
+ * @file mmapstream.h
+ * @brief read-only stream over a memory-mapped file
+ *
+ * The whole file is mapped once when the stream is opened, and reads
+ * are served directly out of the mapping. stream_view() returns
+ * pointers into the mapping, so header sections and data blocks can
+ * be decoded without any intermediate copy.
+ *
+ * On systems without memory-mapped files the file is read into a
+ * heap buffer instead; the interface is the same.
+ */
+#ifndef MMAPSTREAM_H
+#define MMAPSTREAM_H
+
+#include <stdlib.h>
+
+#include "stream.h"
+
+typedef struct mmapstream mmapstream_dt;
+
+StreamError mmapstream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError mmapstream_write(stream_dt *stream, const void *ptr, size_t size); /**< always fails */
+StreamError mmapstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError mmapstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError mmapstream_length(stream_dt *stream, streampos_dt *length);
+StreamError mmapstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr);
+StreamError mmapstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+bool mmapstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
+bool mmapstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining data fits size bytes */
+
+StreamError mmapstream_open(const char *path, stream_dt **stream);
+StreamError mmapstream_destroy(stream_dt *stream);
+
+#endif
@@ -0,0 +1,379 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream.h"
+#include "readaheadstream.h"
+
+#include "memory.c"
+
+#if defined(_POSIX_THREADS) && (_POSIX_THREADS > 0)
+# define READAHEAD_USE_THREADS
+# include <pthread.h>
+#endif
+
+/* Number of back-to-back sequential reads before prefetching starts */
+#define READAHEAD_TRIGGER 2
+
+typedef enum ReadaheadState {
+    ReadaheadState_Empty,       /**< holds no data */
+    ReadaheadState_Pending,     /**< waiting for the worker */
+    ReadaheadState_Filling,     /**< owned by the worker */
+    ReadaheadState_Ready        /**< holds data, or an error */
+} ReadaheadState;
+
+struct readahead_buffer
+{
+    streampos_dt offset;
+    size_t size;
+    uint8_t *data;
+    ReadaheadState state;
+    StreamError err;
+};
+
+struct readaheadstream
+{
+    stream_dt base;
+    stream_dt *inner;
+    streampos_dt data_length;
+    streampos_dt position;
+    size_t window;
+    size_t depth;
+    struct readahead_buffer *buffers;
+    streampos_dt next_expected; /**< where a sequential read would start */
+    unsigned sequential;        /**< number of sequential reads in a row */
+#ifdef READAHEAD_USE_THREADS
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_mutex_t inner_lock; /**< serializes inner streams without readat */
+    pthread_cond_t work;        /**< a buffer became Pending, or stop was set */
+    pthread_cond_t filled;      /**< a buffer became Ready */
+    bool worker_started;
+    bool stop;
+#endif
+};
+
+struct stream_operations readaheadstream_ops = {
+    .read = readaheadstream_read,
+    .write = readaheadstream_write,
+    .seek = readaheadstream_seek,
+    .tell = readaheadstream_tell,
+    .sizefits = readaheadstream_sizefits,
+    .posfits = readaheadstream_posfits,
+    .length = readaheadstream_length,
+    .readat = readaheadstream_readat
+};
+
+static StreamError readahead_readInner(readaheadstream_dt *self, streampos_dt offset,
+                                       void *ptr, size_t size)
+{
+    StreamError err;
+#ifdef READAHEAD_USE_THREADS
+    bool shared = (self->inner->ops->readat == NULL);
+    if (shared)
+        pthread_mutex_lock(&self->inner_lock);
+    err = stream_readAt(self->inner, offset, ptr, size);
+    if (shared)
+        pthread_mutex_unlock(&self->inner_lock);
+#else
+    err = stream_readAt(self->inner, offset, ptr, size);
+#endif
+    return err;
+}
+
+static struct readahead_buffer *readahead_pendingBuffer(readaheadstream_dt *self)
+{
+    struct readahead_buffer *next = NULL;
+    size_t i;
+    for (i = 0; i < self->depth; i++) {
+        struct readahead_buffer *b = &self->buffers[i];
+        if (b->state == ReadaheadState_Pending && (next == NULL || b->offset < next->offset))
+            next = b;
+    }
+    return next;
+}
+
+#ifdef READAHEAD_USE_THREADS
+static void *readahead_worker(void *arg)
+{
+    readaheadstream_dt *self = arg;
+    struct readahead_buffer *b;
+
+    pthread_mutex_lock(&self->lock);
+    while (!self->stop) {
+        b = readahead_pendingBuffer(self);
+        if (b == NULL) {
+            pthread_cond_wait(&self->work, &self->lock);
+            continue;
+        }
+        b->state = ReadaheadState_Filling;
+        pthread_mutex_unlock(&self->lock);
+
+        b->err = readahead_readInner(self, b->offset, b->data, b->size);
+
+        pthread_mutex_lock(&self->lock);
+        b->state = ReadaheadState_Ready;
+        pthread_cond_broadcast(&self->filled);
+    }
+    pthread_mutex_unlock(&self->lock);
+    return NULL;
+}
+#else
+/* Without a worker thread, Pending buffers are filled on the spot */
+static void readahead_fillPending(readaheadstream_dt *self)
+{
+    struct readahead_buffer *b;
+    while ((b = readahead_pendingBuffer(self)) != NULL) {
+        b->err = readahead_readInner(self, b->offset, b->data, b->size);
+        b->state = ReadaheadState_Ready;
+    }
+}
+#endif
+
+static struct readahead_buffer *readahead_find(readaheadstream_dt *self, streampos_dt offset)
+{
+    size_t i;
+    for (i = 0; i < self->depth; i++) {
+        struct readahead_buffer *b = &self->buffers[i];
+        if (b->state != ReadaheadState_Empty
+            && b->offset <= offset && offset - b->offset < b->size)
+            return b;
+    }
+    return NULL;
+}
+
+/* Make the buffers cover the windows that follow `from`. Buffers
+ * already holding (or fetching) the contiguous run starting at `from`
+ * are kept; every other buffer not owned by the worker is pointed at
+ * the next window beyond that run. Called with the lock held. */
+static void readahead_schedule(readaheadstream_dt *self, streampos_dt from)
+{
+    struct readahead_buffer *b;
+    streampos_dt end = from;
+    size_t i;
+
+    while (end < self->data_length && (b = readahead_find(self, end)) != NULL)
+        end = b->offset + b->size;
+
+    for (i = 0; i < self->depth && end < self->data_length; i++) {
+        b = &self->buffers[i];
+        if (b->state == ReadaheadState_Filling)
+            continue;
+        if (b->state != ReadaheadState_Empty && b->offset + b->size > from && b->offset < end)
+            continue;   /* part of the run */
+        b->offset = end;
+        b->size = self->window;
+        if (b->size > self->data_length - end)
+            b->size = (size_t)(self->data_length - end);
+        b->state = ReadaheadState_Pending;
+        end += b->size;
+    }
+
+#ifdef READAHEAD_USE_THREADS
+    pthread_cond_signal(&self->work);
+#else
+    readahead_fillPending(self);
+#endif
+}
+
+static StreamError readahead_copy(readaheadstream_dt *self, streampos_dt offset,
+                                  uint8_t *to, size_t size)
+{
+    StreamError err = StreamError_Success;
+    struct readahead_buffer *b;
+    size_t n;
+
+    if (offset > self->data_length || size > self->data_length - offset)
+        return StreamError_NoSpace;
+
+#ifdef READAHEAD_USE_THREADS
+    pthread_mutex_lock(&self->lock);
+#endif
+    self->sequential = (offset == self->next_expected) ? self->sequential + 1 : 0;
+    self->next_expected = offset + size;
+
+    while (size > 0) {
+        b = readahead_find(self, offset);
+        if (b == NULL) {
+            if (self->sequential < READAHEAD_TRIGGER) {
+                /* random access: bypass the buffers */
+#ifdef READAHEAD_USE_THREADS
+                pthread_mutex_unlock(&self->lock);
+                err = readahead_readInner(self, offset, to, size);
+                pthread_mutex_lock(&self->lock);
+#else
+                err = readahead_readInner(self, offset, to, size);
+#endif
+                break;
+            }
+            readahead_schedule(self, offset);
+#ifdef READAHEAD_USE_THREADS
+            if (readahead_find(self, offset) == NULL)   /* all buffers busy */
+                pthread_cond_wait(&self->filled, &self->lock);
+#endif
+            continue;
+        }
+#ifdef READAHEAD_USE_THREADS
+        while (b->state != ReadaheadState_Ready)
+            pthread_cond_wait(&self->filled, &self->lock);
+#endif
+        if (b->err != StreamError_Success) {
+            err = b->err;
+            b->state = ReadaheadState_Empty;
+            break;
+        }
+        n = (size_t)(b->offset + b->size - offset);
+        if (n > size)
+            n = size;
+        memcpy(to, b->data + (offset - b->offset), n);
+        to += n;
+        offset += n;
+        size -= n;
+    }
+
+    if (err == StreamError_Success && self->sequential >= READAHEAD_TRIGGER)
+        readahead_schedule(self, offset);
+#ifdef READAHEAD_USE_THREADS
+    pthread_mutex_unlock(&self->lock);
+#endif
+    return err;
+}
+
+StreamError readaheadstream_create(stream_dt *inner, size_t window, size_t depth, stream_dt **stream)
+{
+    StreamError err;
+    size_t i;
+    *stream = NULL;
+    readaheadstream_dt *self = NEW(readaheadstream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "ReadaheadStream";
+    self->base.ops = &readaheadstream_ops;
+    self->inner = inner;
+    self->position = 0;
+    self->window = (window > 0) ? window : READAHEAD_DEFAULT_WINDOW;
+    self->depth = (depth > 0) ? depth : READAHEAD_DEFAULT_DEPTH;
+    self->next_expected = 0;
+    self->sequential = 0;
+
+    err = stream_length(inner, &self->data_length);
+    if (err != StreamError_Success) {
+        FREE(self);
+        return err;
+    }
+
+    self->buffers = calloc(self->depth, sizeof(*self->buffers));
+    if (self->buffers == NULL) {
+        FREE(self);
+        return StreamError_NoMemory;
+    }
+    for (i = 0; i < self->depth; i++) {
+        self->buffers[i].state = ReadaheadState_Empty;
+        self->buffers[i].data = malloc(self->window);
+        if (self->buffers[i].data == NULL)
+            err = StreamError_NoMemory;
+    }
+
+#ifdef READAHEAD_USE_THREADS
+    self->stop = false;
+    self->worker_started = false;
+    pthread_mutex_init(&self->lock, NULL);
+    pthread_mutex_init(&self->inner_lock, NULL);
+    pthread_cond_init(&self->work, NULL);
+    pthread_cond_init(&self->filled, NULL);
+    if (err == StreamError_Success) {
+        if (pthread_create(&self->worker, NULL, readahead_worker, self) == 0)
+            self->worker_started = true;
+        else
+            err = StreamError_Failure;
+    }
+#endif
+
+    if (err != StreamError_Success) {
+        readaheadstream_destroy((stream_dt*)self);
+        return err;
+    }
+
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError readaheadstream_destroy(stream_dt *super)
+{
+    readaheadstream_dt *self = (readaheadstream_dt*)super;
+    size_t i;
+
+#ifdef READAHEAD_USE_THREADS
+    if (self->worker_started) {
+        pthread_mutex_lock(&self->lock);
+        self->stop = true;
+        pthread_cond_signal(&self->work);
+        pthread_mutex_unlock(&self->lock);
+        pthread_join(self->worker, NULL);
+    }
+    pthread_cond_destroy(&self->filled);
+    pthread_cond_destroy(&self->work);
+    pthread_mutex_destroy(&self->inner_lock);
+    pthread_mutex_destroy(&self->lock);
+#endif
+
+    for (i = 0; i < self->depth; i++)
+        FREE(self->buffers[i].data);
+    FREE(self->buffers);
+    FREE(self);
+    return StreamError_Success;
+}
+
+StreamError readaheadstream_tell(stream_dt *stream, streampos_dt *curr_pos)
+{
+    *curr_pos = ((readaheadstream_dt*)stream)->position;
+    return StreamError_Success;
+}
+
+StreamError readaheadstream_length(stream_dt *stream, streampos_dt *length)
+{
+    *length = ((readaheadstream_dt*)stream)->data_length;
+    return StreamError_Success;
+}
+
+StreamError readaheadstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin)
+{
+    readaheadstream_dt *self = (readaheadstream_dt*)stream;
+    streampos_dt new_position = offset + origin;
+    if (!readaheadstream_posfits(stream, new_position))
+        return StreamError_NoSpace;
+    self->position = new_position;
+    return StreamError_Success;
+}
+
+StreamError readaheadstream_write(stream_dt *stream, const void *ptr, size_t size)
+{
+    return StreamError_Failure;
+}
+
+StreamError readaheadstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    return readahead_copy((readaheadstream_dt*)stream, offset, ptr, size);
+}
+
+StreamError readaheadstream_read(stream_dt *stream, void *ptr, size_t size)
+{
+    readaheadstream_dt *self = (readaheadstream_dt*)stream;
+    StreamError err = readahead_copy(self, self->position, ptr, size);
+    if (err == StreamError_Success)
+        self->position += size;
+    return err;
+}
+
+bool readaheadstream_posfits(stream_dt *stream, streampos_dt position)
+{
+    return position < ((readaheadstream_dt*)stream)->data_length;
+}
+
+bool readaheadstream_sizefits(stream_dt *stream, size_t size)
+{
+    readaheadstream_dt *self = (readaheadstream_dt*)stream;
+    return size <= self->data_length - self->position;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file readaheadstream.h
+ * @brief asynchronous read-ahead decorator for any stream
+ *
+ * A readaheadstream wraps another stream and watches the reads made
+ * through it. Once several reads in a row continue exactly where the
+ * previous one stopped, it starts filling `depth` buffers of `window`
+ * bytes each with the data that follows, on a background thread. A
+ * sequential reader then finds its data already in memory while the
+ * next window is being read, overlapping I/O with whatever the caller
+ * does with the data. Reads that jump around go straight to the
+ * wrapped stream.
+ *
+ * The decorator is read-only and does not take ownership of the
+ * wrapped stream, which must outlive it. One thread at a time may
+ * read through a readaheadstream. On systems without POSIX threads,
+ * the windows are filled synchronously, so the decorator degrades to
+ * a large-block read cache.
+ */
+#ifndef READAHEADSTREAM_H
+#define READAHEADSTREAM_H
+
+#include <stdlib.h>
+
+#include "stream.h"
+
+#define READAHEAD_DEFAULT_WINDOW (1024 * 1024) /**< bytes per buffer */
+#define READAHEAD_DEFAULT_DEPTH  2             /**< number of buffers */
+
+typedef struct readaheadstream readaheadstream_dt;
+
+StreamError readaheadstream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError readaheadstream_write(stream_dt *stream, const void *ptr, size_t size); /**< always fails */
+StreamError readaheadstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError readaheadstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError readaheadstream_length(stream_dt *stream, streampos_dt *length);
+StreamError readaheadstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+bool readaheadstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
+bool readaheadstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining data fits size bytes */
+
+/**
+ * Wrap `inner` in a read-ahead decorator.
+ *
+ * `window` and `depth` give the size and number of prefetch buffers;
+ * pass 0 for either to use READAHEAD_DEFAULT_WINDOW and
+ * READAHEAD_DEFAULT_DEPTH. The new stream starts at position 0.
+ */
+StreamError readaheadstream_create(stream_dt *inner, size_t window, size_t depth, stream_dt **stream);
+StreamError readaheadstream_destroy(stream_dt *stream);
+
+#endif
@@ -0,0 +1,261 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stream.h"
+#include "statstream.h"
+
+#include "memory.c"
+
+#if defined(_POSIX_THREADS) && (_POSIX_THREADS > 0)
+# define STATSTREAM_USE_THREADS
+# include <pthread.h>
+#endif
+
+#if defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) && defined(CLOCK_MONOTONIC)
+# define STATSTREAM_USE_CLOCK_GETTIME
+#endif
+
+struct statstream
+{
+    stream_dt base;
+    stream_dt *inner;
+    struct stream_stats stats;
+#ifdef STATSTREAM_USE_THREADS
+    pthread_mutex_t lock;
+#endif
+};
+
+struct stream_operations statstream_ops = {
+    .read = statstream_read,
+    .write = statstream_write,
+    .seek = statstream_seek,
+    .tell = statstream_tell,
+    .sizefits = statstream_sizefits,
+    .posfits = statstream_posfits,
+    .length = statstream_length,
+    .view = statstream_view,
+    .readat = statstream_readat,
+    .readv = statstream_readv
+};
+
+static uint64_t statstream_now(void)
+{
+#ifdef STATSTREAM_USE_CLOCK_GETTIME
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+    return (uint64_t)clock() * (1000000000u / CLOCKS_PER_SEC);
+#endif
+}
+
+static unsigned statstream_bucket(uint64_t ns)
+{
+    unsigned bucket = 0;
+    while (ns > 0 && bucket < STATSTREAM_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void statstream_lock(statstream_dt *self)
+{
+#ifdef STATSTREAM_USE_THREADS
+    pthread_mutex_lock(&self->lock);
+#endif
+}
+
+static void statstream_unlock(statstream_dt *self)
+{
+#ifdef STATSTREAM_USE_THREADS
+    pthread_mutex_unlock(&self->lock);
+#endif
+}
+
+/* Account for one operation of kind `op` that started at `start`.
+ * `bytes` is added to the read or write total on success. */
+static void statstream_record(statstream_dt *self, StatOp op, uint64_t start,
+                              StreamError err, uint64_t bytes)
+{
+    uint64_t elapsed = statstream_now() - start;
+    struct stream_stats *stats = &self->stats;
+
+    statstream_lock(self);
+    stats->ops[op]++;
+    stats->total_ns[op] += elapsed;
+    stats->latency[op][statstream_bucket(elapsed)]++;
+    if (err != StreamError_Success)
+        stats->errors[op]++;
+    else if (op == StatOp_Write)
+        stats->bytes_written += bytes;
+    else if (op != StatOp_Seek)
+        stats->bytes_read += bytes;
+    statstream_unlock(self);
+}
+
+StreamError statstream_create(stream_dt *inner, stream_dt **stream)
+{
+    *stream = NULL;
+    statstream_dt *self = NEW(statstream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "StatStream";
+    self->base.ops = &statstream_ops;
+    self->inner = inner;
+    memset(&self->stats, 0, sizeof(self->stats));
+#ifdef STATSTREAM_USE_THREADS
+    pthread_mutex_init(&self->lock, NULL);
+#endif
+
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError statstream_destroy(stream_dt *super)
+{
+    statstream_dt *self = (statstream_dt*)super;
+#ifdef STATSTREAM_USE_THREADS
+    pthread_mutex_destroy(&self->lock);
+#endif
+    FREE(self);
+    return StreamError_Success;
+}
+
+StreamError statstream_getStats(stream_dt *stream, struct stream_stats *stats)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    statstream_lock(self);
+    *stats = self->stats;
+    statstream_unlock(self);
+    return StreamError_Success;
+}
+
+StreamError statstream_reset(stream_dt *stream)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    statstream_lock(self);
+    memset(&self->stats, 0, sizeof(self->stats));
+    statstream_unlock(self);
+    return StreamError_Success;
+}
+
+uint64_t stream_stats_percentile(const struct stream_stats *stats, StatOp op, double p)
+{
+    uint64_t target, seen = 0;
+    unsigned i;
+
+    if (stats->ops[op] == 0)
+        return 0;
+    if (p < 0.0)
+        p = 0.0;
+    if (p > 1.0)
+        p = 1.0;
+    target = (uint64_t)(p * (double)stats->ops[op] + 0.5);
+    if (target == 0)
+        target = 1;
+
+    for (i = 0; i < STATSTREAM_BUCKETS - 1; i++) {
+        seen += stats->latency[op][i];
+        if (seen >= target)
+            break;
+    }
+    return (uint64_t)1 << i;
+}
+
+StreamError statstream_read(stream_dt *stream, void *ptr, size_t size)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    uint64_t start = statstream_now();
+    StreamError err = stream_read(self->inner, ptr, size);
+    statstream_record(self, StatOp_Read, start, err, size);
+    return err;
+}
+
+StreamError statstream_write(stream_dt *stream, const void *ptr, size_t size)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    uint64_t start = statstream_now();
+    StreamError err = stream_write(self->inner, ptr, size);
+    statstream_record(self, StatOp_Write, start, err, size);
+    return err;
+}
+
+StreamError statstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    streampos_dt before, after;
+    bool known;
+    uint64_t start;
+    StreamError err;
+
+    known = (StreamError_Success == stream_tell(self->inner, &before));
+    start = statstream_now();
+    err = stream_seek(self->inner, offset, origin);
+    statstream_record(self, StatOp_Seek, start, err, 0);
+
+    if (err == StreamError_Success && known
+        && StreamError_Success == stream_tell(self->inner, &after)) {
+        statstream_lock(self);
+        self->stats.seek_distance += (uint64_t)(after > before ? after - before : before - after);
+        statstream_unlock(self);
+    }
+    return err;
+}
+
+StreamError statstream_tell(stream_dt *stream, streampos_dt *pos)
+{
+    return stream_tell(((statstream_dt*)stream)->inner, pos);
+}
+
+StreamError statstream_length(stream_dt *stream, streampos_dt *length)
+{
+    return stream_length(((statstream_dt*)stream)->inner, length);
+}
+
+StreamError statstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    uint64_t start = statstream_now();
+    StreamError err = stream_view(self->inner, offset, size, ptr);
+    statstream_record(self, StatOp_View, start, err, size);
+    return err;
+}
+
+StreamError statstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    uint64_t start = statstream_now();
+    StreamError err = stream_readAt(self->inner, offset, ptr, size);
+    statstream_record(self, StatOp_ReadAt, start, err, size);
+    return err;
+}
+
+StreamError statstream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count)
+{
+    statstream_dt *self = (statstream_dt*)stream;
+    uint64_t start, bytes = 0;
+    StreamError err;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+        bytes += vec[i].size;
+    start = statstream_now();
+    err = stream_readv(self->inner, vec, count);
+    statstream_record(self, StatOp_ReadV, start, err, bytes);
+    return err;
+}
+
+bool statstream_posfits(stream_dt *stream, streampos_dt position)
+{
+    return stream_posfits(((statstream_dt*)stream)->inner, position);
+}
+
+bool statstream_sizefits(stream_dt *stream, size_t size)
+{
+    return stream_sizefits(((statstream_dt*)stream)->inner, size);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file statstream.h
+ * @brief instrumenting pass-through decorator for any stream
+ *
+ * A statstream forwards every operation to the stream it wraps and
+ * records what went through it: bytes and operations per kind, seeks
+ * and the distance they covered, and a latency histogram per kind of
+ * operation. The figures are read back with statstream_getStats(),
+ * which shows whether time goes to the I/O itself, to seeking, or to
+ * what the caller does between operations.
+ *
+ * The decorator does not take ownership of the wrapped stream, which
+ * must outlive it. Counters are updated under a lock, so positional
+ * and vectored reads may be made from several threads at once when
+ * the wrapped stream allows it.
+ */
+#ifndef STATSTREAM_H
+#define STATSTREAM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "stream.h"
+
+/**
+ * Number of latency buckets. Bucket i counts operations that took
+ * less than 2^i nanoseconds (and at least 2^(i-1)); the last bucket
+ * also takes everything slower.
+ */
+#define STATSTREAM_BUCKETS 40
+
+typedef enum StatOp {
+    StatOp_Read,
+    StatOp_Write,
+    StatOp_Seek,
+    StatOp_ReadAt,
+    StatOp_ReadV,
+    StatOp_View,
+    StatOp_Count    /**< number of kinds, not an operation */
+} StatOp;
+
+struct stream_stats {
+    uint64_t bytes_read;        /**< by read, readat, readv and view */
+    uint64_t bytes_written;
+    uint64_t seek_distance;     /**< sum of |new position - old position| */
+    uint64_t ops[StatOp_Count];
+    uint64_t errors[StatOp_Count];
+    uint64_t total_ns[StatOp_Count];
+    uint64_t latency[StatOp_Count][STATSTREAM_BUCKETS];
+};
+
+typedef struct statstream statstream_dt;
+
+StreamError statstream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError statstream_write(stream_dt *stream, const void *ptr, size_t size);
+StreamError statstream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError statstream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError statstream_length(stream_dt *stream, streampos_dt *length);
+StreamError statstream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr);
+StreamError statstream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+StreamError statstream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count);
+bool statstream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
+bool statstream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining data fits size bytes */
+
+/** Wrap `inner` in an instrumenting decorator with all counters at zero. */
+StreamError statstream_create(stream_dt *inner, stream_dt **stream);
+StreamError statstream_destroy(stream_dt *stream);
+
+/** Copy a consistent snapshot of the counters into `stats`. */
+StreamError statstream_getStats(stream_dt *stream, struct stream_stats *stats);
+/** Set all counters back to zero. */
+StreamError statstream_reset(stream_dt *stream);
+
+/**
+ * Latency below which a fraction `p` (0 to 1) of the operations of kind
+ * `op` completed, in nanoseconds, rounded up to a bucket boundary.
+ * Returns 0 if no such operation was recorded.
+ */
+uint64_t stream_stats_percentile(const struct stream_stats *stats, StatOp op, double p);
+
+#endif
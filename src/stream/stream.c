@@ -1,3 +1,6 @@
+#include <stdint.h>
+#include <string.h>
+
 #include "stream.h"
 
 StreamError stream_read(stream_dt *stream, void *ptr, size_t size)
@@ -20,6 +23,55 @@ StreamError stream_tell(stream_dt *stream, streampos_dt *curr_pos)
     return stream->ops->tell(stream, curr_pos);
 }
 
+StreamError stream_length(stream_dt *stream, streampos_dt *length)
+{
+    if (stream->ops->length == NULL)
+        return StreamError_Failure;
+    return stream->ops->length(stream, length);
+}
+
+StreamError stream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr)
+{
+    *ptr = NULL;
+    if (stream->ops->view == NULL)
+        return StreamError_Failure;
+    return stream->ops->view(stream, offset, size, ptr);
+}
+
+StreamError stream_readAt(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    StreamError err;
+    if (stream->ops->readat != NULL)
+        return stream->ops->readat(stream, offset, ptr, size);
+
+    err = stream_seekFromStart(stream, offset);
+    if (StreamError_Success != err)
+        return err;
+    return stream_read(stream, ptr, size);
+}
+
+StreamError stream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count)
+{
+    StreamError err;
+    size_t i;
+    streampos_dt length;
+    if (stream->ops->readv != NULL)
+        return stream->ops->readv(stream, vec, count);
+
+    if (StreamError_Success == stream_length(stream, &length)) {
+        for (i = 0; i < count; i++) {
+            if (vec[i].offset > length || vec[i].size > length - vec[i].offset)
+                return StreamError_NoSpace;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        err = stream_readAt(stream, vec[i].offset, vec[i].ptr, vec[i].size);
+        if (StreamError_Success != err)
+            return err;
+    }
+    return StreamError_Success;
+}
+
 bool stream_sizefits(stream_dt *stream, size_t size)
 {
     return stream->ops->sizefits(stream, size);
@@ -40,6 +92,23 @@ StreamError stream_seekToEnd(stream_dt *stream)
     return stream_seekFromEnd(stream, 0);
 }
 
+StreamError stream_seekFromEnd(stream_dt *stream, streampos_dt offset)
+{
+    StreamError err;
+    streampos_dt length;
+    err = stream_length(stream, &length);
+    if (StreamError_Success != err)
+        return err;
+    if (length == 0) {
+        /* no last byte to seek back from; only a stream that can be
+         * appended to may be positioned at 0 */
+        if (offset != 0 || !stream_posfits(stream, 0))
+            return StreamError_NoSpace;
+        return stream_seek(stream, 0, 0);
+    }
+    return stream_seek(stream, -offset, length - 1);
+}
+
 StreamError stream_seekFromStart(stream_dt *stream, streampos_dt offset)
 {
     return stream_seek(stream, offset, 0);
@@ -113,6 +182,20 @@ StreamError stream_write_int64(stream_dt *stream, const int64_t from, bool swap)
     return stream_write(stream, &from_endian, sizeof(from));
 }
 
+StreamError stream_write_float(stream_dt *stream, const float from, bool swap)
+{
+    uint32_t from_endian;
+    memcpy(&from_endian, &from, sizeof(from));
+    return stream_write_uint32(stream, from_endian, swap);
+}
+
+StreamError stream_write_double(stream_dt *stream, const double from, bool swap)
+{
+    uint64_t from_endian;
+    memcpy(&from_endian, &from, sizeof(from));
+    return stream_write_uint64(stream, from_endian, swap);
+}
+
 
 StreamError stream_read_uint8(stream_dt *stream, uint8_t *to)
 {
@@ -177,3 +260,55 @@ StreamError stream_read_int64(stream_dt *stream, int64_t *to, bool swap)
         *to = _swap64(*to);
     return err;
 }
+
+StreamError stream_read_float(stream_dt *stream, float *to, bool swap)
+{
+    StreamError err;
+    uint32_t from;
+    err = stream_read_uint32(stream, &from, swap);
+    memcpy(to, &from, sizeof(*to));
+    return err;
+}
+
+StreamError stream_read_double(stream_dt *stream, double *to, bool swap)
+{
+    StreamError err;
+    uint64_t from;
+    err = stream_read_uint64(stream, &from, swap);
+    memcpy(to, &from, sizeof(*to));
+    return err;
+}
+
+
+/* Read `n` elements of `size` bytes and swap them in place */
+static StreamError stream_read_swapped(stream_dt *stream, void *to, size_t size, size_t n,
+                                       bool swap, void (*swapper)(void *, size_t))
+{
+    StreamError err;
+    if (n > SIZE_MAX / size)
+        return StreamError_NoSpace;
+    err = stream_readn(stream, to, size, n);
+    if (StreamError_Success == err && swap)
+        swapper(to, n);
+    return err;
+}
+
+StreamError stream_read_int16n(stream_dt *stream, int16_t *to, size_t n, bool swap)
+{
+    return stream_read_swapped(stream, to, sizeof(*to), n, swap, swap16_array);
+}
+
+StreamError stream_read_int32n(stream_dt *stream, int32_t *to, size_t n, bool swap)
+{
+    return stream_read_swapped(stream, to, sizeof(*to), n, swap, swap32_array);
+}
+
+StreamError stream_read_floatn(stream_dt *stream, float *to, size_t n, bool swap)
+{
+    return stream_read_swapped(stream, to, sizeof(*to), n, swap, swap32_array);
+}
+
+StreamError stream_read_doublen(stream_dt *stream, double *to, size_t n, bool swap)
+{
+    return stream_read_swapped(stream, to, sizeof(*to), n, swap, swap64_array);
+}
@@ -61,6 +61,28 @@ typedef enum StreamError {
 } StreamError;
 
 
+/**
+ * One request of a vectored read
+ *
+ * Describes `size` bytes at stream offset `offset` that are to be
+ * copied to the memory area `ptr`.
+ *
+ * @see stream_readv()
+ */
+struct stream_iovec {
+    streampos_dt offset;
+    size_t size;
+    void *ptr;
+};
+
+
+/**
+ * Stream implementation table
+ *
+ * Each stream backend fills in one of these. Members marked optional
+ * may be left NULL, in which case the corresponding stream_* call
+ * returns StreamError_Failure.
+ */
 struct stream_operations {
     StreamError (*read)(stream_dt *stream, void *ptr, size_t size);
     StreamError (*write)(stream_dt *stream, const void *ptr, size_t size);
@@ -68,6 +90,13 @@ struct stream_operations {
     StreamError (*tell)(stream_dt *stream, streampos_dt *pos);
     bool (*posfits)(stream_dt *stream, streampos_dt pos); /**< checks if position fits in stream */
     bool (*sizefits)(stream_dt *stream, size_t size);     /**< checks if remaining space fits size bytes */
+    StreamError (*length)(stream_dt *stream, streampos_dt *length); /**< total length of the stream */
+    StreamError (*view)(stream_dt *stream, streampos_dt offset, size_t size,
+                        const void **ptr);                /**< optional: zero-copy access */
+    StreamError (*readat)(stream_dt *stream, streampos_dt offset,
+                          void *ptr, size_t size);        /**< optional: positional read */
+    StreamError (*readv)(stream_dt *stream, const struct stream_iovec *vec,
+                         size_t count);                   /**< optional: vectored read */
 };
 
 struct stream {
@@ -135,6 +164,54 @@ StreamError stream_seekToEnd(stream_dt *stream);
 
 StreamError stream_tell(stream_dt *stream, streampos_dt *curr_pos);
 
+/** Store the total length of `stream` in bytes in `length` */
+StreamError stream_length(stream_dt *stream, streampos_dt *length);
+
+/**
+ * Get a read-only pointer to `size` bytes of `stream` starting at
+ * `offset`, without copying.
+ *
+ * On success `*ptr` points directly into the backing memory of the
+ * stream and stays valid until the stream is destroyed. The stream
+ * position is not changed. StreamError_NoSpace is returned if the
+ * range does not lie within the stream, and StreamError_Failure if
+ * the backend cannot provide direct access; callers should then fall
+ * back to stream_read().
+ *
+ * @see stream_read()
+ */
+StreamError stream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr);
+
+/**
+ * Read `size` bytes starting at `offset` from a stream into the
+ * memory area `ptr`, without using or changing the stream position.
+ *
+ * Because no cursor is shared, backends that implement this natively
+ * allow several threads to read different parts of one stream at the
+ * same time. Streams without a positional read fall back to seek and
+ * read, which moves the stream position and is not thread-safe.
+ * StreamError_NoSpace is returned if the range does not lie within
+ * the stream.
+ *
+ * @see stream_read()
+ */
+StreamError stream_readAt(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+
+/**
+ * Perform `count` positional reads described by `vec` in one call.
+ *
+ * The requests may be given in any order and need not be
+ * contiguous. Backends that support it sort the requests by offset
+ * and merge neighbouring ranges, so that reading a file header and
+ * all of its sections costs as few system calls as possible. The
+ * stream position is not used or changed. If any request does not
+ * lie within the stream, StreamError_NoSpace is returned and nothing
+ * is read.
+ *
+ * @see stream_readAt()
+ */
+StreamError stream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count);
+
 bool stream_isOpenForRead(stream_dt *stream);
 bool stream_isOpenForWrite(stream_dt *stream);
 
@@ -165,4 +242,21 @@ StreamError stream_read_int64(stream_dt *stream, int64_t *to, bool swap);
 StreamError stream_read_float(stream_dt *stream, float *to, bool swap);
 StreamError stream_read_double(stream_dt *stream, double *to, bool swap);
 
+/**
+ * Read `n` consecutive values of the given type from a stream into
+ * the array `to`.
+ *
+ * The values are read with one call to the stream backend. If `swap`
+ * is true, every value is then byte-swapped in place with the
+ * vectorized swap16_array()/swap32_array()/swap64_array()
+ * kernels. StreamError_NoSpace is returned if the stream does not
+ * have enough data; `to` is then left undefined.
+ *
+ * @see stream_read_int16(), stream_readn()
+ */
+StreamError stream_read_int16n(stream_dt *stream, int16_t *to, size_t n, bool swap);
+StreamError stream_read_int32n(stream_dt *stream, int32_t *to, size_t n, bool swap);
+StreamError stream_read_floatn(stream_dt *stream, float *to, size_t n, bool swap);
+StreamError stream_read_doublen(stream_dt *stream, double *to, size_t n, bool swap);
+
 #endif
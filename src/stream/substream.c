@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "stream.h"
+#include "substream.h"
+
+#include "memory.c"
+
+/* Number of requests translated per call to the parent's readv */
+#define SUBSTREAM_IOV_BATCH 16
+
+struct substream
+{
+    stream_dt base;
+    stream_dt *parent;
+    streampos_dt offset;
+    streampos_dt data_length;
+    streampos_dt position;
+};
+
+struct stream_operations substream_ops = {
+    .read = substream_read,
+    .write = substream_write,
+    .seek = substream_seek,
+    .tell = substream_tell,
+    .sizefits = substream_sizefits,
+    .posfits = substream_posfits,
+    .length = substream_length,
+    .view = substream_view,
+    .readat = substream_readat,
+    .readv = substream_readv
+};
+
+static bool substream_inWindow(substream_dt *self, streampos_dt offset, size_t size)
+{
+    return offset <= self->data_length && size <= self->data_length - offset;
+}
+
+StreamError substream_create(stream_dt *parent, streampos_dt offset, streampos_dt length,
+                             stream_dt **stream)
+{
+    StreamError err;
+    streampos_dt parent_length;
+    substream_dt *self;
+    *stream = NULL;
+
+    err = stream_length(parent, &parent_length);
+    if (err != StreamError_Success)
+        return err;
+    if (offset > parent_length || length > parent_length - offset)
+        return StreamError_NoSpace;
+
+    self = NEW(substream_dt);
+    if (self == NULL) {
+        return StreamError_NoMemory;
+    }
+
+    self->base.type = "SubStream";
+    self->base.ops = &substream_ops;
+    self->parent = parent;
+    self->offset = offset;
+    self->data_length = length;
+    self->position = 0;
+
+    *stream = (stream_dt*)self;
+    return StreamError_Success;
+}
+
+StreamError substream_destroy(stream_dt *super)
+{
+    substream_dt *self = (substream_dt*)super;
+    FREE(self);
+    return StreamError_Success;
+}
+
+StreamError substream_tell(stream_dt *stream, streampos_dt *curr_pos)
+{
+    *curr_pos = ((substream_dt*)stream)->position;
+    return StreamError_Success;
+}
+
+StreamError substream_length(stream_dt *stream, streampos_dt *length)
+{
+    *length = ((substream_dt*)stream)->data_length;
+    return StreamError_Success;
+}
+
+StreamError substream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin)
+{
+    substream_dt *self = (substream_dt*)stream;
+    streampos_dt new_position = offset + origin;
+    if (!substream_posfits(stream, new_position))
+        return StreamError_NoSpace;
+    self->position = new_position;
+    return StreamError_Success;
+}
+
+StreamError substream_write(stream_dt *stream, const void *ptr, size_t size)
+{
+    return StreamError_Failure;
+}
+
+StreamError substream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr)
+{
+    substream_dt *self = (substream_dt*)stream;
+    *ptr = NULL;
+    if (!substream_inWindow(self, offset, size))
+        return StreamError_NoSpace;
+    return stream_view(self->parent, self->offset + offset, size, ptr);
+}
+
+StreamError substream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size)
+{
+    substream_dt *self = (substream_dt*)stream;
+    if (!substream_inWindow(self, offset, size))
+        return StreamError_NoSpace;
+    return stream_readAt(self->parent, self->offset + offset, ptr, size);
+}
+
+StreamError substream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count)
+{
+    substream_dt *self = (substream_dt*)stream;
+    struct stream_iovec batch[SUBSTREAM_IOV_BATCH];
+    StreamError err;
+    size_t i, n;
+
+    for (i = 0; i < count; i++) {
+        if (!substream_inWindow(self, vec[i].offset, vec[i].size))
+            return StreamError_NoSpace;
+    }
+
+    while (count > 0) {
+        n = (count < SUBSTREAM_IOV_BATCH) ? count : SUBSTREAM_IOV_BATCH;
+        for (i = 0; i < n; i++) {
+            batch[i] = vec[i];
+            batch[i].offset += self->offset;
+        }
+        err = stream_readv(self->parent, batch, n);
+        if (err != StreamError_Success)
+            return err;
+        vec += n;
+        count -= n;
+    }
+    return StreamError_Success;
+}
+
+StreamError substream_read(stream_dt *stream, void *ptr, size_t size)
+{
+    substream_dt *self = (substream_dt*)stream;
+    StreamError err = substream_readat(stream, self->position, ptr, size);
+    if (err == StreamError_Success)
+        self->position += size;
+    return err;
+}
+
+bool substream_posfits(stream_dt *stream, streampos_dt position)
+{
+    return position < ((substream_dt*)stream)->data_length;
+}
+
+bool substream_sizefits(stream_dt *stream, size_t size)
+{
+    substream_dt *self = (substream_dt*)stream;
+    return size <= self->data_length - self->position;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file substream.h
+ * @brief zero-based window over part of another stream
+ *
+ * A substream exposes `length` bytes of a parent stream, starting at
+ * `offset`, as a stream of its own: position 0 of the substream is
+ * `offset` in the parent, and posfits/sizefits refuse to go past the
+ * end of the window. Nothing is copied; reads are forwarded to the
+ * parent as positional reads, and views hand out pointers into the
+ * parent's buffer or mapping.
+ *
+ * This is the natural way to decode one section of an ABF2 file, such
+ * as the DataSection or TagSection of the file info, whose window is
+ *
+ *     offset = uBlockIndex * ABF2_BLOCKSIZE
+ *     length = uBytes * llNumEntries
+ *
+ * Each substream keeps its own position, so several sections can be
+ * decoded side by side. When the parent supports readat (memory,
+ * mapped and file descriptor streams do), the parent's cursor is never
+ * touched and substreams of one parent may be read from different
+ * threads. Otherwise reads seek the parent, and substreams sharing
+ * that parent must not be used concurrently.
+ *
+ * Substreams are read-only and do not take ownership of the parent,
+ * which must outlive them.
+ */
+#ifndef SUBSTREAM_H
+#define SUBSTREAM_H
+
+#include <stdlib.h>
+
+#include "stream.h"
+
+typedef struct substream substream_dt;
+
+StreamError substream_read(stream_dt *stream, void *ptr, size_t size);
+StreamError substream_write(stream_dt *stream, const void *ptr, size_t size); /**< always fails */
+StreamError substream_seek(stream_dt *stream, streampos_dt offset, streampos_dt origin);
+StreamError substream_tell(stream_dt *stream, streampos_dt *pos);
+StreamError substream_length(stream_dt *stream, streampos_dt *length);
+StreamError substream_view(stream_dt *stream, streampos_dt offset, size_t size, const void **ptr);
+StreamError substream_readat(stream_dt *stream, streampos_dt offset, void *ptr, size_t size);
+StreamError substream_readv(stream_dt *stream, const struct stream_iovec *vec, size_t count);
+bool substream_posfits(stream_dt *stream, streampos_dt pos); /**< checks if position fits in window */
+bool substream_sizefits(stream_dt *stream, size_t size);     /**< checks if remaining window fits size bytes */
+
+/**
+ * Create a window of `length` bytes starting at `offset` in `parent`.
+ *
+ * Fails with StreamError_NoSpace if the window extends past the end of
+ * the parent. Windows may be nested.
+ */
+StreamError substream_create(stream_dt *parent, streampos_dt offset, streampos_dt length,
+                             stream_dt **stream);
+StreamError substream_destroy(stream_dt *stream);
+
+#endif
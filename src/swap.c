@@ -1,4 +1,7 @@
+#include <string.h>
+
 #include "swap.h"
+#include "kernel_dispatch.h"
 
 /* get_endian -- test the byte order at runtime and return the
  * appropriate value from the enum `byte_order`
@@ -19,3 +22,248 @@ int get_endian(void)
         return ENDIAN_BIG;
     return ENDIAN_UNKNOWN;
 }
+
+/* Array byteswapping
+ *
+ * Each kernel swaps as many whole vectors as fit in the array and
+ * leaves the remainder to the scalar loop. The vector kernels are
+ * compiled with per-function target attributes, so the rest of the
+ * library does not depend on the instruction set; the best supported
+ * kernel set is picked the first time one of the swap*_array
+ * functions is called.
+ */
+
+static size_t swap16_scalar(uint8_t *p, size_t count)
+{
+    size_t i;
+    uint16_t v;
+    for (i = 0; i < count; i++, p += sizeof(v)) {
+        memcpy(&v, p, sizeof(v));
+        v = _swap16(v);
+        memcpy(p, &v, sizeof(v));
+    }
+    return count;
+}
+
+static size_t swap32_scalar(uint8_t *p, size_t count)
+{
+    size_t i;
+    uint32_t v;
+    for (i = 0; i < count; i++, p += sizeof(v)) {
+        memcpy(&v, p, sizeof(v));
+        v = _swap32(v);
+        memcpy(p, &v, sizeof(v));
+    }
+    return count;
+}
+
+static size_t swap64_scalar(uint8_t *p, size_t count)
+{
+    size_t i;
+    uint64_t v;
+    for (i = 0; i < count; i++, p += sizeof(v)) {
+        memcpy(&v, p, sizeof(v));
+        v = _swap64(v);
+        memcpy(p, &v, sizeof(v));
+    }
+    return count;
+}
+
+/* A kernel swaps a leading part of the array and returns the number
+ * of elements it handled */
+typedef size_t (*swap_kernel_fn)(uint8_t *p, size_t count);
+
+struct swap_kernels {
+    const char *name;
+    swap_kernel_fn swap16;
+    swap_kernel_fn swap32;
+    swap_kernel_fn swap64;
+};
+
+static const struct swap_kernels swap_kernels_scalar = {
+    "scalar", swap16_scalar, swap32_scalar, swap64_scalar
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SWAP_HAVE_X86_KERNELS
+#include <immintrin.h>
+
+#define SWAP_MASK16 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+#define SWAP_MASK32 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+#define SWAP_MASK64 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+
+/* Swap whole 16-byte blocks with pshufb */
+__attribute__((target("ssse3")))
+static size_t swap_blocks_ssse3(uint8_t *p, size_t nbytes, __m128i mask)
+{
+    size_t done = 0;
+    for (; done + 16 <= nbytes; done += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + done));
+        _mm_storeu_si128((__m128i*)(p + done), _mm_shuffle_epi8(v, mask));
+    }
+    return done;
+}
+
+__attribute__((target("ssse3")))
+static size_t swap16_ssse3(uint8_t *p, size_t count)
+{
+    const __m128i mask = _mm_setr_epi8(SWAP_MASK16);
+    return swap_blocks_ssse3(p, count * 2, mask) / 2;
+}
+
+__attribute__((target("ssse3")))
+static size_t swap32_ssse3(uint8_t *p, size_t count)
+{
+    const __m128i mask = _mm_setr_epi8(SWAP_MASK32);
+    return swap_blocks_ssse3(p, count * 4, mask) / 4;
+}
+
+__attribute__((target("ssse3")))
+static size_t swap64_ssse3(uint8_t *p, size_t count)
+{
+    const __m128i mask = _mm_setr_epi8(SWAP_MASK64);
+    return swap_blocks_ssse3(p, count * 8, mask) / 8;
+}
+
+/* Swap whole 32-byte blocks with vpshufb, which shuffles within each
+ * 128-bit lane, so the 16-byte masks are simply repeated */
+__attribute__((target("avx2")))
+static size_t swap_blocks_avx2(uint8_t *p, size_t nbytes, __m256i mask)
+{
+    size_t done = 0;
+    for (; done + 64 <= nbytes; done += 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(p + done));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(p + done + 32));
+        _mm256_storeu_si256((__m256i*)(p + done), _mm256_shuffle_epi8(v0, mask));
+        _mm256_storeu_si256((__m256i*)(p + done + 32), _mm256_shuffle_epi8(v1, mask));
+    }
+    for (; done + 32 <= nbytes; done += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + done));
+        _mm256_storeu_si256((__m256i*)(p + done), _mm256_shuffle_epi8(v, mask));
+    }
+    return done;
+}
+
+__attribute__((target("avx2")))
+static size_t swap16_avx2(uint8_t *p, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(SWAP_MASK16, SWAP_MASK16);
+    size_t done = swap_blocks_avx2(p, count * 2, mask) / 2;
+    return done + swap16_ssse3(p + done * 2, count - done);
+}
+
+__attribute__((target("avx2")))
+static size_t swap32_avx2(uint8_t *p, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(SWAP_MASK32, SWAP_MASK32);
+    size_t done = swap_blocks_avx2(p, count * 4, mask) / 4;
+    return done + swap32_ssse3(p + done * 4, count - done);
+}
+
+__attribute__((target("avx2")))
+static size_t swap64_avx2(uint8_t *p, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(SWAP_MASK64, SWAP_MASK64);
+    size_t done = swap_blocks_avx2(p, count * 8, mask) / 8;
+    return done + swap64_ssse3(p + done * 8, count - done);
+}
+
+/* Swap whole 64-byte blocks with the 512-bit vpshufb; like its AVX2
+ * counterpart it shuffles within 128-bit lanes */
+__attribute__((target("avx512f,avx512bw")))
+static size_t swap_blocks_avx512(uint8_t *p, size_t nbytes, __m128i lane_mask)
+{
+    const __m512i mask = _mm512_broadcast_i32x4(lane_mask);
+    size_t done = 0;
+    for (; done + 128 <= nbytes; done += 128) {
+        __m512i v0 = _mm512_loadu_si512((const void*)(p + done));
+        __m512i v1 = _mm512_loadu_si512((const void*)(p + done + 64));
+        _mm512_storeu_si512((void*)(p + done), _mm512_shuffle_epi8(v0, mask));
+        _mm512_storeu_si512((void*)(p + done + 64), _mm512_shuffle_epi8(v1, mask));
+    }
+    for (; done + 64 <= nbytes; done += 64) {
+        __m512i v = _mm512_loadu_si512((const void*)(p + done));
+        _mm512_storeu_si512((void*)(p + done), _mm512_shuffle_epi8(v, mask));
+    }
+    return done;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t swap16_avx512(uint8_t *p, size_t count)
+{
+    size_t done = swap_blocks_avx512(p, count * 2, _mm_setr_epi8(SWAP_MASK16)) / 2;
+    return done + swap16_avx2(p + done * 2, count - done);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t swap32_avx512(uint8_t *p, size_t count)
+{
+    size_t done = swap_blocks_avx512(p, count * 4, _mm_setr_epi8(SWAP_MASK32)) / 4;
+    return done + swap32_avx2(p + done * 4, count - done);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t swap64_avx512(uint8_t *p, size_t count)
+{
+    size_t done = swap_blocks_avx512(p, count * 8, _mm_setr_epi8(SWAP_MASK64)) / 8;
+    return done + swap64_avx2(p + done * 8, count - done);
+}
+
+static const struct swap_kernels swap_kernels_ssse3 = {
+    "ssse3", swap16_ssse3, swap32_ssse3, swap64_ssse3
+};
+
+static const struct swap_kernels swap_kernels_avx2 = {
+    "avx2", swap16_avx2, swap32_avx2, swap64_avx2
+};
+
+static const struct swap_kernels swap_kernels_avx512 = {
+    "avx512", swap16_avx512, swap32_avx512, swap64_avx512
+};
+#endif /* x86 */
+
+static const void *swap_kernels_select(void)
+{
+#ifdef SWAP_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw"))
+        return &swap_kernels_avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return &swap_kernels_avx2;
+    if (__builtin_cpu_supports("ssse3"))
+        return &swap_kernels_ssse3;
+#endif
+    return &swap_kernels_scalar;
+}
+
+static const struct swap_kernels *swap_kernels(void)
+{
+    static const void *volatile selected = NULL;
+    return kernel_dispatch(&selected, swap_kernels_select);
+}
+
+const char *swap_array_kernel(void)
+{
+    return swap_kernels()->name;
+}
+
+void swap16_array(void *data, size_t count)
+{
+    uint8_t *p = data;
+    size_t done = swap_kernels()->swap16(p, count);
+    swap16_scalar(p + done * 2, count - done);
+}
+
+void swap32_array(void *data, size_t count)
+{
+    uint8_t *p = data;
+    size_t done = swap_kernels()->swap32(p, count);
+    swap32_scalar(p + done * 4, count - done);
+}
+
+void swap64_array(void *data, size_t count)
+{
+    uint8_t *p = data;
+    size_t done = swap_kernels()->swap64(p, count);
+    swap64_scalar(p + done * 8, count - done);
+}
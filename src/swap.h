@@ -1,8 +1,13 @@
 #ifndef LIBABF_SWAP_H_
 #define LIBABF_SWAP_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum byte_order {
     ENDIAN_UNKNOWN = -1,
     ENDIAN_LITTLE,
@@ -34,4 +39,19 @@ int get_endian(void);
     (((uint64_t)(x) & (uint64_t)0x00ff000000000000ULL) >> 40) | \
     (((uint64_t)(x) & (uint64_t)0xff00000000000000ULL) >> 56)))
 
+/* Byteswap each of `count` 16-, 32- or 64-bit values in `data` in
+ * place. `data` need not be aligned. Vector kernels are selected at
+ * runtime from the features of the host CPU; results are identical
+ * to applying _swap16/_swap32/_swap64 to each element. */
+void swap16_array(void *data, size_t count);
+void swap32_array(void *data, size_t count);
+void swap64_array(void *data, size_t count);
+
+/* Name of the kernel set used by the swap*_array functions */
+const char *swap_array_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* LIBABF_SWAP_H_ */
@@ -94,7 +94,7 @@ void test_ABF_EpochInfoPerDAC_is_48bytes(void)
 void test_ABF_EpochInfo_is_32bytes(void)
 {
     TEST_IGNORE();
-    BYTE_SIZE_EQUAL(32, ABF_EpochInfo);
+    BYTE_SIZE_EQUAL(32, struct abf2_epochinfo);
 }
 
 void test_ABF_StatsRegionInfo_is_128bytes(void)
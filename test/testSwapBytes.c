@@ -78,3 +78,62 @@ void test_swap64_should_swap_8bytes(void)
     TEST_ASSERT_EQUAL_UINT(unswapped.as_char[6], swapped.as_char[1]);    
     TEST_ASSERT_EQUAL_UINT(unswapped.as_char[7], swapped.as_char[0]);    
 }
+
+void test_swap16_array_matches_scalar_swap(void)
+{
+    uint16_t data[67], expected[67];
+    size_t n, i;
+    for (n = 0; n <= 67; n++) {
+        for (i = 0; i < n; i++)
+            data[i] = (uint16_t)(0x0102 + 0x0303 * i);
+        for (i = 0; i < n; i++)
+            expected[i] = _swap16(data[i]);
+        swap16_array(data, n);
+        for (i = 0; i < n; i++)
+            TEST_ASSERT_EQUAL_HEX16(expected[i], data[i]);
+    }
+}
+
+void test_swap32_array_matches_scalar_swap(void)
+{
+    uint32_t data[37], expected[37];
+    size_t n, i;
+    for (n = 0; n <= 37; n++) {
+        for (i = 0; i < n; i++)
+            data[i] = (uint32_t)(0x01020304UL + 0x05050505UL * i);
+        for (i = 0; i < n; i++)
+            expected[i] = _swap32(data[i]);
+        swap32_array(data, n);
+        for (i = 0; i < n; i++)
+            TEST_ASSERT_EQUAL_HEX32(expected[i], data[i]);
+    }
+}
+
+void test_swap64_array_matches_scalar_swap(void)
+{
+    uint64_t data[19], expected[19];
+    size_t n, i;
+    for (n = 0; n <= 19; n++) {
+        for (i = 0; i < n; i++)
+            data[i] = 0x0102030405060708ULL + 0x0909090909090909ULL * i;
+        for (i = 0; i < n; i++)
+            expected[i] = _swap64(data[i]);
+        swap64_array(data, n);
+        for (i = 0; i < n; i++)
+            TEST_ASSERT_EQUAL_HEX64(expected[i], data[i]);
+    }
+}
+
+void test_swap16_array_handles_unaligned_data(void)
+{
+    uint8_t bytes[2 * 33 + 1];
+    size_t i;
+    for (i = 0; i < sizeof(bytes); i++)
+        bytes[i] = (uint8_t)i;
+    swap16_array(bytes + 1, 33);
+    TEST_ASSERT_EQUAL_HEX8(0, bytes[0]);
+    for (i = 0; i < 33; i++) {
+        TEST_ASSERT_EQUAL_HEX8(2 * i + 2, bytes[2 * i + 1]);
+        TEST_ASSERT_EQUAL_HEX8(2 * i + 1, bytes[2 * i + 2]);
+    }
+}
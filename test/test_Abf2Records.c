@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "abf2_records.h"
+#include "swap.h"
+
+#define PACKEDSIZES "abf2struct_packedsizes.txt"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const struct abf2_record *find_record(const char *name)
+{
+    const struct abf2_record *const *r;
+    for (r = abf2_records; *r != NULL; r++) {
+        if (strcmp((*r)->name, name) == 0)
+            return *r;
+    }
+    return NULL;
+}
+
+static const struct abf2_field *find_field(const struct abf2_record *record, const char *name)
+{
+    size_t i;
+    for (i = 0; i < record->num_fields; i++) {
+        if (strcmp(record->fields[i].name, name) == 0)
+            return &record->fields[i];
+    }
+    return NULL;
+}
+
+void test_records_are_packed_and_complete(void)
+{
+    const struct abf2_record *const *r;
+    size_t i, expected;
+    for (r = abf2_records; *r != NULL; r++) {
+        expected = 0;
+        for (i = 0; i < (*r)->num_fields; i++) {
+            const struct abf2_field *f = &(*r)->fields[i];
+            TEST_ASSERT_EQUAL_INT_MESSAGE(expected, f->file_offset, f->name);
+            TEST_ASSERT_TRUE(f->struct_offset < (*r)->struct_size);
+            expected += abf2_field_size(f->type) * f->count;
+        }
+        TEST_ASSERT_EQUAL_INT_MESSAGE((*r)->file_size, expected, (*r)->name);
+    }
+}
+
+void test_records_match_packedsizes_file(void)
+{
+    FILE *fp = fopen(PACKEDSIZES, "r");
+    char line[256], record_name[64], field_name[64];
+    const struct abf2_record *record = NULL;
+    const struct abf2_field *f;
+    unsigned offset, size;
+    int fields_seen = 0;
+    char *p;
+
+    if (fp == NULL)
+        TEST_IGNORE_MESSAGE("cannot open " PACKEDSIZES);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "struct %63s {", record_name) == 1) {
+            record = find_record(record_name);
+            continue;
+        }
+        if (record == NULL || (p = strchr(line, '.')) == NULL)
+            continue;
+        TEST_ASSERT_EQUAL_INT(3, sscanf(p + 1, "%63s %u %u", field_name, &offset, &size));
+        if ((p = strchr(field_name, '[')) != NULL)
+            *p = '\0';
+        f = find_field(record, field_name);
+        TEST_ASSERT_NOT_NULL_MESSAGE(f, field_name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(offset, f->file_offset, field_name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(size, abf2_field_size(f->type) * f->count, field_name);
+        fields_seen++;
+    }
+    fclose(fp);
+    TEST_ASSERT_TRUE(fields_seen > 200);
+}
+
+void test_decode_section(void)
+{
+    char buf[16];
+    struct abf2_section section;
+    uint32_t block = 3, bytes = 128;
+    int64_t entries = 5;
+    memcpy(buf, &block, 4);
+    memcpy(buf + 4, &bytes, 4);
+    memcpy(buf + 8, &entries, 8);
+
+    abf2_decode(&abf2_section_record, buf, &section, false);
+    TEST_ASSERT_EQUAL_UINT32(3, section.uBlockIndex);
+    TEST_ASSERT_EQUAL_UINT32(128, section.uBytes);
+    TEST_ASSERT_EQUAL_INT64(5, section.llNumEntries);
+
+    abf2_decode(&abf2_section_record, buf, &section, true);
+    TEST_ASSERT_EQUAL_HEX32(0x03000000, section.uBlockIndex);
+}
+
+void test_decode_packed_fields_of_adcinfo(void)
+{
+    char buf[128];
+    struct abf2_adcinfo adc;
+    float gain = 2.5f;
+    int32_t units = 7;
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf + 6, &gain, 4);      /* fTelegraphAdditGain */
+    buf[64] = 1;                    /* nLowpassFilterType */
+    memcpy(buf + 78, &units, 4);    /* lADCUnitsIndex */
+
+    abf2_decode(&abf2_adcinfo_record, buf, &adc, false);
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, adc.fTelegraphAdditGain);
+    TEST_ASSERT_EQUAL_INT8(1, adc.nLowpassFilterType);
+    TEST_ASSERT_EQUAL_INT32(7, adc.lADCUnitsIndex);
+}
+
+void test_encode_inverts_decode(void)
+{
+    const struct abf2_record *const *r;
+    char in[512], out[512];
+    void *record;
+    int swap;
+    size_t i;
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = (char)(i * 31 + 7);
+    for (r = abf2_records; *r != NULL; r++) {
+        record = malloc((*r)->struct_size);
+        for (swap = 0; swap <= 1; swap++) {
+            memset(out, 0, sizeof(out));
+            abf2_decode(*r, in, record, swap);
+            abf2_encode(*r, record, out, swap);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(in, out, (*r)->file_size, (*r)->name);
+        }
+        free(record);
+    }
+}
+
+void test_decode_fileinfo_swapped(void)
+{
+    char buf[512];
+    struct abf2_fileinfo info;
+    uint32_t signature = ABF2_FILESIGNATURE;
+    uint64_t entries = 12;
+    memset(buf, 0, sizeof(buf));
+    signature = _swap32(signature);
+    entries = _swap64(entries);
+    memcpy(buf, &signature, 4);
+    memcpy(buf + 236 + 8, &entries, 8);     /* DataSection.llNumEntries */
+
+    abf2_decode(&abf2_fileinfo_record, buf, &info, true);
+    TEST_ASSERT_EQUAL_HEX32(ABF2_FILESIGNATURE, info.uFileSignature);
+    TEST_ASSERT_EQUAL_INT64(12, info.DataSection.llNumEntries);
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "unity.h"
+#include "abf2_records.h"
+#include "abf_catalog.h"
+#include "fdstream.h"
+#include "memstream.h"
+#include "stream.h"
+#include "swap.h"
+
+#define TEST_DIR "test_catalog"
+
+struct abf_catalog catalog;
+
+static void write_file(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *fp = fopen(path, "wb");
+    fwrite(data, 1, size, fp);
+    fclose(fp);
+}
+
+/* ABF 2 file with FileInfo in block 0, protocol in block 1 and strings in block 2 */
+static void write_abf2(const char *path, uint32_t episodes, const char *protocol)
+{
+    uint8_t file[4 * ABF2_BLOCKSIZE];
+    struct abf2_fileinfo info;
+    struct abf2_protocolinfo proto;
+    uint8_t *strings = file + 2 * ABF2_BLOCKSIZE;
+    const char *texts[3] = { "Clampex", "", protocol };
+    uint32_t v, total = 0;
+    size_t i, len;
+
+    memset(file, 0, sizeof(file));
+    memset(&info, 0, sizeof(info));
+    memset(&proto, 0, sizeof(proto));
+    memcpy(&info.uFileSignature, "ABF2", 4);
+    info.uFileVersionNumber = 0x02080000;
+    info.uFileInfoSize = ABF2_BLOCKSIZE;
+    info.uActualEpisodes = episodes;
+    info.uFileStartDate = 20240131;
+    info.uFileStartTimeMS = 3723004;
+    info.FileGUID.Data1 = 0x01234567;
+    info.FileGUID.Data4[7] = 0xEF;
+    info.uCreatorNameIndex = 1;
+    info.uProtocolPathIndex = 3;
+    info.ProtocolSection.uBlockIndex = 1;
+    info.ADCSection.llNumEntries = 2;
+    info.StringsSection.uBlockIndex = 2;
+    proto.fADCSequenceInterval = 50.0f;
+    abf2_encode(&abf2_fileinfo_record, &info, (char *)file, false);
+    abf2_encode(&abf2_protocolinfo_record, &proto, (char *)file + ABF2_BLOCKSIZE, false);
+
+    memcpy(strings, "SSCH", 4);
+    v = 3;
+    memcpy(strings + 8, &v, 4);
+    for (i = 0; i < 3; i++) {
+        len = strlen(texts[i]) + 1;
+        memcpy(strings + 44 + total, texts[i], len);
+        total += (uint32_t)len;
+    }
+    memcpy(strings + 16, &total, 4);
+    write_file(path, file, sizeof(file));
+}
+
+static void write_abf1(const char *path)
+{
+    uint8_t file[6144];
+    float f;
+    int32_t l;
+    int16_t n;
+
+    memset(file, 0, sizeof(file));
+    memcpy(file, "ABF ", 4);
+    f = 1.83f;  memcpy(file + 4, &f, 4);
+    l = 7;      memcpy(file + 16, &l, 4);
+    l = 19990102; memcpy(file + 20, &l, 4);
+    l = 60;     memcpy(file + 24, &l, 4);
+    n = 4;      memcpy(file + 120, &n, 2);
+    f = 25.0f;  memcpy(file + 122, &f, 4);
+    n = 5;      memcpy(file + 366, &n, 2);
+    memcpy(file + 4898, "C:\\old.pro   ", 13);
+    write_file(path, file, sizeof(file));
+}
+
+void setUp(void)
+{
+    uint8_t junk[1024];
+    memset(junk, 'x', sizeof(junk));
+
+    mkdir(TEST_DIR, 0777);
+    mkdir(TEST_DIR "/a", 0777);
+    mkdir(TEST_DIR "/a/b", 0777);
+    write_abf2(TEST_DIR "/a/b/cell1.abf", 12, "C:\\protocols\\iv.pro");
+    write_abf2(TEST_DIR "/a/cell2.ABF", 3, "");
+    write_abf1(TEST_DIR "/old.abf");
+    write_file(TEST_DIR "/a/notes.abf", junk, sizeof(junk));
+    write_file(TEST_DIR "/a/readme.txt", junk, sizeof(junk));
+    memset(&catalog, 0, sizeof(catalog));
+}
+
+void tearDown(void)
+{
+    abf_catalog_free(&catalog);
+    remove(TEST_DIR "/a/b/cell1.abf");
+    remove(TEST_DIR "/a/cell2.ABF");
+    remove(TEST_DIR "/old.abf");
+    remove(TEST_DIR "/a/notes.abf");
+    remove(TEST_DIR "/a/readme.txt");
+    rmdir(TEST_DIR "/a/b");
+    rmdir(TEST_DIR "/a");
+    rmdir(TEST_DIR);
+}
+
+void test_inspect_abf2_reads_header_fields(void)
+{
+    struct abf_catalog_entry e;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_inspect(TEST_DIR "/a/b/cell1.abf", &e));
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/a/b/cell1.abf", e.path);
+    TEST_ASSERT_EQUAL_STRING("C:\\protocols\\iv.pro", e.protocol_path);
+    TEST_ASSERT_EQUAL_UINT16(2, e.format);
+    TEST_ASSERT_EQUAL_FLOAT(2.08f, e.file_version);
+    TEST_ASSERT_EQUAL_UINT16(2, e.channels);
+    TEST_ASSERT_EQUAL_UINT32(12, e.episodes);
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, e.sample_interval_us);
+    TEST_ASSERT_EQUAL_UINT32(20240131, e.start_date);
+    TEST_ASSERT_EQUAL_UINT32(3723004, e.start_time_ms);
+    TEST_ASSERT_EQUAL_HEX32(0x01234567, e.guid.Data1);
+    TEST_ASSERT_EQUAL_HEX8(0xEF, e.guid.Data4[7]);
+    abf_catalog_entry_free(&e);
+}
+
+void test_inspect_abf1_reads_header_fields(void)
+{
+    struct abf_catalog_entry e;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_inspect(TEST_DIR "/old.abf", &e));
+    TEST_ASSERT_EQUAL_UINT16(1, e.format);
+    TEST_ASSERT_EQUAL_FLOAT(1.83f, e.file_version);
+    TEST_ASSERT_EQUAL_UINT16(4, e.channels);
+    TEST_ASSERT_EQUAL_UINT32(7, e.episodes);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, e.sample_interval_us);
+    TEST_ASSERT_EQUAL_UINT32(19990102, e.start_date);
+    TEST_ASSERT_EQUAL_UINT32(60005, e.start_time_ms);
+    TEST_ASSERT_EQUAL_STRING("C:\\old.pro", e.protocol_path);
+    abf_catalog_entry_free(&e);
+}
+
+void test_inspect_rejects_other_files(void)
+{
+    struct abf_catalog_entry e;
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, abf_catalog_inspect(TEST_DIR "/a/notes.abf", &e));
+    TEST_ASSERT_NULL(e.path);
+    TEST_ASSERT_NULL(e.protocol_path);
+}
+
+void test_build_finds_abf_files_in_path_order(void)
+{
+    struct abf_catalog_options options = { 4, false };
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_build(TEST_DIR, &options, &catalog));
+    TEST_ASSERT_EQUAL_UINT(3, catalog.count);
+    TEST_ASSERT_EQUAL_UINT(1, catalog.failed);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/a/b/cell1.abf", catalog.entries[0].path);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/a/cell2.ABF", catalog.entries[1].path);
+    TEST_ASSERT_EQUAL_STRING(TEST_DIR "/old.abf", catalog.entries[2].path);
+    TEST_ASSERT_EQUAL_UINT32(3, catalog.entries[1].episodes);
+    TEST_ASSERT_EQUAL_STRING("", catalog.entries[1].protocol_path);
+}
+
+void test_build_all_files_inspects_other_extensions(void)
+{
+    struct abf_catalog_options options = { 1, true };
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_build(TEST_DIR, &options, &catalog));
+    TEST_ASSERT_EQUAL_UINT(3, catalog.count);
+    TEST_ASSERT_EQUAL_UINT(2, catalog.failed);
+}
+
+void test_build_missing_root_is_empty(void)
+{
+    TEST_ASSERT_EQUAL_INT(StreamError_Success,
+                          abf_catalog_build(TEST_DIR "/missing", NULL, &catalog));
+    TEST_ASSERT_EQUAL_UINT(0, catalog.count);
+}
+
+void test_write_and_read_back(void)
+{
+    struct abf_catalog copy;
+    stream_dt *mem;
+    size_t i;
+
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_build(TEST_DIR, NULL, &catalog));
+    memstream_createGrowable(64, &mem);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_write(&catalog, mem));
+    stream_seekToStart(mem);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, abf_catalog_read(mem, &copy));
+    memstream_destroy(mem);
+
+    TEST_ASSERT_EQUAL_UINT(catalog.count, copy.count);
+    for (i = 0; i < copy.count; i++) {
+        TEST_ASSERT_EQUAL_STRING(catalog.entries[i].path, copy.entries[i].path);
+        TEST_ASSERT_EQUAL_STRING(catalog.entries[i].protocol_path, copy.entries[i].protocol_path);
+        TEST_ASSERT_EQUAL_UINT32(catalog.entries[i].episodes, copy.entries[i].episodes);
+        TEST_ASSERT_EQUAL_FLOAT(catalog.entries[i].sample_interval_us, copy.entries[i].sample_interval_us);
+        TEST_ASSERT_EQUAL_MEMORY(&catalog.entries[i].guid, &copy.entries[i].guid, sizeof(struct guid));
+    }
+    abf_catalog_free(&copy);
+}
+
+void test_read_rejects_bad_magic(void)
+{
+    stream_dt *mem;
+    memstream_createGrowable(64, &mem);
+    stream_write(mem, "XXXX\1\0\0\0\0\0\0\0", 12);
+    stream_seekToStart(mem);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, abf_catalog_read(mem, &catalog));
+    memstream_destroy(mem);
+}
@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "adc_convert.h"
+
+#define MAX_SAMPLES 1000
+
+static int16_t samples[MAX_SAMPLES * 16];
+static float out[MAX_SAMPLES];
+
+void setUp(void)
+{
+    size_t i;
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+        samples[i] = (int16_t)(i * 2654435761u >> 16);
+    samples[3] = INT16_MIN;
+    samples[5] = INT16_MAX;
+    memset(out, 0, sizeof(out));
+}
+
+void tearDown(void) {}
+
+/* With a power of two factor and a small shift every result is exact,
+ * with or without fused multiply-add */
+void test_contiguous_matches_scalar_for_all_lengths(void)
+{
+    size_t count, i;
+    for (count = 0; count < 70; count++) {
+        adc_to_float(samples + 1, out, count, 0.25f, 3.0f);
+        for (i = 0; i < count; i++)
+            TEST_ASSERT_EQUAL_FLOAT(samples[1 + i] * 0.25f + 3.0f, out[i]);
+    }
+}
+
+void test_strided_matches_scalar_for_all_channel_counts(void)
+{
+    size_t stride, offset, count, i;
+    for (stride = 1; stride <= 16; stride++) {
+        for (offset = 0; offset < stride; offset++) {
+            for (count = 0; count < 40; count++) {
+                adc_to_float_strided(samples + offset, stride, out, count, -0.5f, 1.0f);
+                for (i = 0; i < count; i++)
+                    TEST_ASSERT_EQUAL_FLOAT(samples[offset + i * stride] * -0.5f + 1.0f, out[i]);
+            }
+        }
+    }
+}
+
+/* Reads must stop at the last sample asked for, which here is the last
+ * sample of the allocation */
+void test_strided_does_not_read_past_last_sample(void)
+{
+    size_t count = 333, stride = 3, i;
+    int16_t *src = malloc(((count - 1) * stride + 1) * sizeof(int16_t));
+    for (i = 0; i < count; i++)
+        src[i * stride] = (int16_t)i;
+    adc_to_float_strided(src, stride, out, count, 1.0f, 0.0f);
+    for (i = 0; i < count; i++)
+        TEST_ASSERT_EQUAL_FLOAT((float)i, out[i]);
+    free(src);
+}
+
+void test_strided_double_matches_scalar_for_all_channel_counts(void)
+{
+    static double dout[MAX_SAMPLES];
+    size_t stride, offset, count, i;
+    for (stride = 1; stride <= 17; stride++) {
+        for (offset = 0; offset < stride; offset++) {
+            for (count = 0; count < 40; count++) {
+                adc_to_double_strided(samples + offset, stride, dout, count, -0.5, 1.0);
+                for (i = 0; i < count; i++)
+                    TEST_ASSERT_TRUE(samples[offset + i * stride] * -0.5 + 1.0 == dout[i]);
+            }
+        }
+    }
+}
+
+void test_strided_double_does_not_read_past_last_sample(void)
+{
+    static double dout[MAX_SAMPLES];
+    size_t count = 333, stride, i;
+    for (stride = 1; stride <= 3; stride++) {
+        int16_t *src = malloc(((count - 1) * stride + 1) * sizeof(int16_t));
+        for (i = 0; i < count; i++)
+            src[i * stride] = (int16_t)i;
+        adc_to_double_strided(src, stride, dout, count, 1.0, 0.0);
+        for (i = 0; i < count; i++)
+            TEST_ASSERT_TRUE((double)i == dout[i]);
+        free(src);
+    }
+}
+
+/* Double precision scaling, unlike the float kernels, is within a
+ * rounding step of the exact result */
+void test_strided_double_is_more_precise_than_float(void)
+{
+    static double dout[MAX_SAMPLES];
+    const double factor = 10.0 / 32768.0 / 3.7, shift = 0.123;
+    double delta;
+    size_t i;
+    adc_to_double_strided(samples, 1, dout, MAX_SAMPLES, factor, shift);
+    for (i = 0; i < MAX_SAMPLES; i++) {
+        delta = dout[i] - (samples[i] * factor + shift);
+        TEST_ASSERT_TRUE(delta < 1e-14 && delta > -1e-14);
+    }
+}
+
+void test_inplace_converts_over_the_samples(void)
+{
+    size_t count, i;
+    float *buffer = malloc(MAX_SAMPLES * sizeof(float));
+    for (count = 0; count < MAX_SAMPLES; count += 37) {
+        memcpy(buffer, samples, count * sizeof(int16_t));
+        adc_to_float_inplace(buffer, count, 2.0f, -7.0f);
+        for (i = 0; i < count; i++)
+            TEST_ASSERT_EQUAL_FLOAT(samples[i] * 2.0f - 7.0f, buffer[i]);
+    }
+    free(buffer);
+}
+
+void test_rounding_is_within_one_step_of_scalar(void)
+{
+    const float factor = 10.0f / 32768.0f / 3.7f, shift = 0.123f;
+    size_t i;
+    adc_to_float(samples, out, MAX_SAMPLES, factor, shift);
+    for (i = 0; i < MAX_SAMPLES; i++)
+        TEST_ASSERT_FLOAT_WITHIN(1e-6f, samples[i] * factor + shift, out[i]);
+}
+
+void test_kernel_is_named(void)
+{
+    TEST_ASSERT_NOT_NULL(adc_convert_kernel());
+}
@@ -0,0 +1,122 @@
+#include "unity.h"
+#include "stream.h"
+#include "memstream.h"
+#include "crcstream.h"
+#include "swap.h"
+
+#include <string.h>
+
+#define INNER_SIZE 1024
+
+stream_dt *inner;
+stream_dt *crcstream;
+uint8_t bytes[INNER_SIZE];
+StreamError err;
+
+void setUp(void)
+{
+    int i;
+    for (i = 0; i < INNER_SIZE; i++)
+        bytes[i] = (uint8_t)(i * 13 + 5);
+    memstream_create(INNER_SIZE, &inner);
+    memstream_fillData((memstream_dt*)inner, bytes, INNER_SIZE);
+
+    err = crcstream_create(inner, &crcstream);
+}
+
+void tearDown(void)
+{
+    crcstream_destroy(crcstream);
+    memstream_destroy(inner);
+}
+
+void test_crc32_check_value(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32_update(0, "123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0, crc32_update(0, "", 0));
+}
+
+void test_crc32_update_is_incremental(void)
+{
+    uint32_t crc = crc32_update(0, bytes, 100);
+    crc = crc32_update(crc, bytes + 100, INNER_SIZE - 100);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, bytes, INNER_SIZE), crc);
+}
+
+void test_crcstream_chunked_reads_match_whole(void)
+{
+    uint8_t chunk[100];
+    size_t left = INNER_SIZE, n;
+    uint32_t crc;
+    streampos_dt end;
+
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    while (left > 0) {
+        n = (left < sizeof(chunk)) ? left : sizeof(chunk);
+        err = stream_read(crcstream, chunk, n);
+        TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+        left -= n;
+    }
+    crcstream_value(crcstream, &crc, &end);
+    TEST_ASSERT_EQUAL_INT(INNER_SIZE, end);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, bytes, INNER_SIZE), crc);
+}
+
+void test_crcstream_reread_does_not_change_crc(void)
+{
+    uint8_t chunk[64];
+    uint32_t crc;
+    stream_read(crcstream, chunk, sizeof(chunk));
+    stream_seekFromStart(crcstream, 16);
+    stream_read(crcstream, chunk, sizeof(chunk));
+    crcstream_value(crcstream, &crc, NULL);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, bytes, 16 + sizeof(chunk)), crc);
+}
+
+void test_crcstream_skipped_read_leaves_run(void)
+{
+    uint8_t chunk[8];
+    streampos_dt end;
+    stream_readAt(crcstream, 100, chunk, sizeof(chunk));
+    crcstream_value(crcstream, NULL, &end);
+    TEST_ASSERT_EQUAL_INT(0, end);
+}
+
+void test_crcstream_mask_checksums_zeros(void)
+{
+    uint8_t copy[INNER_SIZE];
+    uint8_t to[INNER_SIZE];
+    uint32_t crc;
+    memcpy(copy, bytes, INNER_SIZE);
+    memset(copy + 10, 0, 4);
+
+    crcstream_mask(crcstream, 10, 4);
+    stream_read(crcstream, to, 8);
+    stream_read(crcstream, to + 8, INNER_SIZE - 8);
+    TEST_ASSERT_EQUAL_HEX8(bytes[11], to[11]);
+    crcstream_value(crcstream, &crc, NULL);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, copy, INNER_SIZE), crc);
+}
+
+void test_crcstream_write_is_checksummed(void)
+{
+    uint8_t data[5] = { 1, 2, 3, 4, 5 };
+    uint32_t crc;
+    err = stream_write(crcstream, data, sizeof(data));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    crcstream_value(crcstream, &crc, NULL);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, data, sizeof(data)), crc);
+}
+
+void test_crcstream_reset_starts_at_position(void)
+{
+    uint8_t chunk[16];
+    uint32_t crc;
+    streampos_dt end;
+    stream_seekFromStart(crcstream, 32);
+    crcstream_reset(crcstream);
+    stream_read(crcstream, chunk, sizeof(chunk));
+    crcstream_value(crcstream, &crc, &end);
+    TEST_ASSERT_EQUAL_INT(48, end);
+    TEST_ASSERT_EQUAL_HEX32(crc32_update(0, bytes + 32, sizeof(chunk)), crc);
+}
@@ -0,0 +1,159 @@
+#include "unity.h"
+#include "stream.h"
+#include "fdstream.h"
+#include "swap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FILE "test_fdstream.bin"
+#define TEST_FILE_SIZE 64
+
+stream_dt *fdstream;
+StreamError err;
+
+void setUp(void)
+{
+    uint8_t bytes[TEST_FILE_SIZE];
+    int i;
+    FILE *fp;
+    for (i = 0; i < TEST_FILE_SIZE; i++)
+        bytes[i] = (uint8_t)i;
+    fp = fopen(TEST_FILE, "wb");
+    fwrite(bytes, 1, sizeof(bytes), fp);
+    fclose(fp);
+
+    fdstream = NULL;
+    err = fdstream_openForRead(TEST_FILE, &fdstream);
+}
+
+void tearDown(void)
+{
+    if (fdstream != NULL)
+        fdstream_destroy(fdstream);
+    remove(TEST_FILE);
+}
+
+void test_fdstream_open_succeeds(void)
+{
+    streampos_dt length;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_length(fdstream, &length);
+    TEST_ASSERT_EQUAL_INT(TEST_FILE_SIZE, length);
+}
+
+void test_fdstream_open_missing_file_fails(void)
+{
+    stream_dt *missing;
+    err = fdstream_openForRead("no_such_file.abf", &missing);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, err);
+    TEST_ASSERT_NULL(missing);
+}
+
+void test_fdstream_read_advances_pos(void)
+{
+    uint8_t to[4];
+    streampos_dt pos;
+    stream_seekFromStart(fdstream, 20);
+    err = stream_read(fdstream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(20, to[0]);
+    TEST_ASSERT_EQUAL_HEX8(23, to[3]);
+    stream_tell(fdstream, &pos);
+    TEST_ASSERT_EQUAL_INT(24, pos);
+}
+
+void test_fdstream_readAt_does_not_move_pos(void)
+{
+    uint8_t to[8];
+    streampos_dt pos;
+    stream_seekFromStart(fdstream, 5);
+    err = stream_readAt(fdstream, 40, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(40, to[0]);
+    TEST_ASSERT_EQUAL_HEX8(47, to[7]);
+    stream_tell(fdstream, &pos);
+    TEST_ASSERT_EQUAL_INT(5, pos);
+}
+
+void test_fdstream_readAt_past_end_fails(void)
+{
+    uint8_t to[8];
+    err = stream_readAt(fdstream, TEST_FILE_SIZE - 4, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
+
+void test_fdstream_write_on_read_stream_fails(void)
+{
+    uint8_t from = 0xCA;
+    err = stream_write(fdstream, &from, 1);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, err);
+}
+
+void test_fdstream_write_then_read_back(void)
+{
+    uint8_t from[2] = { 0xCA, 0xFE };
+    uint8_t to[2];
+    streampos_dt length;
+    stream_dt *writer;
+
+    fdstream_destroy(fdstream);
+    fdstream = NULL;
+    err = fdstream_openForWrite(TEST_FILE, &writer);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_write(writer, from, sizeof(from));
+    stream_length(writer, &length);
+    TEST_ASSERT_EQUAL_INT(2, length);
+
+    err = stream_readAt(writer, 0, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(0xCA, to[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xFE, to[1]);
+    fdstream_destroy(writer);
+}
+
+void test_fdstream_seekToEnd_on_empty_write_stream(void)
+{
+    stream_dt *writer;
+    streampos_dt pos;
+
+    fdstream_destroy(fdstream);
+    fdstream = NULL;
+    err = fdstream_openForWrite(TEST_FILE, &writer);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    err = stream_seekToEnd(writer);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_tell(writer, &pos);
+    TEST_ASSERT_EQUAL_INT(0, pos);
+    fdstream_destroy(writer);
+}
+
+void test_fdstream_readv_reads_unordered_requests(void)
+{
+    uint8_t a[4], b[2], c[8];
+    struct stream_iovec vec[3] = {
+        { 40, sizeof(c), c },
+        { 0,  sizeof(a), a },
+        { 4,  sizeof(b), b }
+    };
+    err = stream_readv(fdstream, vec, 3);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(0, a[0]);
+    TEST_ASSERT_EQUAL_HEX8(3, a[3]);
+    TEST_ASSERT_EQUAL_HEX8(4, b[0]);
+    TEST_ASSERT_EQUAL_HEX8(5, b[1]);
+    TEST_ASSERT_EQUAL_HEX8(40, c[0]);
+    TEST_ASSERT_EQUAL_HEX8(47, c[7]);
+}
+
+void test_fdstream_readv_out_of_range_reads_nothing(void)
+{
+    uint8_t a[4] = { 0xFF, 0xFF, 0xFF, 0xFF }, b[8];
+    struct stream_iovec vec[2] = {
+        { 0, sizeof(a), a },
+        { TEST_FILE_SIZE - 4, sizeof(b), b }
+    };
+    err = stream_readv(fdstream, vec, 2);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, a[0]);
+}
@@ -0,0 +1,143 @@
+#include "unity.h"
+#include "stream.h"
+#include "mmapstream.h"
+#include "swap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FILE "test_mmapstream.bin"
+#define TEST_FILE_SIZE 64
+
+stream_dt *mmstream;
+StreamError err;
+
+void setUp(void)
+{
+    uint8_t bytes[TEST_FILE_SIZE];
+    int i;
+    FILE *fp;
+    for (i = 0; i < TEST_FILE_SIZE; i++)
+        bytes[i] = (uint8_t)i;
+    fp = fopen(TEST_FILE, "wb");
+    fwrite(bytes, 1, sizeof(bytes), fp);
+    fclose(fp);
+
+    mmstream = NULL;
+    err = mmapstream_open(TEST_FILE, &mmstream);
+}
+
+void tearDown(void)
+{
+    if (mmstream != NULL)
+        mmapstream_destroy(mmstream);
+    remove(TEST_FILE);
+}
+
+void test_mmapstream_open_succeeds(void)
+{
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_NOT_NULL(mmstream);
+}
+
+void test_mmapstream_open_missing_file_fails(void)
+{
+    stream_dt *missing;
+    err = mmapstream_open("no_such_file.abf", &missing);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, err);
+    TEST_ASSERT_NULL(missing);
+}
+
+void test_mmapstream_length_is_file_size(void)
+{
+    streampos_dt length;
+    err = stream_length(mmstream, &length);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_INT(TEST_FILE_SIZE, length);
+}
+
+void test_mmapstream_read_advances_pos(void)
+{
+    uint8_t to[4];
+    streampos_dt pos;
+    stream_seekFromStart(mmstream, 10);
+    err = stream_read(mmstream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(10, to[0]);
+    TEST_ASSERT_EQUAL_HEX8(13, to[3]);
+    stream_tell(mmstream, &pos);
+    TEST_ASSERT_EQUAL_INT(14, pos);
+}
+
+void test_mmapstream_read_whole_file(void)
+{
+    uint8_t to[TEST_FILE_SIZE];
+    err = stream_read(mmstream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(TEST_FILE_SIZE - 1, to[TEST_FILE_SIZE - 1]);
+}
+
+void test_mmapstream_read_past_end_fails(void)
+{
+    uint8_t to[8];
+    stream_seekFromStart(mmstream, TEST_FILE_SIZE - 4);
+    err = stream_read(mmstream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
+
+void test_mmapstream_write_fails(void)
+{
+    uint8_t from = 0xCA;
+    err = stream_write(mmstream, &from, 1);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, err);
+}
+
+void test_mmapstream_seekFromEnd(void)
+{
+    streampos_dt pos;
+    stream_seekFromEnd(mmstream, 10);
+    stream_tell(mmstream, &pos);
+    TEST_ASSERT_EQUAL_INT(TEST_FILE_SIZE - 1 - 10, pos);
+}
+
+void test_mmapstream_seekToEnd_on_empty_file_fails(void)
+{
+    stream_dt *empty;
+    streampos_dt pos;
+    FILE *fp = fopen(TEST_FILE, "wb");
+    fclose(fp);
+
+    err = mmapstream_open(TEST_FILE, &empty);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    err = stream_seekToEnd(empty);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    stream_tell(empty, &pos);
+    TEST_ASSERT_EQUAL_INT(0, pos);
+    mmapstream_destroy(empty);
+}
+
+void test_mmapstream_view_points_into_file(void)
+{
+    const void *ptr;
+    err = stream_view(mmstream, 32, 16, &ptr);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(32, ((const uint8_t*)ptr)[0]);
+    TEST_ASSERT_EQUAL_HEX8(47, ((const uint8_t*)ptr)[15]);
+}
+
+void test_mmapstream_view_does_not_move_pos(void)
+{
+    const void *ptr;
+    streampos_dt pos;
+    stream_view(mmstream, 32, 16, &ptr);
+    stream_tell(mmstream, &pos);
+    TEST_ASSERT_EQUAL_INT(0, pos);
+}
+
+void test_mmapstream_view_out_of_range_fails(void)
+{
+    const void *ptr;
+    err = stream_view(mmstream, TEST_FILE_SIZE - 8, 16, &ptr);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    TEST_ASSERT_NULL(ptr);
+}
@@ -207,3 +207,99 @@ void test_stream_read_uint16_swapped(void)
     else
         TEST_ASSERT_EQUAL_HEX16(0xCAFE, to);
 }
+
+void test_memstream_write_at_position(void)
+{
+    uint8_t bytes[2] = { 0xCA, 0xFE };
+    stream_seekFromStart(test_stream, 10);
+    stream_write(test_stream, bytes, 2);
+    TEST_ASSERT_EQUAL_HEX8(0, memstream_getByteAt(test_stream, 0));
+    TEST_ASSERT_EQUAL_HEX8(0xCA, memstream_getByteAt(test_stream, 10));
+    TEST_ASSERT_EQUAL_HEX8(0xFE, memstream_getByteAt(test_stream, 11));
+}
+
+void test_memstream_write_fills_stream_exactly(void)
+{
+    uint8_t chunk[STREAM_SIZE];
+    memset(chunk, 1, sizeof(chunk));
+    err = stream_write(test_stream, chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    streamPositionIs(STREAM_SIZE);
+}
+
+void test_memstream_growable_write_grows(void)
+{
+    stream_dt *growable;
+    uint8_t chunk[1000];
+    streampos_dt length;
+    int i;
+    memset(chunk, 0xAB, sizeof(chunk));
+    memstream_createGrowable(16, &growable);
+    for (i = 0; i < 10; i++) {
+        err = stream_write(growable, chunk, sizeof(chunk));
+        TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    }
+    stream_length(growable, &length);
+    TEST_ASSERT_EQUAL_INT(10 * sizeof(chunk), length);
+    TEST_ASSERT_EQUAL_HEX8(0xAB, memstream_getByteAt(growable, 9999));
+    memstream_destroy(growable);
+}
+
+void test_memstream_growable_read_back(void)
+{
+    stream_dt *growable;
+    uint32_t to;
+    memstream_createGrowable(0, &growable);
+    stream_write_uint32(growable, 0xCAFEBEEF, false);
+    stream_seekToStart(growable);
+    err = stream_read_uint32(growable, &to, false);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX32(0xCAFEBEEF, to);
+    err = stream_read_uint32(growable, &to, false);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    memstream_destroy(growable);
+}
+
+void test_memstream_growable_fillData_grows(void)
+{
+    stream_dt *growable;
+    uint8_t bytes[5000];
+    streampos_dt length;
+    memset(bytes, 0x5A, sizeof(bytes));
+    memstream_createGrowable(0, &growable);
+    err = memstream_fillData((memstream_dt*)growable, bytes, sizeof(bytes));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_length(growable, &length);
+    TEST_ASSERT_EQUAL_INT(sizeof(bytes), length);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, memstream_getByteAt(growable, sizeof(bytes) - 1));
+    memstream_destroy(growable);
+}
+
+void test_memstream_detach_hands_off_buffer(void)
+{
+    stream_dt *growable;
+    uint8_t bytes[3] = { 1, 2, 3 };
+    void *data;
+    size_t size;
+    memstream_createGrowable(0, &growable);
+    stream_write(growable, bytes, sizeof(bytes));
+    err = memstream_detach(growable, &data, &size);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_INT(3, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(bytes, data, 3);
+    free(data);
+    memstream_destroy(growable);
+}
+
+void test_memstream_writeTo_copies_contents(void)
+{
+    stream_dt *growable;
+    uint8_t bytes[3] = { 7, 8, 9 };
+    memstream_createGrowable(0, &growable);
+    stream_write(growable, bytes, sizeof(bytes));
+    err = memstream_writeTo(growable, test_stream);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(9, memstream_getByteAt(test_stream, 2));
+    streamPositionIs(3);
+    memstream_destroy(growable);
+}
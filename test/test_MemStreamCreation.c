@@ -36,3 +36,11 @@ void test_MemStream_Creation_CreateEnormousStreamReturnsMemoryError(void)
     TEST_ASSERT_EQUAL_INT(err, StreamError_NoMemory);
     TEST_ASSERT_NULL(memstream);
 }
+
+void test_MemStream_Creation_CreateGrowable(void)
+{
+    err = memstream_createGrowable(0, &memstream);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_NOT_NULL(memstream);
+    memstream_destroy(memstream);
+}
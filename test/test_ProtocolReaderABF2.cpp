@@ -0,0 +1,203 @@
+// Needs the Axon file I/O sources (src/ABFFIO, src/AxAbfFio32, src/Common) in the build;
+// define ABF_TEST_AXON when they are added to SRC_DIRS.
+#ifdef ABF_TEST_AXON
+
+#include "CppUTest/TestHarness.h"
+#include "wincpp.hpp"
+#include "AxAbfFio32/abffiles.h"
+#include "AxAbfFio32/filedesc.hpp"
+#include "ABFFIO/ProtocolReaderABF2.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define TEST_FILE "test_protocolreaderabf2.abf"
+
+// Block of each section in the test file
+enum
+{
+    PROTOCOL_BLOCK = 1,
+    ADC_BLOCK,
+    DAC_BLOCK,
+    EPOCHPERDAC_BLOCK,
+    EPOCH_BLOCK,
+    STATS_BLOCK,
+    USERLIST_BLOCK,
+    MATH_BLOCK,
+    DATA_BLOCK,
+    NUM_BLOCKS
+};
+
+template <class T>
+static void put_record(std::vector<char> &file, UINT uBlock, UINT uIndex, const T &record)
+{
+    memcpy(&file[uBlock * ABF_BLOCKSIZE + uIndex * sizeof(T)], &record, sizeof(T));
+}
+
+// Writes an ABF 2 file with two ADC channels and every protocol section filled in.
+static void write_test_file(short nOperationMode)
+{
+    std::vector<char> file(NUM_BLOCKS * ABF_BLOCKSIZE, 0);
+
+    ABF_FileInfo Info;
+    Info.uFileVersionNumber = 0x02000000;
+    Info.uActualEpisodes = 4;
+    Info.ProtocolSection.Set(PROTOCOL_BLOCK, sizeof(ABF_ProtocolInfo), 1);
+    Info.ADCSection.Set(ADC_BLOCK, sizeof(ABF_ADCInfo), 2);
+    Info.DACSection.Set(DAC_BLOCK, sizeof(ABF_DACInfo), 1);
+    Info.EpochPerDACSection.Set(EPOCHPERDAC_BLOCK, sizeof(ABF_EpochInfoPerDAC), 2);
+    Info.EpochSection.Set(EPOCH_BLOCK, sizeof(ABF_EpochInfo), 1);
+    Info.StatsRegionSection.Set(STATS_BLOCK, sizeof(ABF_StatsRegionInfo), 1);
+    Info.UserListSection.Set(USERLIST_BLOCK, sizeof(ABF_UserListInfo), 1);
+    Info.MathSection.Set(MATH_BLOCK, sizeof(ABF_MathInfo), 1);
+    // Fewer samples per episode than the protocol asks for, as in a P/N data file
+    Info.DataSection.Set(DATA_BLOCK, sizeof(short), 4 * 1000);
+    put_record(file, 0, 0, Info);
+
+    ABF_ProtocolInfo Protocol;
+    Protocol.nOperationMode = nOperationMode;
+    Protocol.fADCSequenceInterval = 50.0F;
+    Protocol.lNumSamplesPerEpisode = 2048;
+    Protocol.lNumberOfTrials = 1;
+    Protocol.fADCRange = 10.0F;
+    Protocol.fDACRange = 10.0F;
+    Protocol.lADCResolution = 32768;
+    Protocol.lDACResolution = 32768;
+    Protocol.nStatsEnable = 1;
+    put_record(file, PROTOCOL_BLOCK, 0, Protocol);
+
+    for (short i = 0; i < 2; i++)
+    {
+        ABF_ADCInfo ADC;
+        ADC.nADCNum = i;
+        ADC.nADCPtoLChannelMap = i;
+        ADC.nADCSamplingSeq = i;
+        ADC.bEnabledDuringPN = TRUE;
+        ADC.fADCProgrammableGain = 1.0F;
+        ADC.fInstrumentScaleFactor = 1.0F;
+        ADC.fSignalGain = 1.0F;
+        put_record(file, ADC_BLOCK, i, ADC);
+    }
+
+    ABF_DACInfo DAC;
+    DAC.nWaveformEnable = 1;
+    DAC.fDACScaleFactor = 1.0F;
+    DAC.nLeakSubtractType = 1;
+    DAC.nPNNumPulses = 4;
+    DAC.nPNNumADCChannels = 1;
+    DAC.fPNHoldingLevel = -80.0F;
+    put_record(file, DAC_BLOCK, 0, DAC);
+
+    for (short i = 0; i < 2; i++)
+    {
+        ABF_EpochInfoPerDAC Epoch;
+        Epoch.nEpochNum = i;
+        Epoch.nEpochType = 1;
+        Epoch.fEpochInitLevel = -10.0F * (i + 1);
+        Epoch.lEpochInitDuration = 100;
+        put_record(file, EPOCHPERDAC_BLOCK, i, Epoch);
+    }
+
+    ABF_EpochInfo DigitalEpoch;
+    DigitalEpoch.nEpochNum = 0;
+    put_record(file, EPOCH_BLOCK, 0, DigitalEpoch);
+
+    ABF_StatsRegionInfo Stats;
+    Stats.lStatsBaselineStart = 10;
+    Stats.lStatsBaselineEnd = 90;
+    Stats.lStatsStart = 100;
+    Stats.lStatsEnd = 600;
+    put_record(file, STATS_BLOCK, 0, Stats);
+
+    ABF_UserListInfo UserList;
+    UserList.nULEnable = 1;
+    UserList.nULParamToVary = 2;
+    put_record(file, USERLIST_BLOCK, 0, UserList);
+
+    ABF_MathInfo Math;
+    Math.nMathEnable = 1;
+    Math.nMathADCNum[1] = 1;
+    Math.fMathK[0] = 2.0F;
+    put_record(file, MATH_BLOCK, 0, Math);
+
+    FILE *fp = fopen(TEST_FILE, "wb");
+    fwrite(&file[0], 1, file.size(), fp);
+    fclose(fp);
+}
+
+TEST_GROUP(ProtocolReaderABF2)
+{
+    CFileDescriptor *pFI;
+
+    void setup()
+    {
+        pFI = NULL;
+    }
+
+    void teardown()
+    {
+        delete pFI;
+        remove(TEST_FILE);
+    }
+
+    void open(short nOperationMode)
+    {
+        write_test_file(nOperationMode);
+        pFI = new CFileDescriptor;
+        CHECK(pFI->Open(TEST_FILE, TRUE));
+    }
+
+    // A lazy read followed by EnsureLoaded(SECTIONS_ALL) must give the eager header.
+    void check_lazy_matches_eager(UINT fFlags)
+    {
+        ABFFileHeader EagerFH;
+        CABF2ProtocolReader Eager(pFI, &EagerFH);
+        CHECK(Eager.Read(fFlags));
+
+        ABFFileHeader LazyFH;
+        CABF2ProtocolReader Lazy(pFI, &LazyFH);
+        CHECK(Lazy.Read(fFlags | ABF_LAZYHEADER));
+        CHECK(Lazy.EnsureLoaded(CABF2ProtocolReader::SECTIONS_ALL));
+
+        CHECK(memcmp(&EagerFH, &LazyFH, sizeof(ABFFileHeader)) == 0);
+    }
+};
+
+TEST(ProtocolReaderABF2, lazy_read_loads_only_sampling_sections)
+{
+    open(ABF_GAPFREEFILE);
+    ABFFileHeader FH;
+    CABF2ProtocolReader Reader(pFI, &FH);
+    CHECK(Reader.Read(ABF_LAZYHEADER));
+
+    CHECK(Reader.IsLoaded(CABF2ProtocolReader::SECTIONS_SAMPLING));
+    CHECK(!Reader.IsLoaded(CABF2ProtocolReader::SECTION_STATS));
+    LONGS_EQUAL(0, FH.lStatsEnd[0]);
+
+    CHECK(Reader.EnsureLoaded(CABF2ProtocolReader::SECTION_STATS));
+    CHECK(Reader.IsLoaded(CABF2ProtocolReader::SECTION_STATS));
+    LONGS_EQUAL(600, FH.lStatsEnd[0]);
+}
+
+TEST(ProtocolReaderABF2, lazy_gapfree_header_matches_eager)
+{
+    open(ABF_GAPFREEFILE);
+    check_lazy_matches_eager(ABF_DATAFILE);
+}
+
+TEST(ProtocolReaderABF2, lazy_episodic_header_matches_eager)
+{
+    open(ABF_WAVEFORMFILE);
+    check_lazy_matches_eager(ABF_DATAFILE);
+}
+
+// Read as a protocol, the P/N channel of an episodic two-channel file is stripped and the
+// stats regions are rescaled; deferred stats must be rescaled the same way.
+TEST(ProtocolReaderABF2, lazy_episodic_protocol_header_matches_eager)
+{
+    open(ABF_WAVEFORMFILE);
+    check_lazy_matches_eager(ABF_PARAMFILE);
+}
+
+#endif   // ABF_TEST_AXON
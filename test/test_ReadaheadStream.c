@@ -0,0 +1,98 @@
+#include "unity.h"
+#include "stream.h"
+#include "memstream.h"
+#include "readaheadstream.h"
+#include "swap.h"
+
+#include <string.h>
+
+#define INNER_SIZE 4096
+#define WINDOW 256
+#define DEPTH 3
+
+stream_dt *inner;
+stream_dt *rastream;
+StreamError err;
+
+void setUp(void)
+{
+    uint8_t bytes[INNER_SIZE];
+    int i;
+    for (i = 0; i < INNER_SIZE; i++)
+        bytes[i] = (uint8_t)(i * 7);
+    memstream_create(INNER_SIZE, &inner);
+    memstream_fillData((memstream_dt*)inner, bytes, INNER_SIZE - 1);
+
+    err = readaheadstream_create(inner, WINDOW, DEPTH, &rastream);
+}
+
+void tearDown(void)
+{
+    if (rastream != NULL)
+        readaheadstream_destroy(rastream);
+    memstream_destroy(inner);
+}
+
+void test_readaheadstream_create_succeeds(void)
+{
+    streampos_dt length;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_length(rastream, &length);
+    TEST_ASSERT_EQUAL_INT(INNER_SIZE, length);
+}
+
+void test_readaheadstream_sequential_reads_match_inner(void)
+{
+    uint8_t chunk[100];
+    streampos_dt pos = 0;
+    int i;
+    while (pos + sizeof(chunk) < INNER_SIZE) {
+        err = stream_read(rastream, chunk, sizeof(chunk));
+        TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+        for (i = 0; i < (int)sizeof(chunk); i++)
+            TEST_ASSERT_EQUAL_HEX8((uint8_t)((pos + i) * 7), chunk[i]);
+        pos += sizeof(chunk);
+    }
+    stream_tell(rastream, &pos);
+    TEST_ASSERT_EQUAL_INT((INNER_SIZE - 1) / 100 * 100, pos);
+}
+
+void test_readaheadstream_random_reads_match_inner(void)
+{
+    static const streampos_dt offsets[] = { 3000, 10, 2047, 512, 3900, 0 };
+    uint8_t chunk[64];
+    size_t i, j;
+    for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        err = stream_readAt(rastream, offsets[i], chunk, sizeof(chunk));
+        TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+        for (j = 0; j < sizeof(chunk); j++)
+            TEST_ASSERT_EQUAL_HEX8((uint8_t)((offsets[i] + j) * 7), chunk[j]);
+    }
+}
+
+void test_readaheadstream_read_spanning_windows(void)
+{
+    uint8_t chunk[3 * WINDOW];
+    size_t i;
+    stream_read(rastream, chunk, 10);
+    stream_read(rastream, chunk, 10);
+    err = stream_read(rastream, chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    for (i = 0; i < sizeof(chunk); i++)
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)((20 + i) * 7), chunk[i]);
+}
+
+void test_readaheadstream_read_past_end_fails(void)
+{
+    uint8_t chunk[16];
+    stream_seekFromStart(rastream, INNER_SIZE - 8);
+    err = stream_read(rastream, chunk, sizeof(chunk));
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
+
+void test_readaheadstream_write_fails(void)
+{
+    uint8_t from = 0xCA;
+    err = stream_write(rastream, &from, 1);
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, err);
+}
@@ -0,0 +1,146 @@
+#include "unity.h"
+#include "stream.h"
+#include "memstream.h"
+#include "statstream.h"
+#include "swap.h"
+
+#include <string.h>
+
+#define INNER_SIZE 256
+
+stream_dt *inner;
+stream_dt *ststream;
+struct stream_stats stats;
+StreamError err;
+
+void setUp(void)
+{
+    uint8_t bytes[INNER_SIZE];
+    int i;
+    for (i = 0; i < INNER_SIZE; i++)
+        bytes[i] = (uint8_t)i;
+    memstream_create(INNER_SIZE, &inner);
+    memstream_fillData((memstream_dt*)inner, bytes, INNER_SIZE - 1);
+
+    err = statstream_create(inner, &ststream);
+}
+
+void tearDown(void)
+{
+    statstream_destroy(ststream);
+    memstream_destroy(inner);
+}
+
+void test_statstream_create_starts_at_zero(void)
+{
+    int op;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.bytes_read);
+    for (op = 0; op < StatOp_Count; op++)
+        TEST_ASSERT_EQUAL_UINT64(0, stats.ops[op]);
+}
+
+void test_statstream_read_passes_through_and_counts(void)
+{
+    uint8_t to[10];
+    err = stream_read(ststream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(9, to[9]);
+    stream_read(ststream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_HEX8(19, to[9]);
+
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.ops[StatOp_Read]);
+    TEST_ASSERT_EQUAL_UINT64(20, stats.bytes_read);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.errors[StatOp_Read]);
+}
+
+void test_statstream_failed_read_counts_error_not_bytes(void)
+{
+    uint8_t to[INNER_SIZE + 1];
+    err = stream_read(ststream, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.errors[StatOp_Read]);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.bytes_read);
+}
+
+void test_statstream_seek_records_distance(void)
+{
+    streampos_dt pos;
+    stream_seekFromStart(ststream, 100);
+    stream_seekFromStart(ststream, 40);
+    stream_tell(ststream, &pos);
+    TEST_ASSERT_EQUAL_INT(40, pos);
+
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.ops[StatOp_Seek]);
+    TEST_ASSERT_EQUAL_UINT64(160, stats.seek_distance);
+}
+
+void test_statstream_write_counts_bytes(void)
+{
+    uint8_t bytes[4] = { 1, 2, 3, 4 };
+    stream_write(ststream, bytes, sizeof(bytes));
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.ops[StatOp_Write]);
+    TEST_ASSERT_EQUAL_UINT64(4, stats.bytes_written);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.bytes_read);
+}
+
+void test_statstream_readv_and_view_count_bytes(void)
+{
+    uint8_t a[4], b[8];
+    const void *ptr;
+    struct stream_iovec vec[2] = {
+        { 10, sizeof(a), a },
+        { 50, sizeof(b), b }
+    };
+    err = stream_readv(ststream, vec, 2);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(50, b[0]);
+    err = stream_view(ststream, 0, 16, &ptr);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.ops[StatOp_ReadV]);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.ops[StatOp_View]);
+    TEST_ASSERT_EQUAL_UINT64(12 + 16, stats.bytes_read);
+}
+
+void test_statstream_histogram_totals_match_ops(void)
+{
+    uint8_t to;
+    uint64_t total = 0;
+    int i;
+    for (i = 0; i < 50; i++)
+        stream_readAt(ststream, i, &to, 1);
+    statstream_getStats(ststream, &stats);
+    for (i = 0; i < STATSTREAM_BUCKETS; i++)
+        total += stats.latency[StatOp_ReadAt][i];
+    TEST_ASSERT_EQUAL_UINT64(50, total);
+    TEST_ASSERT_TRUE(stream_stats_percentile(&stats, StatOp_ReadAt, 0.5)
+                     <= stream_stats_percentile(&stats, StatOp_ReadAt, 1.0));
+    TEST_ASSERT_EQUAL_UINT64(0, stream_stats_percentile(&stats, StatOp_Write, 0.5));
+}
+
+void test_statstream_percentile_picks_bucket(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.ops[StatOp_Read] = 4;
+    stats.latency[StatOp_Read][3] = 3;
+    stats.latency[StatOp_Read][10] = 1;
+    TEST_ASSERT_EQUAL_UINT64(8, stream_stats_percentile(&stats, StatOp_Read, 0.5));
+    TEST_ASSERT_EQUAL_UINT64(1024, stream_stats_percentile(&stats, StatOp_Read, 0.99));
+}
+
+void test_statstream_reset_clears_counters(void)
+{
+    uint8_t to[4];
+    stream_read(ststream, to, sizeof(to));
+    statstream_reset(ststream);
+    statstream_getStats(ststream, &stats);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.ops[StatOp_Read]);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.bytes_read);
+}
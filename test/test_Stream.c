@@ -5,6 +5,8 @@
 #include "streamtest_utils.h"
 #include "swap.h"
 
+#include <string.h>
+
 void setUp(void)
 {
     memstream_create(STREAM_SIZE, &test_stream);
@@ -606,3 +608,60 @@ void test_stream_read_int64_gets_swapped_value(void)
         TEST_ASSERT_EQUAL_HEX64(0x0706050403020100, result);
     }
 }
+
+void test_stream_read_int16n_gets_expected_values(void)
+{
+    int16_t values[20], result[20];
+    int i;
+    for (i = 0; i < 20; i++)
+        values[i] = (int16_t)(i * 1000 - 7000);
+    memstream_fillData((memstream_dt*)test_stream, (uint8_t*)values, sizeof(values));
+
+    err = stream_read_int16n(test_stream, result, 20, false);
+    if (StreamError_Success != err)
+        TEST_FAIL_MESSAGE("Stream error: read_int16n failed");
+    TEST_ASSERT_EQUAL_INT16_ARRAY(values, result, 20);
+    streamPositionIs(sizeof(values));
+}
+
+void test_stream_read_int16n_gets_swapped_values(void)
+{
+    int16_t values[20], result[20];
+    int i;
+    for (i = 0; i < 20; i++)
+        values[i] = (int16_t)_swap16(i * 1000 - 7000);
+    memstream_fillData((memstream_dt*)test_stream, (uint8_t*)values, sizeof(values));
+
+    err = stream_read_int16n(test_stream, result, 20, true);
+    if (StreamError_Success != err)
+        TEST_FAIL_MESSAGE("Stream error: read_int16n failed");
+    for (i = 0; i < 20; i++)
+        TEST_ASSERT_EQUAL_INT16(i * 1000 - 7000, result[i]);
+}
+
+void test_stream_read_floatn_gets_swapped_values(void)
+{
+    float values[9], result[9];
+    uint32_t bits;
+    int i;
+    for (i = 0; i < 9; i++) {
+        float f = 0.25f * i;
+        memcpy(&bits, &f, sizeof(bits));
+        bits = _swap32(bits);
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+    memstream_fillData((memstream_dt*)test_stream, (uint8_t*)values, sizeof(values));
+
+    err = stream_read_floatn(test_stream, result, 9, true);
+    if (StreamError_Success != err)
+        TEST_FAIL_MESSAGE("Stream error: read_floatn failed");
+    for (i = 0; i < 9; i++)
+        TEST_ASSERT_EQUAL_FLOAT(0.25f * i, result[i]);
+}
+
+void test_stream_read_doublen_too_large_fails(void)
+{
+    double result[STREAM_SIZE / sizeof(double) + 1];
+    err = stream_read_doublen(test_stream, result, STREAM_SIZE / sizeof(double) + 1, false);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
@@ -0,0 +1,60 @@
+#include "CppUTest/TestHarness.h"
+#include "ABFFIO/ProtocolLayout.hpp"
+
+#include <string.h>
+
+TEST_GROUP(StructLayout)
+{
+    char buf[512];
+    char out[512];
+
+    void setup()
+    {
+         for (int i = 0; i < 512; i++)
+            buf[i] = char(i * 31 + 7);
+         memset(out, 0, sizeof(out));
+    }
+};
+
+TEST(StructLayout, record_sizes_match_packed_structs)
+{
+    LONGS_EQUAL(16, ABFLayoutOf<ABF_Section>::packed_size);
+    LONGS_EQUAL(512, ABFLayoutOf<ABF_FileInfo>::packed_size);
+    LONGS_EQUAL(512, ABFLayoutOf<ABF_ProtocolInfo>::packed_size);
+    LONGS_EQUAL(128, ABFLayoutOf<ABF_ADCInfo>::packed_size);
+    LONGS_EQUAL(256, ABFLayoutOf<ABF_DACInfo>::packed_size);
+}
+
+TEST(StructLayout, decode_without_swap_copies_packed_bytes)
+{
+    ABF_ProtocolInfo info;
+    ABFLayoutOf<ABF_ProtocolInfo>::Decode(buf, info, false);
+    CHECK(memcmp(&info, buf, sizeof(info)) == 0);
+}
+
+TEST(StructLayout, decode_swaps_each_field)
+{
+    ABF_Section section;
+    uint32_t uBlockIndex;
+    ABFLayoutOf<ABF_Section>::Decode(buf, section, true);
+    memcpy(&uBlockIndex, buf, 4);
+    LONGS_EQUAL(uBlockIndex, (section.uBlockIndex >> 24) | ((section.uBlockIndex >> 8) & 0xFF00)
+                                | ((section.uBlockIndex << 8) & 0xFF0000) | (section.uBlockIndex << 24));
+    BYTES_EQUAL(buf[8], ((char *)&section.llNumEntries)[7]);
+}
+
+TEST(StructLayout, encode_inverts_swapped_decode)
+{
+    ABF_FileInfo info;
+    ABFLayoutOf<ABF_FileInfo>::Decode(buf, info, true);
+    ABFLayoutOf<ABF_FileInfo>::Encode(info, out, true);
+    CHECK(memcmp(buf, out, 512) == 0);
+}
+
+TEST(StructLayout, swapped_guid_keeps_byte_array)
+{
+    ABF_FileInfo info;
+    ABFLayoutOf<ABF_FileInfo>::Decode(buf, info, true);
+    CHECK(memcmp(info.FileGUID.Data4, buf + 48, 8) == 0);
+    BYTES_EQUAL(buf[40], ((char *)&info.FileGUID.Data1)[3]);
+}
@@ -0,0 +1,131 @@
+#include "unity.h"
+#include "stream.h"
+#include "memstream.h"
+#include "substream.h"
+#include "swap.h"
+
+#include <string.h>
+
+#define PARENT_SIZE 256
+#define WINDOW_OFFSET 64
+#define WINDOW_LENGTH 32
+
+stream_dt *parent;
+stream_dt *window;
+StreamError err;
+
+void setUp(void)
+{
+    uint8_t bytes[PARENT_SIZE];
+    int i;
+    for (i = 0; i < PARENT_SIZE; i++)
+        bytes[i] = (uint8_t)i;
+    memstream_create(PARENT_SIZE, &parent);
+    memstream_fillData((memstream_dt*)parent, bytes, PARENT_SIZE - 1);
+
+    err = substream_create(parent, WINDOW_OFFSET, WINDOW_LENGTH, &window);
+}
+
+void tearDown(void)
+{
+    if (window != NULL)
+        substream_destroy(window);
+    memstream_destroy(parent);
+}
+
+void test_substream_create_succeeds(void)
+{
+    streampos_dt length, pos;
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_length(window, &length);
+    stream_tell(window, &pos);
+    TEST_ASSERT_EQUAL_INT(WINDOW_LENGTH, length);
+    TEST_ASSERT_EQUAL_INT(0, pos);
+}
+
+void test_substream_create_rejects_window_past_parent(void)
+{
+    stream_dt *bad;
+    err = substream_create(parent, PARENT_SIZE - 8, 16, &bad);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    TEST_ASSERT_NULL(bad);
+}
+
+void test_substream_read_is_zero_based(void)
+{
+    uint8_t to[4];
+    err = stream_read(window, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(WINDOW_OFFSET, to[0]);
+    TEST_ASSERT_EQUAL_HEX8(WINDOW_OFFSET + 3, to[3]);
+}
+
+void test_substream_read_does_not_move_parent(void)
+{
+    uint8_t to[4];
+    streampos_dt pos;
+    stream_seekFromStart(parent, 10);
+    stream_read(window, to, sizeof(to));
+    stream_tell(parent, &pos);
+    TEST_ASSERT_EQUAL_INT(10, pos);
+}
+
+void test_substream_read_past_window_fails(void)
+{
+    uint8_t to[WINDOW_LENGTH + 1];
+    err = stream_read(window, to, sizeof(to));
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+    err = stream_read(window, to, WINDOW_LENGTH);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+}
+
+void test_substream_fits_enforce_window(void)
+{
+    TEST_ASSERT_TRUE(stream_posfits(window, WINDOW_LENGTH - 1));
+    TEST_ASSERT_FALSE(stream_posfits(window, WINDOW_LENGTH));
+    TEST_ASSERT_TRUE(stream_sizefits(window, WINDOW_LENGTH));
+    TEST_ASSERT_FALSE(stream_sizefits(window, WINDOW_LENGTH + 1));
+    err = stream_seekFromStart(window, WINDOW_LENGTH);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
+
+void test_substream_view_points_into_parent(void)
+{
+    const void *ptr, *parent_ptr;
+    err = stream_view(window, 2, 8, &ptr);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_view(parent, WINDOW_OFFSET + 2, 8, &parent_ptr);
+    TEST_ASSERT_EQUAL_PTR(parent_ptr, ptr);
+    err = stream_view(window, 30, 8, &ptr);
+    TEST_ASSERT_EQUAL_INT(StreamError_NoSpace, err);
+}
+
+void test_substream_readv_translates_offsets(void)
+{
+    uint8_t a[2], b[2];
+    struct stream_iovec vec[2] = {
+        { 0, sizeof(a), a },
+        { 20, sizeof(b), b }
+    };
+    err = stream_readv(window, vec, 2);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    TEST_ASSERT_EQUAL_HEX8(WINDOW_OFFSET, a[0]);
+    TEST_ASSERT_EQUAL_HEX8(WINDOW_OFFSET + 21, b[1]);
+}
+
+void test_substream_nested_window(void)
+{
+    stream_dt *inner;
+    uint8_t to;
+    err = substream_create(window, 8, 8, &inner);
+    TEST_ASSERT_EQUAL_INT(StreamError_Success, err);
+    stream_read(inner, &to, 1);
+    TEST_ASSERT_EQUAL_HEX8(WINDOW_OFFSET + 8, to);
+    substream_destroy(inner);
+}
+
+void test_substream_write_fails(void)
+{
+    uint8_t byte = 0;
+    TEST_ASSERT_EQUAL_INT(StreamError_Failure, stream_write(window, &byte, 1));
+}
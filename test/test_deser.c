@@ -176,6 +176,39 @@ void test_read_int64_gets_swapped_int64(void)
     }
 }
 
+void test_read_uint16_reads_at_offset(void)
+{
+    char buf[4] = { 0x00, 0xCA, 0xFE, 0x00 };
+    uint16_t result = read_uint16(buf, 1, 1);
+    if (ENDIAN_LITTLE == get_endian()) {
+        TEST_ASSERT_EQUAL_HEX16(0xCAFE, result);
+    } else {
+        TEST_ASSERT_EQUAL_HEX16(0xFECA, result);
+    }
+}
+
+void test_read_uint32_reads_at_offset(void)
+{
+    char buf[7] = { 0x00, 0x00, 0x00, 0xCA, 0xFE, 0xBE, 0xEF };
+    uint32_t result = read_uint32(buf, 3, 0);
+    if (ENDIAN_LITTLE == get_endian()) {
+        TEST_ASSERT_EQUAL_HEX32(0xEFBEFECA, result);
+    } else {
+        TEST_ASSERT_EQUAL_HEX32(0xCAFEBEEF, result);
+    }
+}
+
+void test_read_int64_reads_at_offset(void)
+{
+    char buf[10] = { 0x00, 0x00, 0xCA, 0xFE, 0xBE, 0xEF, 0xBA, 0xAD, 0xCA, 0xAF };
+    int64_t result = read_int64(buf, 2, 0);
+    if (ENDIAN_LITTLE == get_endian()) {
+        TEST_ASSERT_EQUAL_HEX64(0xAFCAADBAEFBEFECA, result);
+    } else {
+        TEST_ASSERT_EQUAL_HEX64(0xCAFEBEEFBAADCAAF, result);
+    }
+}
+
 void test_read_float32_get_float(void)
 {
     char buf[4] = { 0x3F, 0xE6, 0xA6, 0x66 };